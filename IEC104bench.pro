@@ -0,0 +1,42 @@
+# -------------------------------------------------
+# QTester104bench: microbenchmarks of the decoder, the log and the I104M
+# encoder. Build it in its own (shadow) build directory, in release mode.
+# -------------------------------------------------
+QT = core network
+CONFIG += console release
+CONFIG -= app_bundle
+TARGET = QTester104bench
+TEMPLATE = app
+CONFIG += c++17
+SOURCES += bench104.cpp \
+    iec104_class.cpp \
+    iec104_framer.cpp \
+    iec104_stats.cpp \
+    iec104_time.cpp \
+    iec104_timerwheel.cpp \
+    iec104_gi.cpp \
+    iec104_capture.cpp \
+    iec104_mapfile.cpp \
+    iec104_pointcache.cpp \
+    iec104_deadband.cpp \
+    iec104_cmdtrack.cpp \
+    iec104_soe.cpp \
+    iec104_gen.cpp \
+    logmsg.cpp \
+    i104m.cpp
+HEADERS += iec104_types.h \
+    iec104_class.h \
+    iec104_framer.h \
+    iec104_stats.h \
+    iec104_time.h \
+    iec104_timerwheel.h \
+    iec104_gi.h \
+    iec104_capture.h \
+    iec104_mapfile.h \
+    iec104_pointcache.h \
+    iec104_deadband.h \
+    iec104_cmdtrack.h \
+    iec104_soe.h \
+    iec104_gen.h \
+    logmsg.h \
+    i104m.h
@@ -0,0 +1,48 @@
+# -------------------------------------------------
+# QTester104d: headless build (QtCore + QtNetwork only) of the concentrator,
+# for running as a service. Build it in its own (shadow) build directory.
+# -------------------------------------------------
+QT = core network
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = QTester104d
+TEMPLATE = app
+CONFIG += c++17
+SOURCES += daemon.cpp \
+    iec104_class.cpp \
+    iec104_framer.cpp \
+    iec104_stats.cpp \
+    iec104_time.cpp \
+    iec104_timerwheel.cpp \
+    iec104_gi.cpp \
+    iec104_capture.cpp \
+    iec104_mapfile.cpp \
+    iec104_pointcache.cpp \
+    iec104_deadband.cpp \
+    iec104_cmdtrack.cpp \
+    iec104_soe.cpp \
+    logmsg.cpp \
+    qiec104.cpp \
+    i104m.cpp \
+    concentrator.cpp \
+    statsexport.cpp
+HEADERS += iec104_types.h \
+    iec104_class.h \
+    iec104_framer.h \
+    iec104_stats.h \
+    iec104_time.h \
+    iec104_timerwheel.h \
+    iec104_gi.h \
+    iec104_capture.h \
+    iec104_mapfile.h \
+    iec104_pointcache.h \
+    iec104_deadband.h \
+    iec104_cmdtrack.h \
+    iec104_soe.h \
+    logmsg.h \
+    qiec104.h \
+    i104m.h \
+    concentrator.h \
+    statsexport.h
+OTHER_FILES += \
+    qtester104.ini
@@ -0,0 +1,22 @@
+# -------------------------------------------------
+# QTester104sim: IEC 104 slave simulator / load generator (QtCore + QtNetwork),
+# for benchmarking the master. Build it in its own (shadow) build directory.
+# -------------------------------------------------
+QT = core network
+CONFIG += console
+CONFIG -= app_bundle
+TARGET = QTester104sim
+TEMPLATE = app
+CONFIG += c++17
+SOURCES += sim104.cpp \
+    simulator.cpp \
+    iec104_framer.cpp \
+    iec104_gen.cpp \
+    iec104_time.cpp
+HEADERS += iec104_types.h \
+    iec104_framer.h \
+    iec104_gen.h \
+    iec104_time.h \
+    simulator.h
+OTHER_FILES += \
+    qtester104.ini
@@ -0,0 +1,302 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+
+// QTester104bench: microbenchmarks of the receive path (framer, decoder),
+// the log ring and the I104M encoder, in ns per object/message.
+// usage: QTester104bench [raw apdu stream file] [min ms per case]
+// The stream file has the bytes received from an RTU (all frames, as on the
+// wire) or is a binary capture ([CAPTURE] RECORD, its received frames are
+// used), it is benchmarked after the generated corpus of each TI.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "iec104_class.h"
+#include "iec104_gen.h"
+#include "i104m.h"
+
+namespace {
+
+long minNs = 200 * 1000000L; // minimum time of each case
+
+// runs f (that processes units objects) until minNs, returns ns per unit
+template <class F> double measure(F f, uint64_t units) {
+  using namespace std::chrono;
+  uint64_t reps = 0;
+  steady_clock::time_point start = steady_clock::now();
+  long elapsed;
+  do {
+    f();
+    reps++;
+    elapsed = long(duration_cast<nanoseconds>(steady_clock::now() - start).count());
+  } while (elapsed < minNs);
+  return double(elapsed) / double(reps * units);
+}
+
+// master with the tcp hooks on memory: readTCP from a byte stream, sendTCP discarded
+class BenchIec104 : public iec104_class {
+public:
+  const char *rxData = nullptr;
+  int rxSize = 0;
+  int rxPos = 0;
+  int segment = 1460; // bytes per readTCP, as a tcp segment
+  uint64_t points = 0;
+  std::vector<iec_obj> *capture = nullptr; // copy of the decoded points
+
+  void parse(iec_apdu *apdu, int sz) { parseAPDU(apdu, sz, false); }
+  void feed(const std::vector<char> &stream) {
+    rxData = stream.data();
+    rxSize = int(stream.size());
+    rxPos = 0;
+    onConnectTCP(); // sequence numbers from 0
+    while (rxPos < rxSize)
+      packetReadyTCP();
+  }
+  void drainLog() {
+    std::string s;
+    while (mLog.pullMsg(s))
+      ;
+  }
+
+protected:
+  void connectTCP() {}
+  void disconnectTCP() {}
+  int readTCP(char *buf, int szmax) {
+    int n = rxSize - rxPos;
+    if (n > szmax)
+      n = szmax;
+    if (n > segment)
+      n = segment;
+    memcpy(buf, rxData + rxPos, size_t(n));
+    rxPos += n;
+    return n;
+  }
+  void sendTCP(char *, int) {}
+  int bytesAvailableTCP() { return rxSize - rxPos < segment ? rxSize - rxPos : segment; }
+  void dataIndication(iec_obj *obj, unsigned numpoints) {
+    points += numpoints;
+    if (capture != nullptr)
+      capture->insert(capture->end(), obj, obj + numpoints);
+  }
+};
+
+enum LogMode { LogOff, LogPushed, LogPulled };
+const char *logModeStr[] = {"log off", "log on", "log on+pulled"};
+
+void setLog(BenchIec104 &m, LogMode mode) {
+  if (mode == LogOff) {
+    m.mLog.deactivateLog();
+  } else {
+    m.mLog.activateLog();
+    m.mLog.setPolicy(TLogMsg::OverwriteOldest);
+  }
+}
+
+// I-frame with the generated points, cause spontaneous
+int makeAPDU(iec_apdu &apdu, unsigned ti, bool sq, uint16_t ns) {
+  memset(&apdu, 0, sizeof(apdu));
+  apdu.start = iec104_class::START;
+  apdu.NS = ns;
+  apdu.NR = 0;
+  iec104_genASDU(apdu, ti, sq, ti * 100000 + 1, 127, ns);
+  apdu.asduh.cause = iec104_class::SPONTANEOUS;
+  apdu.asduh.ca = 1;
+  return apdu.length + 2;
+}
+
+// decoder: one apdu parsed again and again, out of the handshake
+void benchParse(unsigned ti, bool sq, LogMode mode) {
+  BenchIec104 m;
+  iec_apdu apdu;
+  int sz = makeAPDU(apdu, ti, sq, 0);
+  setLog(m, mode);
+  double ns = measure([&] {
+    m.parse(&apdu, sz);
+    if (mode == LogPulled)
+      m.drainLog();
+  }, apdu.asduh.num);
+  printf("parseAPDU       TI %3u SQ=%d %-14s %4u obj/asdu %9.1f ns/obj\n", ti, sq,
+         logModeStr[mode], unsigned(apdu.asduh.num), ns);
+}
+
+// framer + decoder + acknowledges: a stream of apdus through packetReadyTCP
+void benchStream(const char *name, const std::vector<char> &stream, LogMode mode) {
+  BenchIec104 m;
+  setLog(m, mode);
+  m.feed(stream);
+  uint64_t objs = m.points;
+  if (objs == 0)
+    objs = 1;
+  double ns = measure([&] {
+    m.feed(stream);
+    if (mode == LogPulled)
+      m.drainLog();
+  }, objs);
+  printf("packetReadyTCP  %-16s %-14s %8zu bytes %9.1f ns/obj %7.1f MB/s\n", name,
+         logModeStr[mode], stream.size(), ns,
+         double(stream.size()) / (ns * double(objs)) * 1000);
+}
+
+// log ring, text messages pushed then pulled
+void benchLog() {
+  TLogMsg log;
+  log.setMaxMsg(1024);
+  log.activateLog();
+  log.doLogTime();
+  const unsigned n = 1000;
+  std::string s;
+  double nsPush = measure([&] {
+    for (unsigned i = 0; i < n; i++)
+      log.pushMsg("     SUPERVISORY 1a2");
+    while (log.pullMsg(s))
+      ;
+  }, n);
+  double nsPullOnly = measure([&] {
+    while (log.pullMsg(s))
+      ;
+  }, 1);
+  double nsOff;
+  log.deactivateLog();
+  nsOff = measure([&] {
+    for (unsigned i = 0; i < n; i++)
+      log.pushMsg("     SUPERVISORY 1a2");
+  }, n);
+  printf("TLogMsg         push+pull %9.1f ns/msg, empty pull %6.1f ns, push log off %6.1f ns/msg\n",
+         nsPush, nsPullOnly, nsOff);
+}
+
+// I104M encoding of the decoded points (no socket, the datagrams are not sent)
+void benchI104M(unsigned ti, bool sq) {
+  BenchIec104 m;
+  std::vector<iec_obj> objs;
+  iec_apdu apdu;
+  int sz = makeAPDU(apdu, ti, sq, 0);
+  m.mLog.deactivateLog();
+  m.capture = &objs;
+  m.parse(&apdu, sz);
+  I104MForwarder fwd;
+  if (!fwd.sendPoints(objs.data(), unsigned(objs.size()), 1)) {
+    printf("I104M sendPoints TI %3u not forwarded\n", ti);
+    return;
+  }
+  double ns = measure([&] {
+    fwd.sendPoints(objs.data(), unsigned(objs.size()), 1);
+  }, objs.size());
+  printf("I104M sendPoints TI %3u SQ=%d %4zu obj/asdu %9.1f ns/obj\n", ti, sq,
+         objs.size(), ns);
+}
+
+// binary capture: the frame record (hot path of the capture), one apdu of each size
+void benchCapture() {
+  const char *name = "bench104.cap";
+  iec104_capture_writer w;
+  iec_apdu apdu;
+  int sz = makeAPDU(apdu, 13, false, 0);
+  if (!w.open(name, 256 * 1024 * 1024)) {
+    printf("capture record: can't create %s\n", name);
+    return;
+  }
+  // restarted when the file fills, the dropped frames cost only a compare
+  uint64_t frames = 0;
+  double ns = measure([&] {
+    w.record(&apdu, unsigned(sz), false);
+    if (++frames % 1000000 == 0)
+      w.open(name, 256 * 1024 * 1024);
+  }, 1);
+  w.close();
+  remove(name);
+  printf("capture record %3d bytes/frame %9.1f ns/frame\n", sz, ns);
+}
+
+bool readFile(const char *name, std::vector<char> &data) {
+  iec104_capture_reader cap;
+  if (cap.open(name)) {
+    iec104_capture_reader::frame fr;
+    while (cap.next(fr))
+      if (!fr.is_send)
+        data.insert(data.end(), fr.data, fr.data + fr.size);
+    return true;
+  }
+  FILE *f = fopen(name, "rb");
+  if (f == nullptr)
+    return false;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+    data.insert(data.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  const unsigned types[] = {1, 3, 5, 7, 9, 11, 13, 15, 21, 30, 31, 32, 33, 34, 35, 36, 37};
+  if (argc > 2)
+    minNs = atol(argv[2]) * 1000000L;
+  iec104_genTime();
+
+  for (unsigned ti : types)
+    for (int mode = LogOff; mode <= LogPulled; mode++)
+      benchParse(ti, false, LogMode(mode));
+  for (unsigned ti : types)
+    benchParse(ti, true, LogOff);
+
+  // mixed stream of generated apdus, consecutive send numbers
+  std::vector<char> stream;
+  for (uint16_t i = 0; i < 1000; i++) {
+    iec_apdu apdu;
+    int sz = makeAPDU(apdu, types[i % (sizeof(types) / sizeof(types[0]))], i & 1, uint16_t(i << 1));
+    stream.insert(stream.end(), reinterpret_cast<char *>(&apdu), reinterpret_cast<char *>(&apdu) + sz);
+  }
+  for (int mode = LogOff; mode <= LogPulled; mode++)
+    benchStream("generated", stream, LogMode(mode));
+
+  if (argc > 1) {
+    std::vector<char> captured;
+    if (!readFile(argv[1], captured)) {
+      fprintf(stderr, "Can't read %s!\n", argv[1]);
+      return 1;
+    }
+    for (int mode = LogOff; mode <= LogPulled; mode++)
+      benchStream("file", captured, LogMode(mode));
+  }
+
+  benchLog();
+  benchCapture();
+
+  for (unsigned ti : types)
+    benchI104M(ti, false);
+  return 0;
+}
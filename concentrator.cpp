@@ -0,0 +1,399 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "concentrator.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QSettings>
+#include <stdio.h>
+#ifdef Q_OS_UNIX
+#include <syslog.h>
+#endif
+
+Concentrator::Concentrator(const QString &ininame, QObject *parent)
+    : QObject(parent) {
+  QSettings settings(ininame, QSettings::IniFormat);
+
+  mPrimaryAddress = settings.value("IEC104/PRIMARY_ADDRESS", 1).toUInt();
+  mLogOn = settings.value("CONCENTRATOR/LOG", 0).toInt() != 0;
+  unsigned logSlots = settings.value("CONCENTRATOR/LOG_SLOTS", 64).toUInt();
+  int nthreads = settings.value("CONCENTRATOR/THREADS", 0).toInt();
+  // statistics only exported, there is no panel
+  unsigned statsPeriod = mStatsExport.configure(settings);
+  if (!mStatsExport.enabled())
+    statsPeriod = 0;
+
+  mLogFile = stdout;
+  mSyslog = false;
+  mLogTicks = 0;
+  QString logname = settings.value("CONCENTRATOR/LOG_FILE", "").toString();
+#ifdef Q_OS_UNIX
+  if (settings.value("CONCENTRATOR/LOG_SYSLOG", 0).toInt()) {
+    mSyslog = true;
+    openlog("qtester104", LOG_PID, LOG_DAEMON);
+  } else
+#endif
+  if (logname != "") {
+    mLogFile = fopen(logname.toLocal8Bit().constData(), "a");
+    if (mLogFile == nullptr) {
+      fprintf(stderr, "Can't open log file %s!\n", logname.toLocal8Bit().constData());
+      mLogFile = stdout;
+    }
+  }
+
+  // [RTU1] .. [RTUn], ends at the first section without an IP address
+  for (int i = 1;; i++) {
+    QString sect = QString("RTU%1/").arg(i);
+    QString ip = settings.value(sect + "IP_ADDRESS", "").toString();
+    if (ip == "")
+      break;
+
+    std::unique_ptr<Session> s(new Session);
+    s->name = QString("RTU%1").arg(i);
+    s->i104.reset(new QIec104());
+    QIec104 *i104 = s->i104.get();
+    // small log ring, the default one is sized for the user interface
+    i104->mLog.setMaxMsg(logSlots);
+    if (mLogOn) {
+      i104->mLog.activateLog();
+      i104->mLog.doLogTime();
+    } else {
+      i104->mLog.deactivateLog();
+    }
+    i104->setPrimaryAddress(int(mPrimaryAddress));
+    i104->setSecondaryAddress(settings.value(sect + "SECONDARY_ADDRESS", 1).toInt());
+    i104->SendCommands = settings.value(sect + "ALLOW_COMMANDS", 0).toInt();
+    i104->setSecondaryIP(const_cast<char *>(ip.toStdString().c_str()));
+    QString ipbak = settings.value(sect + "IP_ADDRESS_BACKUP", "").toString();
+    i104->setSecondaryIP_backup(const_cast<char *>(ipbak.toStdString().c_str()));
+    i104->setPortTCP(settings.value(sect + "TCP_PORT", i104->getPortTCP()).toUInt());
+    i104->setGIPeriod(settings.value(sect + "GI_PERIOD", 330).toUInt());
+    i104->setGIGroups(iec104_gischeduler::parseGroups(
+                          settings.value(sect + "GI_GROUPS", "").toString().toStdString()),
+                      settings.value(sect + "GI_PARALLEL", 1).toUInt());
+    i104->setStatsPeriod(statsPeriod);
+    // [RTUn] K, W, T1, T2, T3, RECONNECT_MIN/MAX, COMMAND_TIMEOUT, SBO_EXECUTE
+    // override the [IEC104] ones
+    i104->setWindow(
+        settings.value(sect + "K", settings.value("IEC104/K", 12)).toUInt(),
+        settings.value(sect + "W", settings.value("IEC104/W", 8)).toUInt());
+    i104->setTimeouts(
+        settings.value(sect + "T1", settings.value("IEC104/T1", 15)).toDouble(),
+        settings.value(sect + "T2", settings.value("IEC104/T2", 8)).toDouble(),
+        settings.value(sect + "T3", settings.value("IEC104/T3", 10)).toDouble());
+    i104->setReconnect(
+        settings.value(sect + "RECONNECT_MIN",
+                       settings.value("IEC104/RECONNECT_MIN", 1)).toDouble(),
+        settings.value(sect + "RECONNECT_MAX",
+                       settings.value("IEC104/RECONNECT_MAX", 30)).toDouble());
+    i104->setCommandTracking(
+        settings.value(sect + "COMMAND_TIMEOUT",
+                       settings.value("IEC104/COMMAND_TIMEOUT", 30)).toDouble(),
+        settings.value(sect + "SBO_EXECUTE",
+                       settings.value("IEC104/SBO_EXECUTE", 1)).toInt() != 0);
+    // [RTUn] CAPTURE: binary capture file of the session
+    QString capture = settings.value(sect + "CAPTURE", "").toString();
+    if (capture != "" &&
+        !i104->startCapture(capture, settings.value("CAPTURE/SIZE_MB", 64).toUInt()))
+      log(s->name + ": CAN'T CREATE CAPTURE FILE " + capture);
+    // [RTUn] CACHE: last values of the points of the session
+    QString cache = settings.value(sect + "CACHE", "").toString();
+    if (cache != "" &&
+        !i104->openPointCache(cache, settings.value("CACHE/CAPACITY", 65536).toUInt(),
+                              settings.value("CACHE/STALE", 0).toUInt()))
+      log(s->name + ": CAN'T OPEN CACHE FILE " + cache);
+    // [RTUn] SOE: history directory of the time tagged events of the session
+    QString soe = settings.value(sect + "SOE", "").toString();
+    if (soe != "" && !i104->openSOE(soe, settings.value("SOE/FLUSH", 5).toUInt()))
+      log(s->name + ": CAN'T OPEN SOE DIRECTORY " + soe);
+    // measured values forwarded only when changed, a filter per session
+    i104->setChangeFilter(settings.value("DEADBAND/ABSOLUTE", 0).toDouble(),
+                          settings.value("DEADBAND/PERCENT", 0).toDouble(),
+                          settings.value("DEADBAND/CYCLIC_CHANGED", 0).toInt() != 0);
+
+    mByAddress[unsigned(i104->getSecondaryAddress())] = s.get();
+    mSessions.push_back(std::move(s));
+  }
+
+  if (nthreads <= 0)
+    nthreads = QThread::idealThreadCount();
+  if (nthreads > int(mSessions.size()))
+    nthreads = int(mSessions.size());
+  for (int i = 0; i < nthreads; i++) {
+    mThreads.emplace_back(new QThread());
+    mTimers.emplace_back(new QIec104Timers());
+    mTimers.back()->moveToThread(mThreads.back().get());
+  }
+
+  udps = new QUdpSocket(this);
+  udps->bind(I104M_LISTENUDPPORT);
+  udps->open(QIODevice::ReadWrite);
+  mI104M.setSocket(udps);
+  mI104M.setCoalesceTime(settings.value("I104M/COALESCE_US", 0).toUInt());
+  connect(udps, SIGNAL(readyRead()), this, SLOT(slot_I104M_ready_to_read()));
+
+  tmLogMsg = new QTimer(this);
+  connect(tmLogMsg, SIGNAL(timeout()), this, SLOT(slot_timer_logmsg()));
+
+  for (auto &sp : mSessions) {
+    Session *s = sp.get();
+    QIec104 *i104 = s->i104.get();
+    // queued to this (the I104M) thread
+    connect(i104, &QIec104::signal_dataBatch, this,
+            [this, s](QVector<iec_obj> objs, QVector<unsigned> sizes) {
+              dataBatch(s, objs, sizes);
+            });
+    connect(i104, &QIec104::signal_commandActResp, this,
+            [this, s](iec_obj obj) { commandActResp(s, obj); });
+    connect(i104, &QIec104::signal_stats, this,
+            [this, s](iec104_stats stats) { mStatsExport.write(s->name, stats); });
+    connect(i104, &QIec104::signal_tcp_connect, this,
+            [this, s] { log(s->name + ": TCP CONNECTED"); });
+    connect(i104, &QIec104::signal_tcp_disconnect, this,
+            [this, s] { log(s->name + ": TCP DISCONNECTED"); });
+  }
+}
+
+Concentrator::~Concentrator() {
+  stop();
+  if (mLogFile != stdout)
+    fclose(mLogFile);
+#ifdef Q_OS_UNIX
+  if (mSyslog)
+    closelog();
+#endif
+}
+
+QString Concentrator::defaultIniName() {
+  QString ininame = QCoreApplication::applicationDirPath() + "/qtester104.ini";
+  if (!QFile(ininame).exists())
+    ininame = "../conf/qtester104.ini";
+  return ininame;
+}
+
+void Concentrator::start() {
+  if (mSessions.empty())
+    return;
+  for (auto &t : mThreads)
+    t->start();
+  // warm start: the cached points to I104M before the links are up
+  for (auto &sp : mSessions) {
+    QVector<iec_obj> objs;
+    QVector<unsigned> sizes;
+    sp->i104->cachedPoints(objs, sizes);
+    dataBatch(sp.get(), objs, sizes);
+  }
+  // sessions are sharded round robin over the threads, one timer wheel each
+  for (size_t i = 0; i < mSessions.size(); i++) {
+    QIec104 *i104 = mSessions[i]->i104.get();
+    i104->setTimers(mTimers[i % mThreads.size()].get());
+    i104->startIOThread(mThreads[i % mThreads.size()].get());
+    i104->enable_connect();
+    i104->startLink();
+  }
+  bool logon = mLogOn;
+  mLogOn = true;
+  log(QString("CONCENTRATOR: %1 RTUs ON %2 THREADS")
+          .arg(mSessions.size())
+          .arg(mThreads.size()));
+  mLogOn = logon;
+  fflush(mLogFile);
+  tmLogMsg->start(500);
+}
+
+void Concentrator::stop() {
+  tmLogMsg->stop();
+  for (auto &s : mSessions)
+    if (s->i104->isThreaded())
+      s->i104->terminate();
+  for (size_t i = 0; i < mTimers.size(); i++)
+    if (mThreads[i]->isRunning()) {
+      QIec104Timers *tm = mTimers[i].get();
+      QMetaObject::invokeMethod(tm, [tm] { tm->stop(); }, Qt::BlockingQueuedConnection);
+    }
+  for (auto &t : mThreads) {
+    t->quit();
+    t->wait();
+  }
+}
+
+void Concentrator::dataBatch(Session *s, const QVector<iec_obj> &objs,
+                             const QVector<unsigned> &sizes) {
+  const iec_obj *obj = objs.constData();
+  for (unsigned n : sizes) {
+    if (!mI104M.sendPoints(obj, n, mPrimaryAddress))
+      log(s->name + ": R--> IEC104 UNSUPPORTED TYPE, NOT FORWARDED TO I104M/OSHMI");
+    obj += n;
+  }
+}
+
+// the same handling of the user interface (the confirmed selects are executed
+// by the session): respond to I104M if not a select or negative
+void Concentrator::commandActResp(Session *s, iec_obj obj) {
+  if (obj.address == 0)
+    return;
+  if (obj.cause != iec104_class::REQUEST &&
+      obj.cause != iec104_class::ACTIVATION &&
+      obj.cause != iec104_class::ACTCONFIRM)
+    return;
+
+  bool is_select = (obj.se == iec104_class::SELECT);
+  if (is_select == false || obj.pn == iec104_class::NEGATIVE ||
+      !s->i104->getSBOExecute()) {
+    log(s->name + (obj.pn == iec104_class::NEGATIVE
+                       ? ": T<-- I104M: COMMAND REJECTED BY IEC104 SLAVE"
+                       : ": T<-- I104M: COMMAND ACCEPTED BY IEC104 SLAVE"));
+    mI104M.sendCommandResp(&obj, mPrimaryAddress);
+  }
+}
+
+Concentrator::Session *Concentrator::sessionForASDUAddress(unsigned ca) {
+  auto it = mByAddress.find(ca);
+  if (it != mByAddress.end())
+    return it->second;
+  // address 0 (use the slave address) is ambiguous with more than one RTU
+  if (ca == 0 && mSessions.size() == 1)
+    return mSessions[0].get();
+  return nullptr;
+}
+
+void Concentrator::slot_I104M_ready_to_read() {
+  char buf[200];
+  unsigned char br[2000];
+
+  while (udps->hasPendingDatagrams()) {
+    QHostAddress address;
+    quint16 port;
+    int bytesrec = int(udps->readDatagram(reinterpret_cast<char *>(br),
+                                          sizeof(br), &address, &port));
+    if (bytesrec <= 0)
+      return;
+
+    // I104M message must be local
+    if (address.toString() != "127.0.0.1" &&
+        address.toString() != "::ffff:127.0.0.1") {
+      log(QString("R--> I104M: Message from invalid origin ") +
+          address.toString());
+      continue;
+    }
+
+    t_msgcmd *pmsg = reinterpret_cast<t_msgcmd *>(br);
+    if (bytesrec >= int(sizeof(uint32_t)) && pmsg->signature == MSGCMDSQ_SIG) {
+      commandSeq(reinterpret_cast<t_msgcmdsq *>(br), unsigned(bytesrec));
+      continue;
+    }
+    if (bytesrec < int(sizeof(t_msgcmd)) || pmsg->signature != MSGCMD_SIG) {
+      log("R--> I104M: Invalid Message!");
+      continue;
+    }
+
+    if (pmsg->tipo == I104M_ASDU_SPECIAL_CMD) {
+      if (pmsg->endereco == I104M_SPECIAL_CMD_ADDR_REQ_GI) {
+        log("R--> I104M: REQ GI");
+        for (auto &s : mSessions)
+          s->i104->requestGI();
+      }
+      continue;
+    }
+
+    iec_obj obj;
+    if (!I104MForwarder::commandToObj(pmsg, obj, buf))
+      continue;
+    Session *s = sessionForASDUAddress(obj.ca);
+    if (s == nullptr) {
+      log(QString("R--> I104M: NO RTU FOR ASDU ADDRESS %1").arg(obj.ca));
+      continue;
+    }
+    log(s->name + ": " + buf);
+    if (!s->i104->SendCommands) {
+      log(s->name + ": COMMANDS NOT ALLOWED (ALLOW_COMMANDS=0)");
+      continue;
+    }
+    s->i104->requestCommand(obj);
+  }
+}
+
+// commands of a sequence go to their RTUs in the message order, those for the
+// same RTU in one request (one tcp write)
+void Concentrator::commandSeq(const t_msgcmdsq *pmsg, unsigned size) {
+  QVector<iec_obj> objs;
+  int n = I104MForwarder::commandSeqToObjs(pmsg, size, objs);
+  if (n < 0) {
+    log("R--> I104M: Invalid Command Sequence Message!");
+    return;
+  }
+  log(QString("R--> I104M: Command Sequence, %1 commands").arg(n));
+
+  std::map<Session *, QVector<iec_obj>> bySession;
+  for (const iec_obj &obj : objs) {
+    Session *s = sessionForASDUAddress(obj.ca);
+    if (s == nullptr) {
+      log(QString("R--> I104M: NO RTU FOR ASDU ADDRESS %1").arg(obj.ca));
+      continue;
+    }
+    if (!s->i104->SendCommands) {
+      log(s->name + ": COMMANDS NOT ALLOWED (ALLOW_COMMANDS=0)");
+      continue;
+    }
+    bySession[s].append(obj);
+  }
+  for (auto &sc : bySession) {
+    Session *s = sc.first;
+    log(s->name + QString(": %1 COMMANDS").arg(sc.second.size()));
+    s->i104->requestCommands(sc.second);
+  }
+}
+
+void Concentrator::slot_timer_logmsg() {
+  if (!mLogOn)
+    return;
+  // I104M forwarding statistics, every minute
+  if (!(++mLogTicks % 120))
+    log(mI104M.statsText());
+  for (auto &s : mSessions) {
+    QIec104 *i104 = s->i104.get();
+    while (i104->mLog.pullMsg(mLine)) {
+      mLine.insert(0, s->name.toStdString() + ": ");
+      log(QString::fromStdString(mLine));
+    }
+  }
+  fflush(mLogFile);
+}
+
+void Concentrator::log(const QString &str) {
+  if (!mLogOn)
+    return;
+#ifdef Q_OS_UNIX
+  if (mSyslog) {
+    syslog(LOG_INFO, "%s", str.toLocal8Bit().constData());
+    return;
+  }
+#endif
+  fprintf(mLogFile, "%s\n", str.toLocal8Bit().constData());
+}
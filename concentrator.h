@@ -0,0 +1,94 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef CONCENTRATOR_H
+#define CONCENTRATOR_H
+
+// Concentrator mode: many RTU sessions in one process, without user interface.
+// Reads [RTU1]..[RTUn] from the ini file, runs the sessions on a small pool of
+// threads (sharded by session) and forwards all data to one I104M/OSHMI link.
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+#include <stdio.h>
+#include <map>
+#include <memory>
+#include <vector>
+#include "qiec104.h"
+#include "i104m.h"
+#include "statsexport.h"
+
+class Concentrator : public QObject {
+  Q_OBJECT
+
+public:
+  Concentrator(const QString &ininame, QObject *parent = nullptr);
+  ~Concentrator();
+  static QString defaultIniName(); // the same as the user interface uses
+  int sessionCount() const { return int(mSessions.size()); }
+  void start();
+  void stop();
+
+private slots:
+  void slot_I104M_ready_to_read(); // commands from OSHMI
+  void slot_timer_logmsg();        // drain logs of the sessions
+
+private:
+  struct Session {
+    QString name; // ini section
+    std::unique_ptr<QIec104> i104;
+  };
+  void dataBatch(Session *s, const QVector<iec_obj> &objs,
+                 const QVector<unsigned> &sizes);
+  void commandActResp(Session *s, iec_obj obj);
+  Session *sessionForASDUAddress(unsigned ca); // destination of a command
+  void commandSeq(const t_msgcmdsq *pmsg, unsigned size); // I104M command sequence
+  void log(const QString &str);
+
+  // timers of the sessions of each thread, destroyed after the sessions
+  std::vector<std::unique_ptr<QIec104Timers>> mTimers;
+  std::vector<std::unique_ptr<Session>> mSessions;
+  std::vector<std::unique_ptr<QThread>> mThreads; // event loops of the sessions
+  std::map<unsigned, Session *> mByAddress;        // secondary address -> session
+  unsigned mPrimaryAddress;
+  bool mLogOn;
+  FILE *mLogFile; // log to this file (default standard output) or to syslog
+  bool mSyslog;
+  unsigned mLogTicks;
+  QUdpSocket *udps;
+  I104MForwarder mI104M;
+  StatsExporter mStatsExport; // link statistics of all the sessions
+  QTimer *tmLogMsg;
+  std::string mLine; // log line buffer
+};
+
+#endif // CONCENTRATOR_H
@@ -0,0 +1,86 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+// QTester104d: headless build (no QtWidgets) for server deployments.
+// Runs the concentrator over the [RTU1]..[RTUn] sections of the ini file.
+// usage: QTester104d [ini file]
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <stdio.h>
+#include "concentrator.h"
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// SIGTERM/SIGINT end the event loop (stop as a service), through a socket pair
+static int sigfd[2];
+
+static void sigHandler(int)
+{
+    char c = 1;
+    ssize_t r = write(sigfd[0], &c, 1);
+    (void)r;
+}
+
+static void setupSignals(QCoreApplication & a)
+{
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sigfd) != 0)
+        return;
+    QSocketNotifier * sn = new QSocketNotifier(sigfd[1], QSocketNotifier::Read, &a);
+    QObject::connect(sn, &QSocketNotifier::activated, &a, &QCoreApplication::quit);
+
+    struct sigaction sa;
+    sa.sa_handler = sigHandler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGINT, &sa, nullptr);
+}
+#else
+static void setupSignals(QCoreApplication &) {}
+#endif
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    Concentrator c(argc > 1 ? QString(argv[1]) : Concentrator::defaultIniName());
+    if (c.sessionCount() == 0) {
+        fprintf(stderr, "No [RTUn] sections with IP_ADDRESS in the ini file!\n");
+        return 1;
+    }
+    setupSignals(a);
+    QObject::connect(&a, &QCoreApplication::aboutToQuit, &c, &Concentrator::stop);
+    c.start();
+    return a.exec();
+}
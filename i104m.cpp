@@ -0,0 +1,512 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "i104m.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+
+I104MForwarder::I104MForwarder(int port) {
+  mUdps = nullptr;
+  mHost.setAddress("127.0.0.1");
+  mHostDual.setAddress("0.0.0.0");
+  mPort = quint16(port);
+  mPend.numpoints = 0;
+  mCoalesceUs = 0;
+  mFlushTimer = nullptr;
+  mDatagrams = 0;
+  mPoints = 0;
+  mStatsDatagrams = 0;
+  mStatsPoints = 0;
+}
+
+I104MForwarder::~I104MForwarder() { delete mFlushTimer; }
+
+void I104MForwarder::setSocket(QUdpSocket *udps) { mUdps = udps; }
+
+void I104MForwarder::setHosts(const QHostAddress &host,
+                              const QHostAddress &host_dual) {
+  mHost = host;
+  mHostDual = host_dual;
+}
+
+void I104MForwarder::send(const char *msg, unsigned packet_size) {
+  if (mUdps == nullptr)
+    return;
+  mUdps->writeDatagram(msg, packet_size, mHost, mPort);
+  if (haveDualHost())
+    mUdps->writeDatagram(msg, packet_size, mHostDual, mPort);
+}
+
+// I104M encoding of the monitor direction points
+namespace {
+
+unsigned char digitalQual(unsigned char state, const iec_obj *obj) {
+  return static_cast<unsigned char>(state | (obj->bl << 4) | (obj->sb << 5) |
+                                    (obj->nt << 6) | (obj->iv << 7));
+}
+
+unsigned char analogQual(const iec_obj *obj) {
+  return static_cast<unsigned char>(obj->ov | (obj->bl << 4) | (obj->sb << 5) |
+                                    (obj->nt << 6) | (obj->iv << 7));
+}
+
+void putTime(digital_w_time7_seq *p, const iec_obj *obj) {
+  p->ano = obj->timetag.year;
+  p->mes = obj->timetag.month;
+  p->dia = obj->timetag.mday;
+  p->hora = obj->timetag.hour;
+  p->min = obj->timetag.min;
+  p->ms = obj->timetag.msec;
+}
+
+void encSingle(digital_notime_seq *p, const iec_obj *o) {
+  p->iq = digitalQual(o->sp, o);
+}
+
+void encDouble(digital_notime_seq *p, const iec_obj *o) {
+  p->iq = digitalQual(o->dp, o);
+}
+
+void encSingleTime(digital_w_time7_seq *p, const iec_obj *o) {
+  p->iq = digitalQual(o->sp, o);
+  putTime(p, o);
+}
+
+// also the protection event (38), decoded with the event state in dp
+void encDoubleTime(digital_w_time7_seq *p, const iec_obj *o) {
+  p->iq = digitalQual(o->dp, o);
+  putTime(p, o);
+}
+
+void encStep(step_seq *p, const iec_obj *o) {
+  p->qds = analogQual(o);
+  p->vti = static_cast<unsigned char>(o->value) |
+           static_cast<unsigned char>(o->t << 7);
+}
+
+// normalized and scaled (21 has no quality, decoded as good)
+void encAnalog(analogico_seq *p, const iec_obj *o) {
+  p->qds = analogQual(o);
+  p->sva = static_cast<short>(o->value);
+}
+
+void encFloat(flutuante_seq *p, const iec_obj *o) {
+  p->qds = analogQual(o);
+  p->fr = float(o->value);
+}
+
+void encCounter(integrated_seq *p, const iec_obj *o) {
+  // map carry to overflow
+  p->qds = static_cast<unsigned char>((o->cy << 7) | (o->cadj << 6) |
+                                      (o->iv << 7));
+  p->bcr = o->bcr;
+}
+
+// note: bitstring could also possibly be interpreted as 32 single binary
+// states in sequence I opt to use counter to avoid possible address
+// conflict for bitstrings in sequence of addresses.
+// The same for the other packed types: status+change detection (20),
+// protection start events (39) and output circuit (40)
+void encBitstring(integrated_seq *p, const iec_obj *o) {
+  // value as counter and no qualifier
+  p->qds = 0;
+  p->bcr = o->bsi.bsi;
+}
+
+void encPackedSingle(integrated_seq *p, const iec_obj *o) {
+  p->qds = analogQual(o);
+  p->bcr = o->bcr; // 16 status bits, 16 change detection bits
+}
+
+void encStartEvents(integrated_seq *p, const iec_obj *o) {
+  p->qds = digitalQual(0, o);
+  p->bcr = o->spe.spe;
+}
+
+void encOutputCircuit(integrated_seq *p, const iec_obj *o) {
+  p->qds = digitalQual(0, o);
+  p->bcr = o->oci.oci;
+}
+
+// { 4 bytes address, value } for n points
+template <class T, void (*ENC)(T *, const iec_obj *)>
+void packPoints(unsigned char *dst, const iec_obj *obj, unsigned n) {
+  for (unsigned i = 0; i < n; i++, obj++, dst += sizeof(uint32_t) + sizeof(T)) {
+    uint32_t addr = obj->address;
+    memcpy(dst, &addr, sizeof(addr));
+    ENC(reinterpret_cast<T *>(dst + sizeof(addr)), obj);
+  }
+}
+
+struct i104m_encoder {
+  void (*pack)(unsigned char *dst, const iec_obj *obj, unsigned n); // nullptr: not forwarded
+  uint32_t tipo;      // I104M type
+  uint32_t taminfo;   // value size
+  unsigned maxpoints; // points per message
+};
+
+template <class T, void (*ENC)(T *, const iec_obj *)>
+constexpr i104m_encoder enc(unsigned tipo, unsigned maxpoints) {
+  return {packPoints<T, ENC>, tipo, sizeof(T),
+          std::min(maxpoints, unsigned(sizeof(t_msgsupsq::info) /
+                                       (sizeof(uint32_t) + sizeof(T))))};
+}
+
+constexpr std::array<i104m_encoder, 256> makeEncoderTable() {
+  typedef iec104_class c;
+  std::array<i104m_encoder, 256> t{};
+  t[c::M_SP_NA_1] = enc<digital_notime_seq, encSingle>(c::M_SP_NA_1, PKTDIG_MAXPOINTS);
+  t[c::M_DP_NA_1] = enc<digital_notime_seq, encDouble>(c::M_DP_NA_1, PKTDIG_MAXPOINTS);
+  t[c::M_ST_NA_1] = enc<step_seq, encStep>(c::M_ST_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_BO_NA_1] = enc<integrated_seq, encBitstring>(c::M_IT_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_ME_NA_1] = enc<analogico_seq, encAnalog>(c::M_ME_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_ME_NB_1] = enc<analogico_seq, encAnalog>(c::M_ME_NB_1, PKTANA_MAXPOINTS);
+  t[c::M_ME_NC_1] = enc<flutuante_seq, encFloat>(c::M_ME_NC_1, PKTANA_MAXPOINTS);
+  t[c::M_IT_NA_1] = enc<integrated_seq, encCounter>(c::M_IT_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_PS_NA_1] = enc<integrated_seq, encPackedSingle>(c::M_IT_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_ME_ND_1] = enc<analogico_seq, encAnalog>(c::M_ME_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_SP_TB_1] = enc<digital_w_time7_seq, encSingleTime>(c::M_SP_TB_1, PKTEVE_MAXPOINTS);
+  t[c::M_DP_TB_1] = enc<digital_w_time7_seq, encDoubleTime>(c::M_DP_TB_1, PKTEVE_MAXPOINTS);
+  // analogs, steps and counters with time tag: time is not forwarded
+  t[c::M_ST_TB_1] = enc<step_seq, encStep>(c::M_ST_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_BO_TB_1] = enc<integrated_seq, encBitstring>(c::M_IT_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_ME_TD_1] = enc<analogico_seq, encAnalog>(c::M_ME_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_ME_TE_1] = enc<analogico_seq, encAnalog>(c::M_ME_NB_1, PKTANA_MAXPOINTS);
+  t[c::M_ME_TF_1] = enc<flutuante_seq, encFloat>(c::M_ME_NC_1, PKTANA_MAXPOINTS);
+  t[c::M_IT_TB_1] = enc<integrated_seq, encCounter>(c::M_IT_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_EP_TD_1] = enc<digital_w_time7_seq, encDoubleTime>(c::M_DP_TB_1, PKTEVE_MAXPOINTS);
+  t[c::M_EP_TE_1] = enc<integrated_seq, encStartEvents>(c::M_IT_NA_1, PKTANA_MAXPOINTS);
+  t[c::M_EP_TF_1] = enc<integrated_seq, encOutputCircuit>(c::M_IT_NA_1, PKTANA_MAXPOINTS);
+  return t;
+}
+
+constexpr std::array<i104m_encoder, 256> encoderTable = makeEncoderTable();
+
+} // namespace
+
+// points of one asdu (same CA and cause) are appended to the pending message,
+// that is sent first when it is for other type/CA/cause or is full
+bool I104MForwarder::sendPoints(const iec_obj *obj, unsigned numpoints,
+                                unsigned prim) {
+  const i104m_encoder &enc = encoderTable[obj->type];
+  if (enc.pack == nullptr)
+    return false;
+  if (numpoints == 0)
+    return true;
+
+  if (mPend.numpoints > 0 &&
+      (mPend.tipo != enc.tipo || mPend.sec != obj->ca ||
+       mPend.causa != obj->cause || mPend.prim != prim))
+    flush();
+
+  while (numpoints > 0) {
+    if (mPend.numpoints == 0) {
+      mPend.signature = MSGSUPSQ_SIG;
+      mPend.tipo = enc.tipo;
+      mPend.prim = prim;
+      mPend.sec = obj->ca;
+      mPend.causa = obj->cause;
+      mPend.taminfo = enc.taminfo;
+    }
+    unsigned n = std::min(numpoints, enc.maxpoints - mPend.numpoints);
+    enc.pack(mPend.info + mPend.numpoints * (sizeof(uint32_t) + enc.taminfo),
+             obj, n);
+    mPend.numpoints += n;
+    obj += n;
+    numpoints -= n;
+    if (mPend.numpoints == enc.maxpoints)
+      flush(); // split
+  }
+
+  if (mCoalesceUs == 0)
+    flush();
+  else if (mPend.numpoints > 0 && !mFlushTimer->isActive())
+    mFlushTimer->start(int((mCoalesceUs + 999) / 1000));
+  return true;
+}
+
+void I104MForwarder::flush() {
+  if (mPend.numpoints == 0)
+    return;
+  if (mFlushTimer != nullptr)
+    mFlushTimer->stop();
+  send(reinterpret_cast<char *>(&mPend),
+       sizeof(int32_t) * 7 + mPend.numpoints * (sizeof(int32_t) + mPend.taminfo));
+  mDatagrams++;
+  mPoints += mPend.numpoints;
+  mPend.numpoints = 0;
+}
+
+void I104MForwarder::setCoalesceTime(unsigned us) {
+  flush();
+  mCoalesceUs = us;
+  if (us > 0 && mFlushTimer == nullptr) {
+    mFlushTimer = new QTimer();
+    mFlushTimer->setSingleShot(true);
+    mFlushTimer->setTimerType(Qt::PreciseTimer);
+    QObject::connect(mFlushTimer, &QTimer::timeout, mFlushTimer,
+                     [this] { flush(); });
+  }
+}
+
+QString I104MForwarder::statsText() {
+  qint64 ms = mStatsTime.isValid() ? mStatsTime.restart() : 0;
+  if (!mStatsTime.isValid())
+    mStatsTime.start();
+  uint64_t dg = mDatagrams - mStatsDatagrams;
+  uint64_t pts = mPoints - mStatsPoints;
+  mStatsDatagrams = mDatagrams;
+  mStatsPoints = mPoints;
+  return QString("I104M: %1 datagrams/s %2 points/datagram")
+      .arg(ms > 0 ? double(dg) * 1000 / ms : 0.0, 0, 'f', 1)
+      .arg(dg > 0 ? double(pts) / dg : 0.0, 0, 'f', 1);
+}
+
+void I104MForwarder::sendCommandResp(const iec_obj *obj, unsigned prim) {
+  flush(); // keep the order of points and responses
+  t_msgsup I104M_msg;
+  I104M_msg.signature = MSGSUP_SIG;
+  I104M_msg.tipo = obj->type;
+  I104M_msg.endereco = obj->address;
+  I104M_msg.sec = obj->ca;
+  I104M_msg.prim = prim;
+  // mask cause, and p/n result to bit 6 1=NEG 0=POS
+  I104M_msg.causa = unsigned(
+      obj->cause | (((obj->pn == iec104_class::NEGATIVE) ? 1 : 0) << 6));
+
+  switch (obj->type) {
+  case iec104_class::C_SC_NA_1:
+  case iec104_class::C_SC_TA_1:
+    I104M_msg.taminfo = 1;
+    I104M_msg.info[0] = obj->scs;
+    break;
+  case iec104_class::C_DC_NA_1:
+  case iec104_class::C_DC_TA_1:
+    I104M_msg.taminfo = 1;
+    I104M_msg.info[0] = obj->dcs;
+    break;
+  case iec104_class::C_RC_NA_1:
+  case iec104_class::C_RC_TA_1:
+    I104M_msg.taminfo = 1;
+    I104M_msg.info[0] = obj->rcs;
+    break;
+  case iec104_class::C_SE_NA_1:
+  case iec104_class::C_SE_TA_1:
+  case iec104_class::C_SE_NB_1:
+  case iec104_class::C_SE_TB_1:
+  case iec104_class::C_SE_NC_1:
+  case iec104_class::C_SE_TC_1:
+    I104M_msg.taminfo = 4;
+    *(reinterpret_cast<float *>(&I104M_msg.info)) = obj->value;
+    break;
+  case iec104_class::C_BO_NA_1:
+  case iec104_class::C_BO_TA_1:
+    I104M_msg.taminfo = 4;
+    *(reinterpret_cast<uint32_t *>(&I104M_msg.info)) = uint32_t(obj->value);
+    break;
+  }
+  send(reinterpret_cast<char *>(&I104M_msg), sizeof(I104M_msg));
+}
+
+bool I104MForwarder::commandToObj(const t_msgcmd *pmsg, iec_obj &obj,
+                                  char *txt) {
+  obj.cause = iec104_class::ACTIVATION;
+  obj.address = pmsg->endereco;
+  obj.ca = static_cast<unsigned short>(pmsg->utr);
+  obj.qu = static_cast<unsigned char>(pmsg->qu);
+  obj.se = static_cast<unsigned char>(pmsg->sbo);
+  obj.type = static_cast<unsigned char>(pmsg->tipo);
+
+  switch (pmsg->tipo) {
+  case iec104_class::C_SC_TA_1: // single command with time tag
+  case iec104_class::C_SC_NA_1: // single command
+    sprintf(txt, "R--> I104M: Single Command %s", pmsg->onoff ? "on" : "off");
+    obj.sp = static_cast<unsigned char>(pmsg->onoff);
+    break;
+  case iec104_class::C_DC_TA_1: // double command with time tag
+  case iec104_class::C_DC_NA_1: // double command
+    sprintf(txt, "R--> I104M: Double Command %s", pmsg->onoff ? "on" : "off");
+    obj.dp = pmsg->onoff ? 2 : 1;
+    break;
+  case iec104_class::C_SE_TA_1: // set-point normalised command with time tag
+  case iec104_class::C_SE_NA_1: // set-point normalised command
+    sprintf(txt, "R--> I104M: set-point normalised command %f",
+            double(pmsg->setpoint));
+    obj.value = pmsg->setpoint;
+    break;
+  case iec104_class::C_SE_TB_1: // set-point scaled command with time tag
+  case iec104_class::C_SE_NB_1: // set-point scaled command
+    sprintf(txt, "R--> I104M: set-point scaled command %f",
+            double(pmsg->setpoint));
+    obj.value = pmsg->setpoint;
+    break;
+  case iec104_class::C_SE_TC_1: // set-point short floating point command with
+                                // time tag
+  case iec104_class::C_SE_NC_1: // set-point short floating point command
+    sprintf(txt, "R--> I104M: set-point short floating command %f",
+            double(pmsg->setpoint));
+    obj.value = pmsg->setpoint;
+    break;
+  case iec104_class::C_RC_TA_1: // regulating step command with time tag
+  case iec104_class::C_RC_NA_1: // regulating step command
+    sprintf(txt, "R--> I104M: regulating step command %s",
+            pmsg->setpoint == 0 ? "LOWER" : "RAISE");
+    obj.rcs = pmsg->setpoint == 0 ? 1 : 2;
+    break;
+  case iec104_class::C_BO_TA_1: // bitstring command with time tag
+  case iec104_class::C_BO_NA_1: // bitstring command
+    sprintf(txt, "R--> I104M: bitstring command %u", pmsg->setpoint_i32);
+    obj.value = pmsg->setpoint_i32;
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
+int I104MForwarder::commandSeqToObjs(const t_msgcmdsq *pmsg, unsigned size,
+                                     QVector<iec_obj> &objs) {
+  char txt[200];
+  if (size < offsetof(t_msgcmdsq, cmd) || pmsg->numcmds > MSGCMDSQ_MAXCMDS ||
+      size < offsetof(t_msgcmdsq, cmd) + pmsg->numcmds * sizeof(t_msgcmd))
+    return -1;
+  objs.resize(int(pmsg->numcmds));
+  int n = 0;
+  for (unsigned i = 0; i < pmsg->numcmds; i++)
+    if (commandToObj(&pmsg->cmd[i], objs[n], txt))
+      n++;
+  objs.resize(n);
+  return int(pmsg->numcmds);
+}
+
+// ---- hot standby point cache replication ---------------------------------
+
+I104MReplicator::I104MReplicator(int port) {
+  mUdps = nullptr;
+  mHostDual.setAddress("0.0.0.0");
+  mPort = quint16(port);
+  mSeq = 0;
+  mRxSeq = 0;
+  mSynced = false;
+  mDumpPos = 0;
+  mDumpTimer = nullptr;
+  mRecords = 0;
+}
+
+I104MReplicator::~I104MReplicator() { delete mDumpTimer; }
+
+void I104MReplicator::setSocket(QUdpSocket *udps) { mUdps = udps; }
+
+void I104MReplicator::setHost(const QHostAddress &host_dual) { mHostDual = host_dual; }
+
+void I104MReplicator::send(const pointcache_rec *recs, unsigned n, uint32_t flags) {
+  if (mUdps == nullptr)
+    return;
+  t_msgrep msg;
+  msg.signature = MSGREP_SIG;
+  msg.seq = mSeq++;
+  msg.flags = flags;
+  msg.numrecs = n;
+  msg.recsize = sizeof(pointcache_rec);
+  if (n > 0)
+    memcpy(msg.rec, recs, n * sizeof(pointcache_rec));
+  mUdps->writeDatagram(reinterpret_cast<char *>(&msg),
+                       offsetof(t_msgrep, rec) + n * sizeof(pointcache_rec), mHostDual,
+                       mPort);
+  mRecords += n;
+}
+
+void I104MReplicator::sendPoints(const iec_obj *obj, unsigned numpoints) {
+  pointcache_rec recs[MSGREP_MAXRECS];
+  unsigned n = 0;
+  for (unsigned i = 0; i < numpoints; i++) {
+    recs[n].used = 1;
+    recs[n].group = iec104_pointcache::groupOf(obj[i].cause);
+    recs[n].updated_ms = obj[i].arrival_us / 1000;
+    recs[n].obj = obj[i];
+    if (++n == MSGREP_MAXRECS || i == numpoints - 1) {
+      send(recs, n, 0);
+      n = 0;
+    }
+  }
+}
+
+// paced, the secondary socket buffer would overflow with all at once
+void I104MReplicator::sendDump(const std::vector<pointcache_rec> &recs) {
+  mDump = recs;
+  mDumpPos = 0;
+  send(nullptr, 0, MSGREP_FLAG_SYNC);
+  if (mDumpTimer == nullptr) {
+    mDumpTimer = new QTimer();
+    QObject::connect(mDumpTimer, &QTimer::timeout, mDumpTimer, [this] { dumpTick(); });
+  }
+  mDumpTimer->start(5);
+}
+
+void I104MReplicator::dumpTick() {
+  // 16 datagrams per tick, 3 MB/s
+  for (int i = 0; i < 16 && mDumpPos < mDump.size(); i++) {
+    unsigned n = unsigned(std::min<size_t>(MSGREP_MAXRECS, mDump.size() - mDumpPos));
+    send(&mDump[mDumpPos], n, 0);
+    mDumpPos += n;
+  }
+  if (mDumpPos >= mDump.size()) {
+    mDumpTimer->stop();
+    mDump.clear();
+    mDump.shrink_to_fit();
+  }
+}
+
+bool I104MReplicator::receive(const t_msgrep *msg, unsigned size,
+                              QVector<pointcache_rec> &recs) {
+  recs.clear();
+  if (size < offsetof(t_msgrep, rec) || msg->recsize != sizeof(pointcache_rec) ||
+      msg->numrecs > MSGREP_MAXRECS ||
+      size < offsetof(t_msgrep, rec) + msg->numrecs * sizeof(pointcache_rec))
+    return false;
+  if (msg->flags & MSGREP_FLAG_SYNC)
+    mSynced = true;
+  else if (msg->seq != mRxSeq)
+    mSynced = false;
+  mRxSeq = msg->seq + 1;
+  for (unsigned i = 0; i < msg->numrecs; i++)
+    recs.append(msg->rec[i]);
+  mRecords += msg->numrecs;
+  return true;
+}
+
+bool I104MReplicator::needSync() {
+  if (mSynced || (mSyncAsked.isValid() && mSyncAsked.elapsed() < 5000))
+    return false;
+  mSyncAsked.start();
+  return true;
+}
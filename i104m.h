@@ -0,0 +1,288 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef I104M_H
+#define I104M_H
+
+// I104M: UDP messages exchanged with the OSHMI HMI.
+// Data and command responses are forwarded to the HMI, commands are received from it.
+
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QUdpSocket>
+#include "iec104_class.h"
+#include "iec104_pointcache.h"
+
+#pragma pack(push)
+#pragma pack(1) // byte aligned structures
+
+#define I104M_LISTENUDPPORT 8098
+#define I104M_WRITEUDPPORT 8099
+
+#define I104M_ASDU_SPECIAL_CMD 1001
+#define I104M_SPECIAL_CMD_ADDR_REQ_GI 0
+#define I104M_SPECIAL_CMD_ADDR_KEEP_ALIVE 1
+#define I104M_SPECIAL_CMD_ADDR_REPLICA_SYNC 2 // hot standby: secondary asks the point cache of the primary
+
+#define PKTDIG_MAXPOINTS       250
+#define PKTEVE_MAXPOINTS       100
+#define PKTANA_MAXPOINTS       150
+
+#define MSGKA_SIG 0x5a5a5a5a
+
+#define MSGSUP_SIG 0x53535353
+typedef struct {
+  uint32_t signature;  // 0x53535353
+  uint32_t endereco;
+  uint32_t tipo;
+  uint32_t prim;
+  uint32_t sec;
+  uint32_t causa;
+  uint32_t taminfo;
+  unsigned char info[255];
+} t_msgsup;
+
+#define MSGSUPSQ_SIG 0x64646464
+typedef struct {
+  uint32_t signature;  // 0x64646464
+  uint32_t numpoints;
+  uint32_t tipo;
+  uint32_t prim;
+  uint32_t sec;
+  uint32_t causa;
+  uint32_t taminfo; // value size for the type (not counting the 4 byte address)
+  unsigned char info[2000]; // { 4 bytes uint32_t address, point value (taminfo bytes) } ...  Repeat
+} t_msgsupsq;
+
+#define MSGCMD_SIG 0x4b4b4b4b
+typedef struct {
+  uint32_t signature; // 0x4b4b4b4b
+  uint32_t endereco;
+  uint32_t tipo;
+  union {
+    uint32_t onoff;
+    float setpoint;
+    int32_t setpoint_i32;
+    short int setpoint_i16;
+  };
+  uint32_t sbo;
+  uint32_t qu;
+  uint32_t utr;
+} t_msgcmd;
+
+#define MSGCMDSQ_SIG 0x4c4c4c4c
+#define MSGCMDSQ_MAXCMDS 64
+typedef struct {
+  uint32_t signature; // 0x4c4c4c4c
+  uint32_t numcmds;
+  t_msgcmd cmd[MSGCMDSQ_MAXCMDS]; // numcmds commands (signature not checked), sent in this order
+} t_msgcmdsq;
+
+// hot standby: point cache records from the primary to the secondary host
+#define MSGREP_SIG 0x52525252
+#define MSGREP_MAXRECS 24  // datagrams of less than 1472 bytes
+#define MSGREP_FLAG_SYNC 1 // first message of a dump of the whole cache
+typedef struct {
+  uint32_t signature; // 0x52525252
+  uint32_t seq;       // message sequence of the sender, a gap: lost records
+  uint32_t flags;
+  uint32_t numrecs;
+  uint32_t recsize;   // sizeof(pointcache_rec), layout check
+  pointcache_rec rec[MSGREP_MAXRECS];
+} t_msgrep;
+
+typedef struct {
+  unsigned short nponto; // point address 1st & 2nd bytes
+  unsigned char nponto3; // point address 3rd byte
+  unsigned char iq;      // state & qualifier
+  unsigned short ms;     // milli seconds
+  unsigned char min;     // minute
+  unsigned char hora;    // hour
+  unsigned char dia;     // day
+  unsigned char mes;
+  unsigned char ano;
+} digital_w_time7;
+
+typedef struct {
+  unsigned char iq;     // state & qualifier
+  unsigned short ms;    // milli seconds
+  unsigned char min;    // minute
+  unsigned char hora;   // hour
+  unsigned char dia;    // day
+  unsigned char mes;
+  unsigned char ano;
+} digital_w_time7_seq;
+
+
+typedef struct {
+  unsigned char iq;      // state & qualifier
+} digital_notime_seq;
+
+typedef struct {
+  unsigned short nponto; // point address 1st & 2nd bytes
+  unsigned char nponto3; // point address 3rd byte
+  short sva;             // analog value 16bit integer
+  unsigned char qds;     // qualifier
+} analogico;
+
+typedef struct {
+  short sva;         // analog value 16bit integer
+  unsigned char qds; // qualifier
+} analogico_seq;
+
+typedef struct {
+  unsigned short nponto; // point address 1st & 2nd bytes
+  unsigned char nponto3; // point address 3rd byte
+  unsigned char vti;     // step pos
+  unsigned char qds;     // qualifier
+} step;
+
+typedef struct {
+  unsigned char vti;   // step pos
+  unsigned char qds;   // qualifier
+} step_seq;
+
+typedef struct {
+  unsigned short nponto; // point address 1st & 2nd bytes
+  unsigned char nponto3; // point address 3rd byte
+  float fr;              // analog value 4byte float
+  unsigned char qds;     // qualifier
+} flutuante;
+
+typedef struct {
+  float fr;         // analog value 4byte float
+  unsigned char qds;  // qualifier
+} flutuante_seq;
+
+typedef struct {
+  unsigned short nponto; // point address 1st & 2nd bytes
+  unsigned char nponto3; // point address 3rd byte
+  uint32_t bcr;      // valor binary counter reading
+  unsigned char qds;     // qualifier
+} integrated;
+
+typedef struct {
+  uint32_t bcr;   // value binary counter reading
+  unsigned char qds;  // qualifies
+} integrated_seq;
+
+#pragma pack(pop)
+
+// encodes IEC104 points and command responses to I104M and sends them to the HMI
+// (and to the dual host of a redundant HMI). Not thread safe, use it from the socket thread.
+class I104MForwarder {
+public:
+  I104MForwarder(int port = I104M_WRITEUDPPORT);
+  ~I104MForwarder();
+  void setSocket(QUdpSocket *udps);
+  void setHosts(const QHostAddress &host, const QHostAddress &host_dual);
+  bool haveDualHost() const { return mHostDual != QHostAddress("0.0.0.0"); }
+  void send(const char *msg, unsigned packet_size);
+  // points of one asdu, returns false if the type is not forwarded to I104M.
+  // All the monitor direction types decoded are forwarded, the ones without an
+  // I104M equivalent are mapped (packed ones to counters, see i104m.cpp).
+  // Points of the same type, CA and cause are coalesced in one message, sent
+  // when full (split at PKTDIG/PKTEVE/PKTANA_MAXPOINTS), when other points come
+  // or after the coalesce time.
+  bool sendPoints(const iec_obj *obj, unsigned numpoints, unsigned prim);
+  void flush(); // send the pending points
+  // max time points wait for more points, us (0: one message per asdu),
+  // rounded up to the 1 ms granularity of the flush timer
+  void setCoalesceTime(unsigned us);
+  uint64_t datagrams() const { return mDatagrams; } // point messages sent
+  uint64_t points() const { return mPoints; }
+  QString statsText(); // datagrams/s and points/datagram since the last call
+  void sendCommandResp(const iec_obj *obj, unsigned prim);
+  // fill obj from an I104M command message, txt receives a log line (>= 100 chars)
+  // returns false if the message is not an IEC104 command
+  static bool commandToObj(const t_msgcmd *msg, iec_obj &obj, char *txt);
+  // fill objs from an I104M command sequence message of size bytes, returns
+  // the number of commands in the message (objs has only the IEC104 commands)
+  // or -1 if the message is malformed
+  static int commandSeqToObjs(const t_msgcmdsq *msg, unsigned size,
+                              QVector<iec_obj> &objs);
+
+private:
+  QUdpSocket *mUdps;
+  QHostAddress mHost;
+  QHostAddress mHostDual;
+  quint16 mPort;
+  t_msgsupsq mPend; // points waiting to be sent
+  unsigned mCoalesceUs;
+  QTimer *mFlushTimer;
+  uint64_t mDatagrams;
+  uint64_t mPoints;
+  uint64_t mStatsDatagrams; // counters at the last statsText()
+  uint64_t mStatsPoints;
+  QElapsedTimer mStatsTime;
+};
+
+// hot standby of a redundant pair: the primary streams its point cache
+// changes to the I104M port of the dual host, the secondary applies them to
+// its cache and takes over with it warm. Sequence gaps (lost datagrams) make
+// the secondary ask for a dump of the whole cache, sent paced. Not thread
+// safe, use it from the socket thread.
+class I104MReplicator {
+public:
+  I104MReplicator(int port = I104M_LISTENUDPPORT);
+  ~I104MReplicator();
+  void setSocket(QUdpSocket *udps);
+  void setHost(const QHostAddress &host_dual);
+  // primary: the points of an asdu, as the point cache records them
+  void sendPoints(const iec_obj *obj, unsigned numpoints);
+  // primary: all the records of the cache, after the pending ones of a
+  // previous dump are dropped
+  void sendDump(const std::vector<pointcache_rec> &recs);
+  uint64_t records() const { return mRecords; } // records sent or received
+  // secondary: records of a message of size bytes, returns false if the
+  // message is malformed
+  bool receive(const t_msgrep *msg, unsigned size, QVector<pointcache_rec> &recs);
+  // secondary: true when a dump is to be asked (not synced and no ask in
+  // the last seconds)
+  bool needSync();
+  void resetSync() { mSynced = false; } // becoming secondary
+
+private:
+  QUdpSocket *mUdps;
+  QHostAddress mHostDual;
+  quint16 mPort;
+  uint32_t mSeq;   // next message sent
+  uint32_t mRxSeq; // next message expected
+  bool mSynced;    // received a dump and no gap since
+  QElapsedTimer mSyncAsked;
+  std::vector<pointcache_rec> mDump; // dump being sent
+  size_t mDumpPos;
+  QTimer *mDumpTimer;
+  uint64_t mRecords;
+  void send(const pointcache_rec *recs, unsigned n, uint32_t flags);
+  void dumpTick();
+};
+
+#endif // I104M_H
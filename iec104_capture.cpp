@@ -0,0 +1,108 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_capture.h"
+#include <stdio.h>
+
+iec104_capture_writer::iec104_capture_writer() {
+  mBase = nullptr;
+  mHdr = nullptr;
+  mSize = 0;
+  mPos = 0;
+}
+
+bool iec104_capture_writer::open(const std::string &path, uint64_t maxbytes) {
+  close();
+  if (maxbytes < sizeof(capture_header) + 4096)
+    maxbytes = sizeof(capture_header) + 4096;
+  if (!mFile.open(path, maxbytes, true))
+    return false;
+
+  mBase = mFile.data();
+  mSize = maxbytes;
+  mHdr = reinterpret_cast<capture_header *>(mBase);
+  memset(mHdr, 0, sizeof(*mHdr));
+  memcpy(mHdr->magic, "I104CAP1", 8);
+  mHdr->version = 1;
+  mHdr->hdrsize = sizeof(capture_header);
+  mHdr->start_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::system_clock::now().time_since_epoch()).count();
+  mPos = sizeof(capture_header);
+  mStart = std::chrono::steady_clock::now();
+  return true;
+}
+
+// the file is cut to the recorded size
+void iec104_capture_writer::close() {
+  if (mBase == nullptr)
+    return;
+  mFile.close(mPos);
+  mBase = nullptr;
+  mHdr = nullptr;
+}
+
+bool iec104_capture_reader::open(const std::string &path) {
+  mData.clear();
+  mPos = 0;
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == nullptr)
+    return false;
+  bool ok = fread(&mHdr, sizeof(mHdr), 1, f) == 1 && memcmp(mHdr.magic, "I104CAP1", 8) == 0 &&
+            mHdr.hdrsize >= sizeof(mHdr) && fseek(f, long(mHdr.hdrsize), SEEK_SET) == 0;
+  if (ok) {
+    // records up to the used size (a capture not closed is still a full file)
+    mData.resize(size_t(mHdr.used));
+    mData.resize(fread(mData.data(), 1, mData.size(), f));
+  }
+  fclose(f);
+  return ok;
+}
+
+bool iec104_capture_reader::peek(frame &f) {
+  if (mPos + sizeof(capture_rec) > mData.size())
+    return false;
+  const capture_rec *r = reinterpret_cast<const capture_rec *>(mData.data() + mPos);
+  if (mPos + sizeof(capture_rec) + r->size > mData.size())
+    return false;
+  f.t_ns = r->t_ns;
+  f.is_send = r->is_send != 0;
+  f.size = r->size;
+  f.data = reinterpret_cast<const char *>(r + 1);
+  return true;
+}
+
+bool iec104_capture_reader::next(frame &f) {
+  if (!peek(f)) {
+    mPos = mData.size();
+    return false;
+  }
+  mPos += sizeof(capture_rec) + f.size;
+  return true;
+}
@@ -0,0 +1,125 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_CAPTURE_H
+#define IEC104_CAPTURE_H
+
+// IEC 60870-5-104 BINARY CAPTURE OF APDUS (RECORD AND REPLAY)
+// File: capture_header, then one capture_rec + the frame bytes per frame, in
+// time order. The writer maps a preallocated file, a record is a memcpy (no
+// formatting); the file is cut to the recorded size when closed.
+
+#include <stdint.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "iec104_mapfile.h"
+
+#pragma pack(push)
+#pragma pack(1)
+
+struct capture_header {
+  char magic[8];     // "I104CAP1"
+  uint32_t version;  // 1
+  uint32_t hdrsize;  // bytes of this header, records follow
+  int64_t start_us;  // wall clock of the start, us since epoch
+  uint64_t used;     // bytes of records
+  uint64_t dropped;  // frames not recorded, file full
+};
+
+struct capture_rec {
+  uint64_t t_ns;    // monotonic time since the start
+  uint16_t size;    // frame bytes following
+  uint8_t is_send;  // 0: received, 1: sent
+  uint8_t res;
+};
+
+#pragma pack(pop)
+
+class iec104_capture_writer {
+public:
+  iec104_capture_writer();
+  ~iec104_capture_writer() { close(); }
+  // creates (truncates) path with maxbytes preallocated and mapped
+  bool open(const std::string &path, uint64_t maxbytes);
+  void close();
+  bool isOpen() const { return mFile.isOpen(); }
+  uint64_t dropped() const { return mHdr ? mHdr->dropped : 0; }
+
+  void record(const void *frame, unsigned size, bool is_send) {
+    uint64_t need = sizeof(capture_rec) + size;
+    if (mPos + need > mSize) {
+      mSize = mPos; // full, the frames after are dropped too (no holes)
+      mHdr->dropped++;
+      return;
+    }
+    capture_rec *r = reinterpret_cast<capture_rec *>(mBase + mPos);
+    r->t_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - mStart).count());
+    r->size = uint16_t(size);
+    r->is_send = is_send;
+    r->res = 0;
+    memcpy(r + 1, frame, size);
+    mPos += need;
+    mHdr->used = mPos - sizeof(capture_header);
+  }
+
+private:
+  iec104_mapfile mFile;
+  char *mBase;
+  capture_header *mHdr;
+  uint64_t mSize; // bytes for records, up to the mapped size
+  uint64_t mPos;
+  std::chrono::steady_clock::time_point mStart;
+};
+
+class iec104_capture_reader {
+public:
+  struct frame {
+    uint64_t t_ns;
+    bool is_send;
+    unsigned size;
+    const char *data;
+  };
+  bool open(const std::string &path); // reads the whole capture
+  const capture_header &header() const { return mHdr; }
+  bool next(frame &f); // false at the end
+  bool peek(frame &f); // the next frame, without advancing
+  void rewind() { mPos = 0; }
+  bool atEnd() const { return mPos >= mData.size(); }
+
+private:
+  capture_header mHdr;
+  std::vector<char> mData; // records
+  size_t mPos = 0;
+};
+
+#endif // IEC104_CAPTURE_H
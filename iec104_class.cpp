@@ -27,6 +27,7 @@
  * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -35,128 +36,178 @@
 #include <sstream>
 
 #include "iec104_class.h"
+#include "iec104_pointcache.h"
+#include "iec104_cmdtrack.h"
+#include "iec104_deadband.h"
+#include "iec104_soe.h"
 
 using namespace std;
 
+namespace {
+
+// names of the type identifications and of the causes of transmission
+struct code_name {
+  int code;
+  const char* name;
+};
+
+const code_name tiNames[] = {
+  { 0, "M_UNDEF" },
+  { 1, "M_SP_NA_1" },
+  { 2, "M_SP_TA_1" },
+  { 3, "M_DP_NA_1" },
+  { 4, "M_DP_TA_1" },
+  { 5, "M_ST_NA_1" },
+  { 6, "M_ST_TA_1" },
+  { 7, "M_BO_NA_1" },
+  { 8, "M_BO_TA_1" },
+  { 9, "M_ME_NA_1" },
+  { 10, "M_ME_TA_1" },
+  { 11, "M_ME_NB_1" },
+  { 12, "M_ME_TB_1" },
+  { 13, "M_ME_NC_1" },
+  { 14, "M_ME_TC_1" },
+  { 15, "M_IT_NA_1" },
+  { 16, "M_IT_TA_1" },
+  { 17, "M_EP_TA_1" },
+  { 18, "M_EP_TB_1" },
+  { 19, "M_EP_TC_1" },
+  { 20, "M_PS_NA_1" },
+  { 21, "M_ME_ND_1" },
+  { 30, "M_SP_TB_1" },
+  { 31, "M_DP_TB_1" },
+  { 32, "M_ST_TB_1" },
+  { 33, "M_BO_TB_1" },
+  { 34, "M_ME_TD_1" },
+  { 35, "M_ME_TE_1" },
+  { 36, "M_ME_TF_1" },
+  { 37, "M_IT_TB_1" },
+  { 38, "M_EP_TD_1" },
+  { 39, "M_EP_TE_1" },
+  { 40, "M_EP_TF_1" },
+  { 45, "C_SC_NA_1" },
+  { 46, "C_DC_NA_1" },
+  { 47, "C_RC_NA_1" },
+  { 48, "C_SE_NA_1" },
+  { 49, "C_SE_NB_1" },
+  { 50, "C_SE_NC_1" },
+  { 51, "C_BO_NA_1" },
+  { 58, "C_SC_TA_1" },
+  { 59, "C_DC_TA_1" },
+  { 60, "C_RC_TA_1" },
+  { 61, "C_SE_TA_1" },
+  { 62, "C_SE_TB_1" },
+  { 63, "C_SE_TC_1" },
+  { 64, "C_BO_TA_1" },
+  { 70, "M_EI_NA_1" },
+  { 100, "C_IC_NA_1" },
+  { 101, "C_CI_NA_1" },
+  { 102, "C_RD_NA_1" },
+  { 103, "C_CS_NA_1" },
+  { 104, "C_TS_NA_1" },
+  { 105, "C_RP_NA_1" },
+  { 106, "C_CD_NA_1" },
+  { 107, "C_TS_TA_1" },
+  { 110, "P_ME_NA_1" },
+  { 111, "P_ME_NB_1" },
+  { 112, "P_ME_NC_1" },
+  { 113, "P_AC_NA_1" },
+  { 120, "F_FR_NA_1" },
+  { 121, "F_SR_NA_1" },
+  { 122, "F_SC_NA_1" },
+  { 123, "F_LS_NA_1" },
+  { 124, "F_FA_NA_1" },
+  { 125, "F_SG_NA_1" },
+  { 126, "F_DR_TA_1" },
+};
+
+const code_name causeNames[] = {
+  { 0, "UNUSED" },
+  { 1, "CYCLIC" },
+  { 2, "BACKGND" },
+  { 3, "SPONT" },
+  { 4, "INIT" },
+  { 5, "REQ" },
+  { 6, "ACT" },
+  { 7, "ACT_CON" },
+  { 8, "DEACT" },
+  { 9, "DEACT_CON" },
+  { 10, "ACT_TERM" },
+  { 11, "RETREM" },
+  { 12, "RETLOC" },
+  { 13, "FILE" },
+  { 14, "COT_14" },
+  { 15, "COT_15" },
+  { 16, "COT_16" },
+  { 17, "COT_17" },
+  { 18, "COT_18" },
+  { 19, "COT_19" },
+  { 20, "INROGEN" },
+  { 21, "INRO1" },
+  { 22, "INRO2" },
+  { 23, "INRO3" },
+  { 24, "INRO4" },
+  { 25, "INRO5" },
+  { 26, "INRO6" },
+  { 27, "INRO7" },
+  { 28, "INRO8" },
+  { 29, "INRO9" },
+  { 30, "INRO10" },
+  { 31, "INRO11" },
+  { 32, "INRO12" },
+  { 33, "INRO13" },
+  { 34, "INRO14" },
+  { 35, "INRO15" },
+  { 36, "INRO16" },
+  { 37, "REQCOGEN" },
+  { 38, "REQCO1" },
+  { 39, "REQCO2" },
+  { 40, "REQCO3" },
+  { 41, "REQCO4" },
+  { 42, "COT_42" },
+  { 43, "COT_43" },
+  { 44, "UNKNOWN_TYPE" },
+  { 45, "UNKNOWN_CAUSE" },
+  { 46, "UNKNOWN_ASDU_ADDR" },
+  { 47, "UNKNOWN_OBJ_ADDR" },
+};
+
+// direct lookup of the names above, no map search on the log path
+struct name_tables {
+  const char* ti[256];
+  const char* cause[64];
+  name_tables() {
+    for (int i = 0; i < 256; i++)
+      ti[i] = i < 127 ? "STD_RESERVED" : "USER_RESERVED";
+    for (int i = 0; i < 64; i++)
+      cause[i] = "COT_?";
+    for (const code_name& n : tiNames)
+      ti[n.code] = n.name;
+    for (const code_name& n : causeNames)
+      cause[n.code] = n.name;
+  }
+};
+
+const name_tables& names() {
+  static const name_tables tables;
+  return tables;
+}
+
+template <size_t N> std::map<int, std::string> nameMap(const code_name (&tab)[N]) {
+  std::map<int, std::string> m;
+  for (const code_name& n : tab)
+    m[n.code] = n.name;
+  return m;
+}
+
+} // namespace
+
+const std::map<int, std::string> iec104_class::mapTiStr = nameMap(tiNames);
+const std::map<int, std::string> iec104_class::mapCauseStr = nameMap(causeNames);
+
 iec104_class::iec104_class() {
   strncpy(slaveIP, "", 20);
-
-  mapTiStr[0] = "M_UNDEF";
-  mapTiStr[1] = "M_SP_NA_1";
-  mapTiStr[2] = "M_SP_TA_1";
-  mapTiStr[3] = "M_DP_NA_1";
-  mapTiStr[4] = "M_DP_TA_1";
-  mapTiStr[5] = "M_ST_NA_1";
-  mapTiStr[6] = "M_ST_TA_1";
-  mapTiStr[7] = "M_BO_NA_1";
-  mapTiStr[8] = "M_BO_TA_1";
-  mapTiStr[9] = "M_ME_NA_1";
-  mapTiStr[10] = "M_ME_TA_1";
-  mapTiStr[11] = "M_ME_NB_1";
-  mapTiStr[12] = "M_ME_TB_1";
-  mapTiStr[13] = "M_ME_NC_1";
-  mapTiStr[14] = "M_ME_TC_1";
-  mapTiStr[15] = "M_IT_NA_1";
-  mapTiStr[16] = "M_IT_TA_1";
-  mapTiStr[17] = "M_EP_TA_1";
-  mapTiStr[18] = "M_EP_TB_1";
-  mapTiStr[19] = "M_EP_TC_1";
-  mapTiStr[20] = "M_PS_NA_1";
-  mapTiStr[21] = "M_ME_ND_1";
-  mapTiStr[30] = "M_SP_TB_1";
-  mapTiStr[31] = "M_DP_TB_1";
-  mapTiStr[32] = "M_ST_TB_1";
-  mapTiStr[33] = "M_BO_TB_1";
-  mapTiStr[34] = "M_ME_TD_1";
-  mapTiStr[35] = "M_ME_TE_1";
-  mapTiStr[36] = "M_ME_TF_1";
-  mapTiStr[37] = "M_IT_TB_1";
-  mapTiStr[38] = "M_EP_TD_1";
-  mapTiStr[39] = "M_EP_TE_1";
-  mapTiStr[40] = "M_EP_TF_1";
-  mapTiStr[45] = "C_SC_NA_1";
-  mapTiStr[46] = "C_DC_NA_1";
-  mapTiStr[47] = "C_RC_NA_1";
-  mapTiStr[48] = "C_SE_NA_1";
-  mapTiStr[49] = "C_SE_NB_1";
-  mapTiStr[50] = "C_SE_NC_1";
-  mapTiStr[51] = "C_BO_NA_1";
-  mapTiStr[58] = "C_SC_TA_1";
-  mapTiStr[59] = "C_DC_TA_1";
-  mapTiStr[60] = "C_RC_TA_1";
-  mapTiStr[61] = "C_SE_TA_1";
-  mapTiStr[62] = "C_SE_TB_1";
-  mapTiStr[63] = "C_SE_TC_1";
-  mapTiStr[64] = "C_BO_TA_1";
-  mapTiStr[70] = "M_EI_NA_1";
-  mapTiStr[100] = "C_IC_NA_1";
-  mapTiStr[101] = "C_CI_NA_1";
-  mapTiStr[102] = "C_RD_NA_1";
-  mapTiStr[103] = "C_CS_NA_1";
-  mapTiStr[104] = "C_TS_NA_1";
-  mapTiStr[105] = "C_RP_NA_1";
-  mapTiStr[106] = "C_CD_NA_1";
-  mapTiStr[107] = "C_TS_TA_1";
-  mapTiStr[110] = "P_ME_NA_1";
-  mapTiStr[111] = "P_ME_NB_1";
-  mapTiStr[112] = "P_ME_NC_1";
-  mapTiStr[113] = "P_AC_NA_1";
-  mapTiStr[120] = "F_FR_NA_1";
-  mapTiStr[121] = "F_SR_NA_1";
-  mapTiStr[122] = "F_SC_NA_1";
-  mapTiStr[123] = "F_LS_NA_1";
-  mapTiStr[124] = "F_FA_NA_1";
-  mapTiStr[125] = "F_SG_NA_1";
-  mapTiStr[126] = "F_DR_TA_1";
-
-  mapCauseStr[0] = "UNUSED";
-  mapCauseStr[1] = "CYCLIC";
-  mapCauseStr[2] = "BACKGND";
-  mapCauseStr[3] = "SPONT";
-  mapCauseStr[4] = "INIT";
-  mapCauseStr[5] = "REQ";
-  mapCauseStr[6] = "ACT";
-  mapCauseStr[7] = "ACT_CON";
-  mapCauseStr[8] = "DEACT";
-  mapCauseStr[9] = "DEACT_CON";
-  mapCauseStr[10] = "ACT_TERM";
-  mapCauseStr[11] = "RETREM";
-  mapCauseStr[12] = "RETLOC";
-  mapCauseStr[13] = "FILE";
-  mapCauseStr[14] = "COT_14";
-  mapCauseStr[15] = "COT_15";
-  mapCauseStr[16] = "COT_16";
-  mapCauseStr[17] = "COT_17";
-  mapCauseStr[18] = "COT_18";
-  mapCauseStr[19] = "COT_19";
-  mapCauseStr[20] = "INROGEN";
-  mapCauseStr[21] = "INRO1";
-  mapCauseStr[22] = "INRO2";
-  mapCauseStr[23] = "INRO3";
-  mapCauseStr[24] = "INRO4";
-  mapCauseStr[25] = "INRO5";
-  mapCauseStr[26] = "INRO6";
-  mapCauseStr[27] = "INRO7";
-  mapCauseStr[28] = "INRO8";
-  mapCauseStr[29] = "INRO9";
-  mapCauseStr[30] = "INRO10";
-  mapCauseStr[31] = "INRO11";
-  mapCauseStr[32] = "INRO12";
-  mapCauseStr[33] = "INRO13";
-  mapCauseStr[34] = "INRO14";
-  mapCauseStr[35] = "INRO15";
-  mapCauseStr[36] = "INRO16";
-  mapCauseStr[37] = "REQCOGEN";
-  mapCauseStr[38] = "REQCO1";
-  mapCauseStr[39] = "REQCO2";
-  mapCauseStr[40] = "REQCO3";
-  mapCauseStr[41] = "REQCO4";
-  mapCauseStr[42] = "COT_42";
-  mapCauseStr[43] = "COT_43";
-  mapCauseStr[44] = "UNKNOWN_TYPE";
-  mapCauseStr[45] = "UNKNOWN_CAUSE";
-  mapCauseStr[46] = "UNKNOWN_ASDU_ADDR";
-  mapCauseStr[47] = "UNKNOWN_OBJ_ADDR";
+  strncpy(slaveIP_backup, "", 20);
 
   Port = 2404;
 
@@ -164,12 +215,15 @@ iec104_class::iec104_class() {
   seq_order_check = true;
   connectedTCP = false;
 
-  tout_startdtact = -1;
-  tout_supervisory = -1;
-  tout_testfr = -1;
-  tout_gi = -1;
   VS = 0;
   VR = 0;
+  ackVS = 0;
+  rx_unack = 0;
+  t1_ack = 15000;
+  t2_supervisory = 8000;
+  t3_testfr = 10000;
+  k_unack = 12;
+  w_ack = 8;
   TxOk = false;
   masterAddress = 0;
   slaveAddress = 0;
@@ -179,25 +233,15 @@ iec104_class::iec104_class() {
 }
 
 string iec104_class::asduTiStr(int ti) {
-  string s = "";
-  map<int, string>::const_iterator iter = mapTiStr.find(ti);
-  if (iter != mapTiStr.end()) {
-    s = iter->second;
-  }
-  if (s == "" && ti >= 127)
-    s = "USER_RESERVED";
-  else if (s == "" && ti < 127)
-    s = "STD_RESERVED";
-  return s;
+  if (ti >= 0 && ti < 256)
+    return names().ti[ti];
+  return ti >= 127 ? "USER_RESERVED" : "STD_RESERVED";
 }
 
 string iec104_class::causeStr(int cause) {
-  string s = "COT_?";
-  map<int, string>::const_iterator iter = mapCauseStr.find(cause);
-  if (iter != mapCauseStr.end()) {
-    s = iter->second;
-  }
-  return s;
+  if (cause >= 0 && cause < 64)
+    return names().cause[cause];
+  return "COT_?";
 }
 
 void iec104_class::disableSequenceOrderCheck() {
@@ -212,6 +256,36 @@ void iec104_class::setGIPeriod(unsigned period) {
   gi_period = int(period);
 }
 
+void iec104_class::setWindow(unsigned k, unsigned w) {
+  k_unack = k < 1 ? 1 : (k > 32767 ? 32767 : k);
+  w_ack = w < 1 ? 1 : (w > k_unack ? k_unack : w);
+}
+
+// seconds to ms, at least 10 ms
+static int timeoutMs(double seconds) {
+  return seconds < 0.01 ? 10 : (seconds > 2000000 ? 2000000000 : int(seconds * 1000 + 0.5));
+}
+
+void iec104_class::setTimeouts(double t1, double t2, double t3) {
+  t1_ack = timeoutMs(t1);
+  t2_supervisory = timeoutMs(t2);
+  t3_testfr = timeoutMs(t3);
+}
+
+void iec104_class::setTimerWheel(iec104_timerwheel* wheel) {
+  stopTimers();
+  timers = wheel != nullptr ? wheel : &ownTimers;
+}
+
+void iec104_class::stopTimers() {
+  timers->cancel(tmStartDT);
+  timers->cancel(tmAck);
+  timers->cancel(tmSupervisory);
+  timers->cancel(tmTestFr);
+  timers->cancel(tmGI);
+  timers->cancel(tmCmd);
+}
+
 void iec104_class::setPortTCP(unsigned port) {
   Port = port;
 }
@@ -252,78 +326,208 @@ int iec104_class::getPrimaryAddress() {
   return masterAddress;
 }
 
-void iec104_class::onConnectTCP() {
+void iec104_class::onConnectTCP(bool started) {
   connectedTCP = true;
   TxOk = false;
   VS = 0;
   VR = 0;
+  ackVS = 0;
+  rx_unack = 0;
+  timers->cancel(tmAck);
+  txQueue.clear();
+  txBuf.clear();
   test_command_count = 0;
+  rxFramer.clear();
   mLog.pushMsg("*** TCP CONNECT!");
-  sendStartDTACT();
+  if (!started) {
+    sendStartDTACT();
+    return;
+  }
+  // STARTDT exchanged by the user (connect racing), accounted as done here
+  iec_apdu apdu;
+  apdu.start = START;
+  apdu.length = 4;
+  apdu.NS = STARTDTACT;
+  apdu.NR = 0;
+  if (frameCapture)
+    frameCapture->record(&apdu, 6, true);
+  if (mLog.willLog())
+    LogFrame(reinterpret_cast<char*>(&apdu), 6, true);
+  stats.uTx++;
+  mLog.pushMsg("     STARTDTACT");
+  apdu.NS = STARTDTCON;
+  if (frameCapture)
+    frameCapture->record(&apdu, 6, false);
+  if (mLog.willLog())
+    LogFrame(reinterpret_cast<char*>(&apdu), 6, false);
+  stats.uRx++;
+  mLog.pushMsg("     STARTDTCON");
+  startDTConfirmed();
+  armTimer(tmTestFr, t3_testfr);
+}
+
+void iec104_class::startDTConfirmed() {
+  timers->cancel(tmStartDT); // not to timeout
+  TxOk = true;
+  linkUpMs = nowUs() / 1000;
+  armTimer(tmGI, gi_startup_time * 1000); // request GI when communication starts
+  gi_startup = true;
 }
 
 void iec104_class::onDisconnectTCP() {
   connectedTCP = false;
-  tout_startdtact = -1;
-  tout_supervisory = -1;
-  tout_gi = -1;
+  stopTimers();
+  gi_startup = false;
+  giSched.clear();
+  giTime = stats_clock::time_point();
+  if (cmdTrack)
+    cmdTrack->clear();
+  if (TxOk)
+    linkDownMs = nowUs() / 1000;
   TxOk = false;
+  txQueue.clear();
+  txBuf.clear();
+  rxFramer.clear();
   mLog.pushMsg("*** TCP DISCONNECT!");
 }
 
-void iec104_class::onTimerSecond() {
+// timeout of STARTDTACT: retry
+void iec104_class::startDTTimeout() {
+  if (connectedTCP)
+    sendStartDTACT();
+}
+
+// t1: sent I-frames not acknowledged, close the connection
+void iec104_class::ackTimeout() {
+  if (!connectedTCP)
+    return;
+  mLog.pushMsg("*** T1 TIMEOUT, I-FRAMES NOT ACKNOWLEDGED! ****");
+  disconnectTCP();
+}
+
+// t2: received I-frames not acknowledged, send an S-frame unless an I-frame
+// sent since then carried the NR
+void iec104_class::supervisoryTimeout() {
+  if (connectedTCP && rx_unack > 0)
+    sendSupervisory();
+}
+
+// t3: no frame received, send TESTFRACT
+void iec104_class::testFrTimeout() {
+  if (!connectedTCP || !TxOk)
+    return;
   iec_apdu apdu;
+  apdu.start = START;
+  apdu.length = 4;
+  apdu.NS = TESTFRACT;
+  apdu.NR = 0;
+  sendFrame(&apdu, 6);
+  mLog.pushMsg("     TESTFRACT");
+}
 
-  if (connectedTCP) {
-    if (tout_startdtact > 0)
-      tout_startdtact--;
-    if (tout_startdtact == 0)  // timeout of startdtact: retry
-      sendStartDTACT();
+// gi_period, or gi_retry_time without progress of the GI in progress: only
+// its interrogations not terminated are sent again
+void iec104_class::giTimeout() {
+  if (!connectedTCP)
+    return;
+  if (gi_startup) {
+    startupInterrogation();
+  } else if (giSched.active()) {
+    char buflog[100];
+    sprintf(buflog, "     INTERROGATION TIMEOUT, %u AGAIN", giSched.timeout());
+    mLog.pushMsg(buflog);
+    giPump();
+    armTimer(tmGI, int64_t(giSched.active() ? gi_retry_time : gi_period) * 1000);
+  } else {
+    solicitGI();
+  }
+}
 
-    if (tout_gi > 0) {
-      tout_gi--;
-      if (tout_gi == 0) {
-        solicitGI();
-      }
+// commands without ACTCON in the timeout get a negative ACTCON of the master
+// (so that I104M is answered), executes without ACTTERM (optional for most
+// TIs) and confirmed selects never executed are forgotten silently
+void iec104_class::cmdTimeout() {
+  if (cmdTrack == nullptr)
+    return;
+  std::vector<iec104_command> expired;
+  cmdTrack->expire(monoUs(), expired);
+  armCmdTimer();
+  for (const iec104_command &c : expired)
+    if (!c.confirmed) {
+      char buflog[100];
+      stats.cmdTimeouts++;
+      sprintf(buflog, "     COMMAND TIMEOUT, TI %u CA %u ADDRESS %u", unsigned(c.cmd.type),
+              unsigned(c.cmd.ca), unsigned(c.cmd.address));
+      mLog.pushMsg(buflog);
+      iec_obj resp = c.cmd;
+      resp.cause = ACTCONFIRM;
+      resp.pn = NEGATIVE;
+      commandActRespIndication(&resp);
     }
+}
 
-    if (msg_supervisory) {
-      if (tout_supervisory > 0)
-        tout_supervisory--;
-      if (tout_supervisory > 0)
-        tout_supervisory--;
+void iec104_class::armCmdTimer() {
+  int64_t d = cmdTrack->nextDeadline();
+  if (d < 0)
+    timers->cancel(tmCmd);
+  else
+    timers->arm(tmCmd, d / 1000 + 1);
+}
 
-      if (tout_supervisory == 0) {
-        tout_supervisory = -1;
-        sendSupervisory();
-      }
+void iec104_class::commandResponse(iec_obj *obj) {
+  if (cmdTrack != nullptr && iec104_cmdtracker::tracked(obj->type)) {
+    int64_t us = 0;
+    iec104_command c;
+    switch (cmdTrack->response(*obj, monoUs(), us, c)) {
+      case iec104_cmdtracker::UNMATCHED:
+        stats.cmdUnmatched++;
+        break;
+      case iec104_cmdtracker::SELECTED:
+        stats.cmdConUs.add(uint64_t(us));
+        if (c.autoExecute) {
+          c.cmd.se = EXECUTE;
+          sendCommand(&c.cmd);
+        }
+        break;
+      case iec104_cmdtracker::CONFIRMED:
+        stats.cmdConUs.add(uint64_t(us));
+        if (obj->pn == NEGATIVE)
+          stats.cmdNegative++;
+        break;
+      case iec104_cmdtracker::TERMINATED:
+        stats.cmdTermUs.add(uint64_t(us));
+        break;
     }
+    armCmdTimer();
   }
+  commandActRespIndication(obj);
+}
 
-  // if connected and no data received, send TESTFRACT
-  if (connectedTCP && TxOk) {
-    if (tout_testfr > 0) {
-      tout_testfr--;
-      if (tout_testfr == 0) {
-        apdu.start = START;
-        apdu.length = 4;
-        apdu.NS = TESTFRACT;
-        apdu.NR = 0;
-        sendTCP(reinterpret_cast<char*>(&apdu), 6);
-        mLog.pushMsg("     TESTFRACT");
-      }
-    }
-  }
+// station interrogation, or the groups of setGIGroups
+void iec104_class::solicitGI() {
+  giSched.start();
+  giTime = stats_clock::time_point();
+  GIObjectCnt = 0;
+  giPump();
+  armTimer(tmGI, gi_retry_time * 1000);
+}
 
+void iec104_class::giPump() {
+  int qoi;
+  while ((qoi = giSched.next()) >= 0)
+    sendInterrogation(qoi);
+  stats.giDone = giSched.done();
+  stats.giTotal = giSched.total();
+  stats.giObjects = giSched.received();
+  stats.giExpected = giSched.expected();
+  stats.giRetries = giSched.retries();
 }
 
-void iec104_class::solicitGI() {
+void iec104_class::sendInterrogation(int qoi) {
   iec_apdu wapdu;
 
   wapdu.start = START;
   wapdu.length = 0x0E;
-  wapdu.NS = VS;
-  wapdu.NR = VR;
   wapdu.asduh.type = INTERROGATION;
   wapdu.asduh.num = 1;
   wapdu.asduh.sq = 0;
@@ -335,38 +539,59 @@ void iec104_class::solicitGI() {
   wapdu.dados[0] = 0x00;
   wapdu.dados[1] = 0x00;
   wapdu.dados[2] = 0x00;
-  wapdu.dados[3] = 0x14;
-  sendTCP(reinterpret_cast<char*>(&wapdu), 16);
-  VS += 2;
-  mLog.pushMsg("    GENERAL INTERROGATION ");
-  tout_gi = gi_retry_time;
+  wapdu.dados[3] = char(qoi);
+  sendIFrame(&wapdu, 16);
+  if (qoi == 20) {
+    mLog.pushMsg("    GENERAL INTERROGATION ");
+  } else {
+    char buflog[100];
+    sprintf(buflog, "     INTERROGATION GROUP %d", qoi - 20);
+    mLog.pushMsg(buflog);
+  }
 }
 
-void iec104_class::solicitInterrogation(char group) {
-  iec_apdu wapdu;
+void iec104_class::setPointCache(iec104_pointcache* pc, unsigned staleSeconds) {
+  pointCache = pc;
+  cache_stale = staleSeconds;
+}
 
-  wapdu.start = START;
-  wapdu.length = 0x0E;
-  wapdu.NS = VS;
-  wapdu.NR = VR;
-  wapdu.asduh.type = INTERROGATION;
-  wapdu.asduh.num = 1;
-  wapdu.asduh.sq = 0;
-  wapdu.asduh.cause = ACTIVATION;
-  wapdu.asduh.t = 0;
-  wapdu.asduh.pn = 0;
-  wapdu.asduh.oa = masterAddress;
-  wapdu.asduh.ca = slaveAddress;
-  wapdu.dados[0] = 0x00;
-  wapdu.dados[1] = 0x00;
-  wapdu.dados[2] = 0x00;
-  wapdu.dados[3] = group;
-  sendTCP(reinterpret_cast<char*>(&wapdu), 16);
-  VS += 2;
-  char buflog[1000];
-  sprintf(buflog, "     INTERROGATION GROUP %d", group);
-  mLog.pushMsg(buflog);
-  tout_gi = gi_retry_time;
+void iec104_class::startupInterrogation() {
+  gi_startup = false;
+  if (pointCache == nullptr || cache_stale == 0 || pointCache->count() == 0) {
+    solicitGI();
+    return;
+  }
+  bool unknown;
+  int64_t now = nowUs() / 1000;
+  int64_t maxage = int64_t(cache_stale) * 1000;
+  // the outage starts when this link was lost or, on the first link of the run
+  // (start, hot standby takeover), at the last update of the cache
+  int64_t down = linkDownMs != 0 ? linkDownMs : pointCache->newest();
+  if (linkUpMs - down > cache_outage_time * 1000 && now - linkUpMs < maxage)
+    maxage = now - linkUpMs;
+  uint32_t groups = pointCache->staleGroups(now, maxage, unknown);
+  if (unknown) {
+    // stale points not known to be of a group
+    solicitGI();
+    return;
+  }
+  if (groups == 0) {
+    mLog.pushMsg("     CACHED POINTS UP TO DATE, NO INTERROGATION");
+    armTimer(tmGI, int64_t(gi_period) * 1000);
+    return;
+  }
+  // the stale groups only, pipelined as the groups of a GI
+  giSched.start(groups);
+  giTime = stats_clock::time_point();
+  GIObjectCnt = 0;
+  giPump();
+  armTimer(tmGI, gi_retry_time * 1000);
+}
+
+// user requested, not tracked by the GI scheduler
+void iec104_class::solicitInterrogation(char group) {
+  sendInterrogation(group);
+  armTimer(tmGI, gi_retry_time * 1000);
 }
 
 void iec104_class::confTestCommand() {
@@ -374,8 +599,6 @@ void iec104_class::confTestCommand() {
 
   wapdu.start = START;
   wapdu.length = 22;
-  wapdu.NS = VS;
-  wapdu.NR = VR;
   wapdu.asduh.type = C_TS_TA_1;
   wapdu.asduh.num = 1;
   wapdu.asduh.sq = 0;
@@ -384,28 +607,13 @@ void iec104_class::confTestCommand() {
   wapdu.asduh.pn = 0;
   wapdu.asduh.oa = masterAddress;
   wapdu.asduh.ca = slaveAddress;
-  time_t tm1 = time(nullptr);
-  tm* agora = localtime(&tm1);
 
   wapdu.asdu107.ioa16 = 0;
   wapdu.asdu107.ioa8 = 0;
   wapdu.asdu107.tsc = 0;
-  wapdu.asdu107.time.year = agora->tm_year % 100;
-  wapdu.asdu107.time.month = static_cast<uint8_t>(agora->tm_mon);
-  wapdu.asdu107.time.mday = static_cast<uint8_t>(agora->tm_mday);
-  wapdu.asdu107.time.hour = static_cast<uint8_t>(agora->tm_hour);
-  wapdu.asdu107.time.min = static_cast<uint8_t>(agora->tm_min);
-  wapdu.asdu107.time.msec = static_cast<uint16_t>(agora->tm_sec * 1000);
-  wapdu.asdu107.time.su = static_cast<uint8_t>(agora->tm_isdst);
-  wapdu.asdu107.time.iv = 0;
-  wapdu.asdu107.time.wday = static_cast<uint8_t>(agora->tm_wday);
-  wapdu.asdu107.time.res1 = 0;
-  wapdu.asdu107.time.res2 = 0;
-  wapdu.asdu107.time.res3 = 0;
-  wapdu.asdu107.time.res4 = 0;
-
-  sendTCP(reinterpret_cast<char*>(&wapdu), 22 + 2);
-  VS += 2;
+  cp56time2aNow(wapdu.asdu107.time);
+
+  sendIFrame(&wapdu, 22 + 2);
 
   mLog.pushMsg("     TEST COMMAND CONF ");
 }
@@ -417,108 +625,181 @@ void iec104_class::sendStartDTACT() {
   apdu.length = 4;
   apdu.NS = STARTDTACT;
   apdu.NR = 0;
-  sendTCP(reinterpret_cast<char*>(&apdu), 6);
+  sendFrame(&apdu, 6);
   mLog.pushMsg("     STARTDTACT");
-  tout_startdtact = t1_startdtact;
+  armTimer(tmStartDT, t1_ack);
 }
 
-// tcp packet ready to be read from connection with the iec104 slave
+// tcp data ready to be read from connection with the iec104 slave
 void iec104_class::packetReadyTCP() {
   iec_apdu apdu;
-  unsigned char* br;
-  br = reinterpret_cast<unsigned char*>(&apdu);
-  int bytesrec;
-  unsigned char byt;
-  int len;
-  char buflog[10000];
-
-  while (true) {
-
-    if (!broken_msg) {
-      // look for a START
-      do {
-        bytesrec = readTCP(reinterpret_cast<char*>(br), 1);
-        if (bytesrec == 0)
-          return;
-        byt = br[0];
-      } while (byt != START);
-      bytesrec = readTCP(reinterpret_cast<char*>(br + 1), 1); // length of apdu
-      if (bytesrec == 0)
-        return;
-    }
-
-    len = br[1];
-    if (len < 4) { // apdu length must be >= 4
-      broken_msg = false;
-      mLog.pushMsg("R--> ERROR: INVALID FRAME");
-      continue;
+  int apdusz;
+  bool readok = true;
+  uint64_t bytesread = 0;
+
+  rxTime = stats_clock::now();
+  rxWallUs = nowUs();
+  while (readok) {
+    // pull everything the socket has, in as few reads as the ring buffer allows
+    int avail = bytesAvailableTCP();
+    while (avail > 0 && rxFramer.freeSpace() > 0) {
+      unsigned contig;
+      char* wp = rxFramer.writePtr(contig);
+      int bytesrec = readTCP(wp, avail < int(contig) ? avail : int(contig));
+      if (bytesrec <= 0) {
+        readok = false;
+        break;
+      }
+      rxFramer.commit(unsigned(bytesrec));
+      avail -= bytesrec;
+      bytesread += unsigned(bytesrec);
     }
 
-    waitBytes(len, 500);
-    bytesrec = readTCP(reinterpret_cast<char*>(br + 2), len); // read the remaining of the apdu
-    if (bytesrec == 0) {
-      mLog.pushMsg("R--> Broken apdu");
-      broken_msg = true;
-      return;
-    } else if (bytesrec < len) {
-      int missing = len - bytesrec;
-      sprintf(buflog, "R--> There should be more to read (%d of %d): ", missing, len);
-      mLog.pushMsg(buflog);
-      waitBytes(missing, 500);
-      int bytesrec2 = readTCP(reinterpret_cast<char*>(br + 2 + bytesrec), missing); // read the remaining of the apdu
-      sprintf(buflog, "R--> Readed more %d", bytesrec2);
-      mLog.pushMsg(buflog);
-      if (bytesrec2 != missing) {
-        mLog.pushMsg("R--> Broken apdu!");
-        broken_msg = true;
-        return;
+    // split out every complete apdu, a partial one stays buffered for the next call
+    while ((apdusz = rxFramer.nextAPDU(&apdu)) != 0) {
+      if (apdusz < 0) {
+        stats.brokenAPDUs++;
+        mLog.pushMsg("R--> ERROR: INVALID FRAME");
+        continue;
       }
-    }
+      if (frameCapture)
+        frameCapture->record(&apdu, unsigned(apdusz), false);
 
-    //if ( apdu.asduh.ca != slaveAddress && apdu.asduh.ca != slaveASDUAddrCmd && len>4 )
-    //  {
-    //  broken_msg=false;
-    //  mLog.pushMsg("R--> ASDU WITH UNEXPECTED ORIGIN! Ignoring...");
-    //  // continue;
-    //  }
+      //if ( apdu.asduh.ca != slaveAddress && apdu.asduh.ca != slaveASDUAddrCmd && apdusz>6 )
+      //  {
+      //  mLog.pushMsg("R--> ASDU WITH UNEXPECTED ORIGIN! Ignoring...");
+      //  // continue;
+      //  }
 
-    broken_msg = false;
+      if (mLog.willLog())
+        LogFrame(reinterpret_cast<char*>(&apdu), apdusz, false);
 
-    if (mLog.isLogging()) {
-      sprintf(buflog, "R--> %03d: ", len + 2);
-      int lim = 100;
-      for (int i = 0; i < len + 2 && i < lim; i++) { // log up to 50 caracteres
-        sprintf(buflog + strlen(buflog), "%02x ", br[i]);
-      }
-      if (len > lim - 2)
-        sprintf(buflog + strlen(buflog), "...");
-      mLog.pushMsg(buflog);
+      userprocAPDU(&apdu, apdusz);
+      parseAPDU(&apdu, apdusz);
+
+      if (!connectedTCP) // apdu processing closed the connection
+        break;
     }
 
-    userprocAPDU(&apdu, len + 2);
-    parseAPDU(&apdu, len + 2);
-    if (bytesAvailableTCP() == 0)
+    if (!connectedTCP || bytesAvailableTCP() == 0)
       break;
   }
+
+  stats.bytesRead += bytesread;
+  stats.readBytes.add(bytesread);
 }
 
+void iec104_class::replayAPDU(iec_apdu* papdu, int sz) {
+  rxTime = stats_clock::now();
+  rxWallUs = nowUs();
+  if (mLog.willLog())
+    LogFrame(reinterpret_cast<char*>(papdu), sz, false);
+  userprocAPDU(papdu, sz);
+  parseAPDU(papdu, sz, false);
+}
 
-void iec104_class::LogFrame(char* frame, int size, bool is_send) {
-  char buflog[10000];
-  char* cp = frame;
 
-  if (mLog.isLogging()) {
-    if (is_send)
-      sprintf(buflog, "T<-- %03d: ", int(size));
-    else
-      sprintf(buflog, "R--> %03d: ", int(size));
-    int lim = 100;
-    for (int i = 0; i < size && i < lim; i++) { // log up to 50 caracteres
-      sprintf(buflog + strlen(buflog), "%02x ", static_cast<unsigned char>(cp[i]));
-    }
-    if (size > lim)
-      sprintf(buflog + strlen(buflog), "...");
-    mLog.pushMsg(buflog);
+namespace {
+
+#pragma pack(push)
+#pragma pack(1)
+// binary log record of a frame, only the logged bytes are queued
+struct log_frame_rec {
+  uint16_t size; // frame size
+  uint8_t is_send;
+  uint8_t data[100]; // log up to 100 bytes
+};
+#pragma pack(pop)
+
+void renderFrame(string& out, const void* rec, unsigned size) {
+  const log_frame_rec* fr = static_cast<const log_frame_rec*>(rec);
+  unsigned n = size - unsigned(offsetof(log_frame_rec, data));
+  char buflog[400];
+  int pos = sprintf(buflog, fr->is_send ? "T<-- %03d: " : "R--> %03d: ", int(fr->size));
+  for (unsigned i = 0; i < n; i++)
+    pos += sprintf(buflog + pos, "%02x ", fr->data[i]);
+  if (fr->size > n)
+    pos += sprintf(buflog + pos, "...");
+  out.append(buflog, unsigned(pos));
+}
+
+void renderASDUHeader(string& out, const void* rec, unsigned /*size*/) {
+  const iec_unit_id* h = static_cast<const iec_unit_id*>(rec);
+  char buf[200];
+  int n = snprintf(buf, sizeof(buf), "     OA %u CA %u TI TYPE %u:%s CAUSE %d:%s SQ %u ITEMS %u%s%s",
+                   unsigned(h->oa), unsigned(h->ca),
+                   unsigned(h->type), names().ti[h->type],
+                   int(h->cause), names().cause[h->cause],
+                   unsigned(h->sq), unsigned(h->num),
+                   h->pn == iec104_class::POSITIVE ? " POSITIVE" : " NEGATIVE",
+                   h->t ? " TEST" : "");
+  out.append(buf, unsigned(n));
+}
+
+// n decimal digits of v, zero padded
+inline char* putDigits(char* p, unsigned v, unsigned n) {
+  for (unsigned i = n; i > 0; i--) {
+    p[i - 1] = char('0' + v % 10);
+    v /= 10;
+  }
+  return p + n;
+}
+
+// " yyyy/mm/dd hh:mm:ss.mmm[.iv][.su]" text of a time tag, returns the end of the text
+char* putTimetagText(char* p, const cp56time2a* t) {
+  *p++ = ' ';
+  p = putDigits(p, t->year + 2000u, 4);
+  *p++ = '/';
+  p = putDigits(p, t->month, 2);
+  *p++ = '/';
+  p = putDigits(p, t->mday, 2);
+  *p++ = ' ';
+  p = putDigits(p, t->hour, 2);
+  *p++ = ':';
+  p = putDigits(p, t->min, 2);
+  *p++ = ':';
+  p = putDigits(p, t->msec / 1000u, 2);
+  *p++ = '.';
+  p = putDigits(p, t->msec % 1000u, 3);
+  if (t->iv) {
+    memcpy(p, ".iv", 3);
+    p += 3;
+  }
+  if (t->su) {
+    memcpy(p, ".su", 3);
+    p += 3;
+  }
+  return p;
+}
+
+// "[address value qualifier timetag] " text of one point, returns the end of the text
+char* putPointText(char* p, int address, double val, const char* qualifier, const cp56time2a* timetag) {
+  if (ceil(val) == val)   // test val for integer whole value
+    p += sprintf(p, "[%d %1.0f %s", address, val, qualifier);
+  else
+    p += sprintf(p, "[%d %1.3f %s", address, val, qualifier);
+
+  while (isspace(p[-1]))
+    p--;
+
+  if (timetag != nullptr)
+    p = putTimetagText(p, timetag);
+  *p++ = ']';
+  *p++ = ' ';
+  *p = 0;
+  return p;
+}
+
+} // namespace
+
+void iec104_class::LogFrame(char* frame, int size, bool is_send) {
+  if (mLog.willLog()) {
+    log_frame_rec rec;
+    unsigned n = size < int(sizeof(rec.data)) ? unsigned(size) : unsigned(sizeof(rec.data));
+    rec.size = uint16_t(size);
+    rec.is_send = is_send;
+    memcpy(rec.data, frame, n);
+    mLog.pushRecord(renderFrame, &rec, unsigned(offsetof(log_frame_rec, data)) + n);
   }
 }
 
@@ -538,39 +819,417 @@ char* iec104_class::trim(char* s) {
 // Log point, write to log when address is -1
 void iec104_class::LogPoint(char* buf, int address, double val, char* qualifier, cp56time2a* timetag) {
 
-  if (mLog.isLogging()) {
+  if (mLog.willLog()) {
     if (address == -1) {
       mLog.pushMsg(buf);
       strcpy(buf, "     ");
       return;
     }
 
-    if (ceil(val) == val)   // test val for integer whole value
-      sprintf(buf + strlen(buf), "[%d %1.0f %s", address, val, qualifier);
-    else
-      sprintf(buf + strlen(buf), "[%d %1.3f %s", address, val, qualifier);
-
-    trim(buf);
-
-    if (timetag != nullptr)
-      sprintf(buf + strlen(buf), " %04d/%02d/%02d %02d:%02d:%02d.%03d%s%s",
-                timetag->year + 2000,
-                timetag->month,
-                timetag->mday,
-                timetag->hour,
-                timetag->min,
-                timetag->msec / 1000,
-                timetag->msec % 1000,
-                timetag->iv ? ".iv" : "",
-                timetag->su ? ".su" : "");
-    sprintf(buf + strlen(buf), "] ");
+    putPointText(buf + strlen(buf), address, val, qualifier ? qualifier : "", timetag);
+  }
+}
+
+// log text of a record of decoded points, rendered when the log is pulled
+void iec104_class::renderPoints(string& out, const void* rec, unsigned size) {
+  const iec_obj* obj = static_cast<const iec_obj*>(rec);
+  for (unsigned i = 0; i < size / sizeof(iec_obj); i++) {
+    const asdu_decoder_entry& dec = decoderTable[obj[i].type];
+    char qual[200], text[512];
+    dec.fmt(qual, &obj[i]);
+    char* end = putPointText(text, int(obj[i].address), obj[i].value, qual,
+                             dec.timetag ? &obj[i].timetag : nullptr);
+    out.append(text, unsigned(end - text));
   }
 }
 
+// ---- table driven decoder of the monitor direction asdus ----------------
+
+static_assert(sizeof(iec_nsq_obj<iec_type1>) == 4, "information objects must be byte aligned");
+static_assert(sizeof(iec_nsq_obj<iec_type38>) == 3 + sizeof(iec_type38), "information objects must be byte aligned");
+
+namespace {
+
+// offset of the first information object in the apdu
+const unsigned asduObjOffset = offsetof(iec_apdu, dados);
+
+// decode of the type specific part of one information object
+template <class T> inline void decodeQuality(iec_obj& o, const T& e) {
+  o.bl = e.bl;
+  o.nt = e.nt;
+  o.sb = e.sb;
+  o.iv = e.iv;
+}
+
+template <class T> inline void decodeSingle(iec_obj& o, const T& e) {
+  o.value = e.sp;
+  o.sp = e.sp;
+  decodeQuality(o, e);
+}
+
+template <class T> inline void decodeDouble(iec_obj& o, const T& e) {
+  o.value = e.dp;
+  o.dp = e.dp;
+  decodeQuality(o, e);
+}
+
+template <class T> inline void decodeStep(iec_obj& o, const T& e) {
+  o.value = e.mv;
+  o.t = e.t;
+  o.ov = e.ov;
+  decodeQuality(o, e);
+}
+
+template <class T> inline void decodeBitstring(iec_obj& o, const T& e) {
+  o.bsi = e.bsi;
+  o.value = double(e.bsi.bsi);
+  o.ov = e.ov;
+  decodeQuality(o, e);
+}
+
+template <class T> inline void decodeMeasured(iec_obj& o, const T& e) {
+  o.value = e.mv;
+  o.ov = e.ov;
+  decodeQuality(o, e);
+}
+
+template <class T> inline void decodeCounter(iec_obj& o, const T& e) {
+  o.bcr = e.bcr;
+  o.value = double(e.bcr);
+  o.cadj = e.ca;
+  o.cy = e.cy;
+  o.sq = e.sq;
+  o.iv = e.iv;
+}
+
+template <class T> inline void decodeProtection(iec_obj& o, const T& e) {
+  decodeQuality(o, e);
+  o.ei = e.ei;
+  o.elapsed_time = e.elapsed;
+  o.timetag = e.time;
+}
+
+inline void decodeObj(iec_obj& o, const iec_type1& e) { decodeSingle(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type3& e) { decodeDouble(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type5& e) { decodeStep(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type7& e) { decodeBitstring(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type9& e) { decodeMeasured(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type11& e) { decodeMeasured(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type13& e) { decodeMeasured(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type15& e) { decodeCounter(o, e); }
+inline void decodeObj(iec_obj& o, const iec_type21& e) { o.value = e.mv; }
+inline void decodeObj(iec_obj& o, const iec_type30& e) { decodeSingle(o, e); o.timetag = e.time; }
+inline void decodeObj(iec_obj& o, const iec_type31& e) { decodeDouble(o, e); o.timetag = e.time; }
+inline void decodeObj(iec_obj& o, const iec_type32& e) { decodeStep(o, e); o.timetag = e.time; }
+inline void decodeObj(iec_obj& o, const iec_type33& e) { decodeBitstring(o, e); o.timetag = e.time; }
+inline void decodeObj(iec_obj& o, const iec_type34& e) { decodeMeasured(o, e); o.timetag = e.time; }
+inline void decodeObj(iec_obj& o, const iec_type35& e) { decodeMeasured(o, e); o.timetag = e.time; }
+inline void decodeObj(iec_obj& o, const iec_type36& e) { decodeMeasured(o, e); o.timetag = e.time; }
+inline void decodeObj(iec_obj& o, const iec_type37& e) { decodeCounter(o, e); o.timetag = e.time; }
+
+inline void decodeObj(iec_obj& o, const iec_type20& e) {
+  o.stcd = e.stcd;
+  o.value = double(e.stcd.st);
+  o.ov = e.ov;
+  decodeQuality(o, e);
+}
+
+inline void decodeObj(iec_obj& o, const iec_type38& e) {
+  o.value = e.es;
+  o.dp = e.es;
+  decodeProtection(o, e);
+}
+
+inline void decodeObj(iec_obj& o, const iec_type39& e) {
+  o.value = e.spe.gs;
+  o.spe = e.spe;
+  decodeProtection(o, e);
+}
+
+inline void decodeObj(iec_obj& o, const iec_type40& e) {
+  o.value = e.oci.gc;
+  o.oci = e.oci;
+  decodeProtection(o, e);
+}
+
+// log text of the qualifiers of one decoded object
+inline void putFlag(char*& p, bool cond, const char* s) {
+  if (cond)
+    while (*s)
+      *p++ = *s++;
+}
+
+inline void putQuality(char*& p, const iec_obj* o) {
+  putFlag(p, o->bl, "bl ");
+  putFlag(p, o->nt, "nt ");
+  putFlag(p, o->sb, "sb ");
+  putFlag(p, o->iv, "iv ");
+}
+
+// n bits of v, first bit first, in groups of 4
+inline void putBits(char*& p, uint32_t v, int n) {
+  for (int i = 0; i < n; i++) {
+    if (i != 0 && i % 4 == 0)
+      *p++ = ' ';
+    *p++ = char('0' + ((v >> i) & 1));
+  }
+}
+
+int fmtSingle(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putFlag(p, true, o->sp ? "on " : "off ");
+  putQuality(p, o);
+  *p = 0;
+  return int(p - buf);
+}
+
+int fmtDouble(char* buf, const iec_obj* o) {
+  static const char* dblmsg[] = { "tra ", "off ", "on ", "ind " };
+  char* p = buf;
+  putFlag(p, true, dblmsg[o->dp]);
+  putQuality(p, o);
+  *p = 0;
+  return int(p - buf);
+}
+
+int fmtStep(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putFlag(p, o->t, "t ");
+  putFlag(p, o->ov, "ov ");
+  putQuality(p, o);
+  *p = 0;
+  return int(p - buf);
+}
+
+int fmtMeasured(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putFlag(p, o->ov, "ov ");
+  putQuality(p, o);
+  *p = 0;
+  return int(p - buf);
+}
+
+int fmtNoQuality(char* buf, const iec_obj* /*o*/) {
+  buf[0] = 0;
+  return 0;
+}
+
+int fmtBitstring(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putFlag(p, o->ov, "ov ");
+  putQuality(p, o);
+  putFlag(p, true, " ST ");
+  putBits(p, o->bsi.bsi, 32);
+  putFlag(p, true, " [1-32]");
+  *p = 0;
+  return int(p - buf);
+}
+
+int fmtPacked(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putFlag(p, o->ov, "ov ");
+  putQuality(p, o);
+  putFlag(p, true, " ST ");
+  putBits(p, o->stcd.st, 16);
+  putFlag(p, true, " CH ");
+  putBits(p, o->stcd.cd, 16);
+  putFlag(p, true, " [1-16]");
+  *p = 0;
+  return int(p - buf);
+}
+
+int fmtCounter(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putFlag(p, o->cadj, "ca ");
+  putFlag(p, o->cy, "cy ");
+  putFlag(p, o->iv, "iv ");
+  p += sprintf(p, "sq=%u", unsigned(o->sq));
+  return int(p - buf);
+}
+
+int fmtProtEvent(char* buf, const iec_obj* o) {
+  static const char* dblmsg[] = { "ind0 ", "off ", "on ", "ind3 " };
+  char* p = buf;
+  putFlag(p, true, dblmsg[o->dp]);
+  putQuality(p, o);
+  putFlag(p, o->ei, "ei ");
+  p += sprintf(p, " %dms", o->elapsed_time.milliseconds);
+  return int(p - buf);
+}
+
+int fmtProtStart(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putQuality(p, o);
+  putFlag(p, o->ei, "ei ");
+  putFlag(p, o->spe.gs, "gs ");
+  putFlag(p, o->spe.sl1, "sl1 ");
+  putFlag(p, o->spe.sl2, "sl2 ");
+  putFlag(p, o->spe.sl3, "sl3 ");
+  putFlag(p, o->spe.sie, "sie ");
+  putFlag(p, o->spe.srd, "srd ");
+  p += sprintf(p, " %dms", o->elapsed_time.milliseconds);
+  return int(p - buf);
+}
+
+int fmtProtOutput(char* buf, const iec_obj* o) {
+  char* p = buf;
+  putQuality(p, o);
+  putFlag(p, o->ei, "ei ");
+  putFlag(p, o->oci.gc, "gc ");
+  putFlag(p, o->oci.cl1, "cl1 ");
+  putFlag(p, o->oci.cl2, "cl2 ");
+  putFlag(p, o->oci.cl3, "cl3 ");
+  p += sprintf(p, " %dms", o->elapsed_time.milliseconds);
+  return int(p - buf);
+}
+
+} // namespace
+
+// decode all information objects of a monitor asdu of type T into objArena, log and indicate them
+template <class T>
+void iec104_class::decodeASDU(iec_apdu* papdu, int sz) {
+  unsigned num = papdu->asduh.num;
+  unsigned avail = sz > int(asduObjOffset) ? unsigned(sz) - asduObjOffset : 0;
+  unsigned needed = papdu->asduh.sq ? 3 + num * sizeof(T) : num * sizeof(iec_nsq_obj<T>);
+
+  if (needed > avail) {
+    stats.brokenAPDUs++;
+    mLog.pushMsg("     ERROR: ASDU TOO SHORT FOR THE NUMBER OF ITEMS");
+    return;
+  }
+  stats_clock::time_point t0 = stats_clock::now();
+
+  // fields common to all the objects of the asdu
+  iec_obj common;
+  memset(&common, 0, sizeof(common));
+  common.ca = papdu->asduh.ca;
+  common.cause = papdu->asduh.cause;
+  common.pn = papdu->asduh.pn;
+  common.test = papdu->asduh.t;
+  common.type = papdu->asduh.type;
+  common.arrival_us = rxWallUs;
+
+  iec_obj* piecarr = objArena;
+  if (papdu->asduh.sq) {
+    // one address, consecutive objects
+    const T* pobj = reinterpret_cast<const T*>(papdu->dados + 3);
+    unsigned int addr24 = papdu->sq1.ioa16 + (unsigned(papdu->sq1.ioa8) << 16);
+    for (unsigned i = 0; i < num; i++) {
+      piecarr[i] = common;
+      piecarr[i].address = addr24++;
+      decodeObj(piecarr[i], pobj[i]);
+    }
+  } else {
+    // each object with its address
+    const iec_nsq_obj<T>* pel = reinterpret_cast<const iec_nsq_obj<T>*>(papdu->dados);
+    for (unsigned i = 0; i < num; i++) {
+      piecarr[i] = common;
+      piecarr[i].address = pel[i].ioa16 + (unsigned(pel[i].ioa8) << 16);
+      decodeObj(piecarr[i], pel[i].obj);
+    }
+  }
+
+  if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36) {
+    GIObjectCnt += num;
+    giSched.objects(papdu->asduh.cause, num);
+    stats.giObjects = giSched.received();
+  }
+
+  stats.objects[papdu->asduh.type] += num;
+  const asdu_decoder_entry& dec = decoderTable[papdu->asduh.type];
+  points.assign(piecarr, num, dec.quality, dec.timetag);
+  if (dec.timetag && num > 0) {
+    // field (RTU clock) to arrival
+    for (unsigned i = 0; i < num; i++)
+      if (points.time_us[i] >= 0)
+        stats.fieldMs.add(rxWallUs > points.time_us[i] ? uint64_t(rxWallUs - points.time_us[i]) / 1000 : 0);
+    if (soeStore)
+      soeStore->append(points);
+  }
+
+  if (mLog.willLog()) {
+    // binary records, formatted only when pulled, all on the same log line
+    for (unsigned i = 0; i < num; i += log_points_rec) {
+      unsigned n = num - i < log_points_rec ? num - i : log_points_rec;
+      mLog.pushRecord(renderPoints, &piecarr[i], unsigned(n * sizeof(iec_obj)), 0, i != 0);
+    }
+  }
+
+  stats_clock::time_point t1 = stats_clock::now();
+  stats.decodeNs.add(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+  stats.indicationUs.add(uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(t1 - rxTime).count()));
+  if (pointCache) {
+    pointCache->update(points, rxWallUs / 1000);
+    cacheIndication(piecarr, num);
+  }
+  if (deadband) {
+    // the consumers get the points that pass the change filter
+    unsigned n = deadband->filter(points, piecarr);
+    stats.filtered += num - n;
+    if (n == 0)
+      return;
+    num = n;
+  }
+  dataIndication(piecarr, num);
+}
+
+constexpr std::array<iec104_class::asdu_decoder_entry, 256> iec104_class::makeDecoderTable() {
+  const uint8_t qualDigital = QUALITY_IV | QUALITY_NT | QUALITY_SB | QUALITY_BL;
+  const uint8_t qualMeasured = qualDigital | QUALITY_OV;
+  const uint8_t qualStep = qualMeasured | QUALITY_T;
+  const uint8_t qualCounter = QUALITY_IV | QUALITY_CY;
+  const uint8_t qualProtection = qualDigital | QUALITY_EI;
+  std::array<asdu_decoder_entry, 256> t{};
+  t[M_SP_NA_1] = { &iec104_class::decodeASDU<iec_type1>, fmtSingle, false, qualDigital };
+  t[M_DP_NA_1] = { &iec104_class::decodeASDU<iec_type3>, fmtDouble, false, qualDigital };
+  t[M_ST_NA_1] = { &iec104_class::decodeASDU<iec_type5>, fmtStep, false, qualStep };
+  t[M_BO_NA_1] = { &iec104_class::decodeASDU<iec_type7>, fmtBitstring, false, qualMeasured };
+  t[M_ME_NA_1] = { &iec104_class::decodeASDU<iec_type9>, fmtMeasured, false, qualMeasured };
+  t[M_ME_NB_1] = { &iec104_class::decodeASDU<iec_type11>, fmtMeasured, false, qualMeasured };
+  t[M_ME_NC_1] = { &iec104_class::decodeASDU<iec_type13>, fmtMeasured, false, qualMeasured };
+  t[M_IT_NA_1] = { &iec104_class::decodeASDU<iec_type15>, fmtCounter, false, qualCounter };
+  t[M_PS_NA_1] = { &iec104_class::decodeASDU<iec_type20>, fmtPacked, false, qualMeasured };
+  t[M_ME_ND_1] = { &iec104_class::decodeASDU<iec_type21>, fmtNoQuality, false, 0 };
+  t[M_SP_TB_1] = { &iec104_class::decodeASDU<iec_type30>, fmtSingle, true, qualDigital };
+  t[M_DP_TB_1] = { &iec104_class::decodeASDU<iec_type31>, fmtDouble, true, qualDigital };
+  t[M_ST_TB_1] = { &iec104_class::decodeASDU<iec_type32>, fmtStep, true, qualStep };
+  t[M_BO_TB_1] = { &iec104_class::decodeASDU<iec_type33>, fmtBitstring, true, qualMeasured };
+  t[M_ME_TD_1] = { &iec104_class::decodeASDU<iec_type34>, fmtMeasured, true, qualMeasured };
+  t[M_ME_TE_1] = { &iec104_class::decodeASDU<iec_type35>, fmtMeasured, true, qualMeasured };
+  t[M_ME_TF_1] = { &iec104_class::decodeASDU<iec_type36>, fmtMeasured, true, qualMeasured };
+  t[M_IT_TB_1] = { &iec104_class::decodeASDU<iec_type37>, fmtCounter, true, qualCounter };
+  t[M_EP_TD_1] = { &iec104_class::decodeASDU<iec_type38>, fmtProtEvent, true, qualProtection };
+  t[M_EP_TE_1] = { &iec104_class::decodeASDU<iec_type39>, fmtProtStart, true, qualProtection };
+  t[M_EP_TF_1] = { &iec104_class::decodeASDU<iec_type40>, fmtProtOutput, true, qualProtection };
+  return t;
+}
+
+const std::array<iec104_class::asdu_decoder_entry, 256> iec104_class::decoderTable =
+    iec104_class::makeDecoderTable();
+
+void iec_points::assign(const iec_obj *o, unsigned n, uint8_t mask, bool timetag) {
+  objs = o;
+  size = n;
+  for (unsigned i = 0; i < n; i++) {
+    address[i] = o[i].address;
+    ca[i] = o[i].ca;
+    type[i] = o[i].type;
+    value[i] = o[i].value;
+    arrival_us[i] = o[i].arrival_us;
+    // ov shares its bit with the state of the digital types, the mask clears it
+    quality[i] = uint8_t((o[i].iv | (o[i].nt << 1) | (o[i].sb << 2) | (o[i].bl << 3) | (o[i].ov << 4) |
+                          (o[i].t << 5) | (o[i].cy << 6) | (o[i].ei << 7)) & mask);
+  }
+  if (timetag)
+    cp56time2aToUs(&o[0].timetag, sizeof(iec_obj), n, time_us);
+  else
+    for (unsigned i = 0; i < n; i++)
+      time_us[i] = -1;
+}
+
 void iec104_class::parseAPDU(iec_apdu* papdu, int sz, bool accountandrespond) {
   iec_apdu wapdu;      // buffer to assemble apdu to send
   string qs, qsa;
-  stringstream oss;
   unsigned short VR_NEW;
 
   if (papdu->start != START) {
@@ -579,8 +1238,16 @@ void iec104_class::parseAPDU(iec_apdu* papdu, int sz, bool accountandrespond) {
     return;
   }
 
+  // t3 counts from the last frame received
+  if (accountandrespond)
+    armTimer(tmTestFr, t3_testfr);
+
   if (sz == 6) {
     // Control messages
+    if (papdu->NS == SUPERVISORY)
+      stats.sRx++;
+    else
+      stats.uRx++;
     if (accountandrespond)
       switch (papdu->NS) {
         case STARTDTACT:
@@ -589,7 +1256,7 @@ void iec104_class::parseAPDU(iec_apdu* papdu, int sz, bool accountandrespond) {
           wapdu.length = 4;
           wapdu.NS = STARTDTCON;
           wapdu.NR = 0;
-          sendTCP(reinterpret_cast<char*>(&wapdu), 6);
+          sendFrame(&wapdu, 6);
           mLog.pushMsg("     STARTDTCON");
           break;
 
@@ -599,15 +1266,13 @@ void iec104_class::parseAPDU(iec_apdu* papdu, int sz, bool accountandrespond) {
           wapdu.length = 4;
           wapdu.NS = TESTFRCON;
           wapdu.NR = 0;
-          sendTCP(reinterpret_cast<char*>(&wapdu), 6);
+          sendFrame(&wapdu, 6);
           mLog.pushMsg("     TESTFRCON");
           break;
 
         case STARTDTCON:
           mLog.pushMsg("     STARTDTCON");
-          tout_startdtact = -1; // flag confirmation of STARTDT, not to timeout
-          TxOk = true;
-          tout_gi = 15; // request GI when communication starts
+          startDTConfirmed();
           break;
 
         case STOPDTACT:
@@ -627,7 +1292,7 @@ void iec104_class::parseAPDU(iec_apdu* papdu, int sz, bool accountandrespond) {
 
         case SUPERVISORY:
           mLog.pushMsg("     SUPERVISORY");
-          // do what?
+          ackReceived(papdu->NR);
           break;
 
         default: // error
@@ -637,12 +1302,14 @@ void iec104_class::parseAPDU(iec_apdu* papdu, int sz, bool accountandrespond) {
 
   } else {
     // data message
+    stats.iRx++;
 
     if (accountandrespond) {
       VR_NEW = (papdu->NS & 0xFFFE);
 
       if (VR_NEW != VR) {
         // sequence error, must close and reopen connection
+        stats.seqErrors++;
         mLog.pushMsg("*** SEQUENCE ERROR! **************************");
         if (seq_order_check) {
           disconnectTCP();
@@ -651,1902 +1318,924 @@ void iec104_class::parseAPDU(iec_apdu* papdu, int sz, bool accountandrespond) {
       }
 
       VR = VR_NEW + 2;
+      rx_unack++;
+      if (!ackReceived(papdu->NR))
+        return;
     }
 
-    oss.str("");
-    oss << "     OA "
-        << unsigned(papdu->asduh.oa)
-        << " CA "
-        << unsigned(papdu->asduh.ca)
-        << " TI TYPE "
-        << unsigned(papdu->asduh.type) << ":" << asduTiStr(papdu->asduh.type)
-        << " CAUSE "
-        << int(papdu->asduh.cause) << ":" << causeStr(papdu->asduh.cause)
-        << " SQ "
-        << unsigned(papdu->asduh.sq)
-        << " ITEMS "
-        << unsigned(papdu->asduh.num)
-        << (papdu->asduh.pn == POSITIVE ? " POSITIVE" : " NEGATIVE")
-        << (papdu->asduh.t ? " TEST" : "");
-
-
-    mLog.pushMsg(oss.str().c_str());
-
-    switch (papdu->asduh.type) {
-      case M_SP_NA_1: { // 1: DIGITAL SINGLE
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type1* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq1.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq1.ioa16 + (unsigned(papdu->sq1.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq1[i].obj;
-            addr24 = papdu->nsq1[i].ioa16 + (unsigned(papdu->nsq1[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->sp;
-          piecarr[i].sp = pobj->sp;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->sp ? "on " : "off ", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_DP_NA_1: { // 3: DIGITAL DOUBLE
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type3* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq3.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq3.ioa16 + (unsigned(papdu->sq3.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq3[i].obj;
-            addr24 = papdu->nsq3[i].ioa16 + (unsigned(papdu->nsq3[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->dp;
-          piecarr[i].dp = pobj->dp;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[100];
-            static const char* dblmsg[] = { "tra ", "off ", "on ", "ind " };
-            sprintf(buf, "%s%s%s%s%s", dblmsg[pobj->dp], pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ST_NA_1: { // 5: step position
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type5* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq5.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq5.ioa16 + (unsigned(papdu->sq5.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq5[i].obj;
-            addr24 = papdu->nsq5[i].ioa16 + (unsigned(papdu->nsq5[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].t = pobj->t;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s%s", pobj->t ? "t " : "", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ME_NA_1: { // 9: ANALOGIC NORMALIZED
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type9* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq9.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq9.ioa16 + (unsigned(papdu->sq9.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq9[i].obj;
-            addr24 = papdu->nsq9[i].ioa16 + (unsigned(papdu->nsq9[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ME_ND_1: { // 21: ANALOGIC NORMALIZED WITHOUT QUALITY
-		char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type21* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq21.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq21.ioa16 + (unsigned(papdu->sq21.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq21[i].obj;
-            addr24 = papdu->nsq21[i].ioa16 + (unsigned(papdu->nsq21[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].ov = 0;
-          piecarr[i].bl = 0;
-          piecarr[i].nt = 0;
-          piecarr[i].sb = 0;
-          piecarr[i].iv = 0;
-          if (mLog.isLogging()) {
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), nullptr, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;      case M_ME_NB_1: { // 11: ANALOGIC CONVERTED
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type11* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq11.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq11.ioa16 + (unsigned(papdu->sq11.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq11[i].obj;
-            addr24 = papdu->nsq11[i].ioa16 + (unsigned(papdu->nsq11[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ME_NC_1: { // 13: ANALOGIC FLOATING POINT
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type13* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq13.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq13.ioa16 + (unsigned(papdu->sq13.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq13[i].obj;
-            addr24 = papdu->nsq13[i].ioa16 + (unsigned(papdu->nsq13[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_SP_TB_1: { // 30:  DIGITAL SINGLE WITH LONG TIME TAG
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type30* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq30.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq30.ioa16 + (unsigned(papdu->sq30.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq30[i].obj;
-            addr24 = papdu->nsq30[i].ioa16 + (unsigned(papdu->nsq30[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->sp;
-          piecarr[i].sp = pobj->sp;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag = pobj->time;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->sp ? "on " : "off ", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_DP_TB_1: { // 31: DIGITAL DOUBLE WITH LONG TIME TAG
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type31* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq31.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq31.ioa16 + (unsigned(papdu->sq31.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq31[i].obj;
-            addr24 = papdu->nsq31[i].ioa16 + (unsigned(papdu->nsq31[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->dp;
-          piecarr[i].dp = pobj->dp;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag = pobj->time;
-          if (mLog.isLogging()) {
-            char buf[100];
-            static const char* dblmsg[] = { "tra ", "off ", "on ", "ind " };
-            sprintf(buf, "%s%s%s%s%s", dblmsg[pobj->dp], pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ST_TB_1: { // 32: TAP WITH TIME TAG
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type32* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq32.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq32.ioa16 + (unsigned(papdu->sq32.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq32[i].obj;
-            addr24 = papdu->nsq32[i].ioa16 + (unsigned(papdu->nsq32[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].t = pobj->t;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag = pobj->time;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s%s", pobj->t ? "t " : "", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_PS_NA_1: { // Packed single point information with status change detection
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type20* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq20.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq20.ioa16 + (unsigned(papdu->sq20.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq20[i].obj;
-            addr24 = papdu->nsq20[i].ioa16 + (unsigned(papdu->nsq20[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].stcd.st = pobj->stcd.st;
-          piecarr[i].stcd.cd = pobj->stcd.cd;
-          piecarr[i].value = double(pobj->stcd.st);
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[1000];
-            sprintf(buf, "%s%s%s%s%s ST %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d CH %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d [1-16]",
-                    pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "",
-                    pobj->stcd.st1,
-                    pobj->stcd.st2,
-                    pobj->stcd.st3,
-                    pobj->stcd.st4,
-                    pobj->stcd.st5,
-                    pobj->stcd.st6,
-                    pobj->stcd.st7,
-                    pobj->stcd.st8,
-                    pobj->stcd.st9,
-                    pobj->stcd.st10,
-                    pobj->stcd.st11,
-                    pobj->stcd.st12,
-                    pobj->stcd.st13,
-                    pobj->stcd.st14,
-                    pobj->stcd.st15,
-                    pobj->stcd.st16,
-                    pobj->stcd.cd1,
-                    pobj->stcd.cd2,
-                    pobj->stcd.cd3,
-                    pobj->stcd.cd4,
-                    pobj->stcd.cd5,
-                    pobj->stcd.cd6,
-                    pobj->stcd.cd7,
-                    pobj->stcd.cd8,
-                    pobj->stcd.cd9,
-                    pobj->stcd.cd10,
-                    pobj->stcd.cd11,
-                    pobj->stcd.cd12,
-                    pobj->stcd.cd13,
-                    pobj->stcd.cd14,
-                    pobj->stcd.cd15,
-                    pobj->stcd.cd16
-                   );
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].stcd.st), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_BO_NA_1: { // 7 bitstring
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type7* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq7.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq7.ioa16 + (unsigned(papdu->sq7.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq7[i].obj;
-            addr24 = papdu->nsq7[i].ioa16 + (unsigned(papdu->nsq7[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].bsi = pobj->bsi;
-          piecarr[i].value = double(pobj->bsi.bsi);
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[1000];
-            sprintf(buf, "%s%s%s%s%s ST %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d% d%d%d%d %d%d%d%d [1-32]",
-                    pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "",
-                    pobj->bsi.st1,
-                    pobj->bsi.st2,
-                    pobj->bsi.st3,
-                    pobj->bsi.st4,
-                    pobj->bsi.st5,
-                    pobj->bsi.st6,
-                    pobj->bsi.st7,
-                    pobj->bsi.st8,
-                    pobj->bsi.st9,
-                    pobj->bsi.st10,
-                    pobj->bsi.st11,
-                    pobj->bsi.st12,
-                    pobj->bsi.st13,
-                    pobj->bsi.st14,
-                    pobj->bsi.st15,
-                    pobj->bsi.st16,
-                    pobj->bsi.st17,
-                    pobj->bsi.st18,
-                    pobj->bsi.st19,
-                    pobj->bsi.st20,
-                    pobj->bsi.st21,
-                    pobj->bsi.st22,
-                    pobj->bsi.st23,
-                    pobj->bsi.st24,
-                    pobj->bsi.st25,
-                    pobj->bsi.st26,
-                    pobj->bsi.st27,
-                    pobj->bsi.st28,
-                    pobj->bsi.st29,
-                    pobj->bsi.st31,
-                    pobj->bsi.st32
-                   );
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].bsi.bsi), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_BO_TB_1: { // 33 bitstring with time tag
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type33* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq33.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq33.ioa16 + (unsigned(papdu->sq33.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq33[i].obj;
-            addr24 = papdu->nsq33[i].ioa16 + (unsigned(papdu->nsq33[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].bsi = pobj->bsi;
-          piecarr[i].value = double(pobj->bsi.bsi);
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag = pobj->time;
-          if (mLog.isLogging()) {
-            char buf[1000];
-            sprintf(buf, "%s%s%s%s%s ST %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d% d%d%d%d %d%d%d%d [1-32]",
-                    pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "",
-                    pobj->bsi.st1,
-                    pobj->bsi.st2,
-                    pobj->bsi.st3,
-                    pobj->bsi.st4,
-                    pobj->bsi.st5,
-                    pobj->bsi.st6,
-                    pobj->bsi.st7,
-                    pobj->bsi.st8,
-                    pobj->bsi.st9,
-                    pobj->bsi.st10,
-                    pobj->bsi.st11,
-                    pobj->bsi.st12,
-                    pobj->bsi.st13,
-                    pobj->bsi.st14,
-                    pobj->bsi.st15,
-                    pobj->bsi.st16,
-                    pobj->bsi.st17,
-                    pobj->bsi.st18,
-                    pobj->bsi.st19,
-                    pobj->bsi.st20,
-                    pobj->bsi.st21,
-                    pobj->bsi.st22,
-                    pobj->bsi.st23,
-                    pobj->bsi.st24,
-                    pobj->bsi.st25,
-                    pobj->bsi.st26,
-                    pobj->bsi.st27,
-                    pobj->bsi.st28,
-                    pobj->bsi.st29,
-                    pobj->bsi.st31,
-                    pobj->bsi.st32
-                   );
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].bsi.bsi), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ME_TD_1: { //34 MEASURED VALUE, NORMALIZED WITH TIME TAG
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type34* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq34.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq34.ioa16 + (unsigned(papdu->sq34.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq34[i].obj;
-            addr24 = papdu->nsq34[i].ioa16 + (unsigned(papdu->nsq34[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag.mday = pobj->time.mday;
-          piecarr[i].timetag.month = pobj->time.month;
-          piecarr[i].timetag.year = pobj->time.year;
-          piecarr[i].timetag.hour = pobj->time.hour;
-          piecarr[i].timetag.min = pobj->time.min;
-          piecarr[i].timetag.msec = pobj->time.msec;
-          piecarr[i].timetag.iv = pobj->time.iv;
-          piecarr[i].timetag.su = pobj->time.su;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ME_TE_1: { //35 MEASURED VALUE, SCALED WITH TIME TAG
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type35* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq35.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq35.ioa16 + (unsigned(papdu->sq35.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq35[i].obj;
-            addr24 = papdu->nsq35[i].ioa16 + (unsigned(papdu->nsq35[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag.mday = pobj->time.mday;
-          piecarr[i].timetag.month = pobj->time.month;
-          piecarr[i].timetag.year = pobj->time.year;
-          piecarr[i].timetag.hour = pobj->time.hour;
-          piecarr[i].timetag.min = pobj->time.min;
-          piecarr[i].timetag.msec = pobj->time.msec;
-          piecarr[i].timetag.iv = pobj->time.iv;
-          piecarr[i].timetag.su = pobj->time.su;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_ME_TF_1: { // 36 MEASURED VALUE, FLOATING POINT WITH TIME TAG
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type36* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq36.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq36.ioa16 + (unsigned(papdu->sq36.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq36[i].obj;
-            addr24 = papdu->nsq36[i].ioa16 + (unsigned(papdu->nsq36[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->mv;
-          piecarr[i].ov = pobj->ov;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag.mday = pobj->time.mday;
-          piecarr[i].timetag.month = pobj->time.month;
-          piecarr[i].timetag.year = pobj->time.year;
-          piecarr[i].timetag.hour = pobj->time.hour;
-          piecarr[i].timetag.min = pobj->time.min;
-          piecarr[i].timetag.msec = pobj->time.msec;
-          piecarr[i].timetag.iv = pobj->time.iv;
-          piecarr[i].timetag.su = pobj->time.su;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%s", pobj->ov ? "ov " : "", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "");
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_IT_NA_1: { // 15 = integrated totals without time tag
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type15* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq15.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq15.ioa16 + (unsigned(papdu->sq15.ioa8) << 16);
-            else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq15[i].obj;
-            addr24 = papdu->nsq15[i].ioa16 + (unsigned(papdu->nsq15[i].ioa8) << 16);
-          }
-
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].bcr = pobj->bcr;
-          piecarr[i].value = double(pobj->bcr);
-          piecarr[i].cadj = pobj->ca;
-          piecarr[i].cy = pobj->cy;
-          piecarr[i].sq = pobj->sq;
-          piecarr[i].iv = pobj->iv;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%u", pobj->ca ? "ca " : "", pobj->cy ? "cy " : "", pobj->iv ? "iv " : "", "sq=", pobj->sq);
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].bcr), buf, nullptr);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_IT_TB_1: { // 37 = integrated totals with time tag
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type37* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq37.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq37.ioa16 + (unsigned(papdu->sq37.ioa8) << 16);
+    if (mLog.willLog())
+      mLog.pushRecord(renderASDUHeader, &papdu->asduh, sizeof(papdu->asduh));
+
+    const asdu_decoder_entry& dec = decoderTable[papdu->asduh.type];
+    if (dec.decode != nullptr) {
+      // monitor direction information objects
+      (this->*dec.decode)(papdu, sz);
+    } else {
+      switch (papdu->asduh.type) {
+        case C_SC_NA_1: { // SINGLE COMMAND
+          iec_type45* pobj;
+          pobj =  &papdu->nsq45.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
             else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq37[i].obj;
-            addr24 = papdu->nsq37[i].ioa16 + (unsigned(papdu->nsq37[i].ioa8) << 16);
+              oss << "NEGATIVE ";
+            oss << "SINGLE COMMAND ADDRESS "
+                << unsigned(papdu->nsq45.ioa16) + (unsigned(papdu->nsq45.ioa8) << 16)
+                << " SCS "
+                << unsigned(pobj->scs)
+                << " QU "
+                << int(pobj->qu)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
           }
 
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].bcr = pobj->bcr;
-          piecarr[i].value = double(pobj->bcr);
-          piecarr[i].cadj = pobj->ca;
-          piecarr[i].cy = pobj->cy;
-          piecarr[i].sq = pobj->sq;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].timetag = pobj->time;
-          if (mLog.isLogging()) {
-            char buf[100];
-            sprintf(buf, "%s%s%s%s%u", pobj->ca ? "ca " : "", pobj->cy ? "cy " : "", pobj->iv ? "iv " : "", "sq=", pobj->sq);
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].bcr), buf, &piecarr[i].timetag);
-          }
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq45.ioa16 + (unsigned(papdu->nsq45.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.scs = pobj->scs;
+          iobj.qu = pobj->qu;
+          iobj.se = pobj->se;
+          commandResponse(&iobj);
         }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_EP_TD_1: { // 38 = Event of protection equipment with CP56Time2a time tag
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type38* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq38.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq38.ioa16 + (unsigned(papdu->sq38.ioa8) << 16);
+        break;
+        case C_DC_NA_1: { // DOUBLE COMMAND
+          iec_type46* pobj;
+          pobj =  &papdu->nsq46.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
             else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq38[i].obj;
-            addr24 = papdu->nsq38[i].ioa16 + (unsigned(papdu->nsq38[i].ioa8) << 16);
+              oss << "NEGATIVE ";
+            oss << "DOUBLE COMMAND ADDRESS "
+                << unsigned(papdu->nsq46.ioa16) + (unsigned(papdu->nsq46.ioa8) << 16)
+                << " DCS "
+                << unsigned(pobj->dcs)
+                << " QU "
+                << int(pobj->qu)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
           }
 
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->es;
-          piecarr[i].dp = pobj->es;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].elapsed_time = pobj->elapsed;
-          piecarr[i].timetag.mday = pobj->time.mday;
-          piecarr[i].timetag.month = pobj->time.month;
-          piecarr[i].timetag.year = pobj->time.year;
-          piecarr[i].timetag.hour = pobj->time.hour;
-          piecarr[i].timetag.min = pobj->time.min;
-          piecarr[i].timetag.msec = pobj->time.msec;
-          piecarr[i].timetag.iv = pobj->time.iv;
-          piecarr[i].timetag.su = pobj->time.su;
-          if (mLog.isLogging()) {
-            char buf[200];
-            static const char* dblmsg[] = { "ind0 ", "off ", "on ", "ind3 " };
-            sprintf(buf, "%s%s%s%s%s%s %dms", dblmsg[pobj->es], pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "", pobj->ei ? "ei " : "", pobj->elapsed.milliseconds);
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq46.ioa16 + (unsigned(papdu->nsq46.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.dcs = pobj->dcs;
+          iobj.qu = pobj->qu;
+          iobj.se = pobj->se;
+          commandResponse(&iobj);
         }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_EP_TE_1: { // 39 = Packed start events of protection equipment with CP56Time2a time tag
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type39* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj =  &papdu->sq39.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq39.ioa16 + (unsigned(papdu->sq39.ioa8) << 16);
+        break;
+        case C_RC_NA_1: { // REG.STEP COMMAND
+          iec_type47* pobj;
+          pobj =  &papdu->nsq47.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
             else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq39[i].obj;
-            addr24 = papdu->nsq39[i].ioa16 + (unsigned(papdu->nsq39[i].ioa8) << 16);
+              oss << "NEGATIVE ";
+            oss << "STEP REG. COMMAND ADDRESS "
+                << unsigned(papdu->nsq47.ioa16) + (unsigned(papdu->nsq47.ioa8) << 16)
+                << " RCS "
+                << unsigned(pobj->rcs)
+                << " QU "
+                << int(pobj->qu)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
           }
 
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->spe.gs;
-          piecarr[i].spe = pobj->spe;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].elapsed_time = pobj->elapsed;
-          piecarr[i].timetag.mday = pobj->time.mday;
-          piecarr[i].timetag.month = pobj->time.month;
-          piecarr[i].timetag.year = pobj->time.year;
-          piecarr[i].timetag.hour = pobj->time.hour;
-          piecarr[i].timetag.min = pobj->time.min;
-          piecarr[i].timetag.msec = pobj->time.msec;
-          piecarr[i].timetag.iv = pobj->time.iv;
-          piecarr[i].timetag.su = pobj->time.su;
-          if (mLog.isLogging()) {
-            char buf[200];
-            sprintf(buf, "%s%s%s%s%s%s%s%s%s%s%s %dms", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "", pobj->ei ? "ei " : "",
-                    pobj->spe.gs ? "gs " : "",
-                    pobj->spe.sl1 ? "sl1 " : "",
-                    pobj->spe.sl2 ? "sl2 " : "",
-                    pobj->spe.sl3 ? "sl3 " : "",
-                    pobj->spe.sie ? "sie " : "",
-                    pobj->spe.srd ? "srd " : "",
-                    pobj->elapsed.milliseconds);
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq47.ioa16 + (unsigned(papdu->nsq47.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.rcs = pobj->rcs;
+          iobj.qu = pobj->qu;
+          iobj.se = pobj->se;
+          commandResponse(&iobj);
         }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case M_EP_TF_1: { // 40 = Packed output circuit information of protection equipment with CP56Time2a time tag
-        char logpointbuf[15000] = "";
-        unsigned int addr24 = 0;
-        iec_type40* pobj;
-        iec_obj* piecarr = new iec_obj [papdu->asduh.num];
-        if (papdu->asduh.cause >= 20 && papdu->asduh.cause <= 36)
-          GIObjectCnt += papdu->asduh.num;
-
-        for (int i = 0; i < papdu->asduh.num; i++) {
-          if (papdu->asduh.sq) {
-            pobj = &papdu->sq40.obj[i];
-            if (i == 0)
-              addr24 = papdu->sq40.ioa16 + (unsigned(papdu->sq40.ioa8) << 16);
+        break;
+        case C_SC_TA_1: { // SINGLE COMMAND WITH TIME
+          iec_type58* pobj;
+          pobj =  &papdu->nsq58.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
             else
-              addr24++;
-          } else {
-            pobj =  &papdu->nsq40[i].obj;
-            addr24 = papdu->nsq40[i].ioa16 + (unsigned(papdu->nsq40[i].ioa8) << 16);
+              oss << "NEGATIVE ";
+            oss << "SINGLE COMMAND ADDRESS "
+                << unsigned(papdu->nsq58.ioa16) + (unsigned(papdu->nsq58.ioa8) << 16)
+                << " SCS "
+                << unsigned(pobj->scs)
+                << " QU "
+                << int(pobj->qu)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
           }
 
-          piecarr[i].address = addr24;
-          piecarr[i].ca = papdu->asduh.ca;
-          piecarr[i].cause = papdu->asduh.cause;
-          piecarr[i].pn = papdu->asduh.pn;
-          piecarr[i].test = papdu->asduh.t;
-          piecarr[i].type = papdu->asduh.type;
-          piecarr[i].value = pobj->oci.gc;
-          piecarr[i].oci = pobj->oci;
-          piecarr[i].bl = pobj->bl;
-          piecarr[i].nt = pobj->nt;
-          piecarr[i].sb = pobj->sb;
-          piecarr[i].iv = pobj->iv;
-          piecarr[i].elapsed_time = pobj->elapsed;
-          piecarr[i].timetag.mday = pobj->time.mday;
-          piecarr[i].timetag.month = pobj->time.month;
-          piecarr[i].timetag.year = pobj->time.year;
-          piecarr[i].timetag.hour = pobj->time.hour;
-          piecarr[i].timetag.min = pobj->time.min;
-          piecarr[i].timetag.msec = pobj->time.msec;
-          piecarr[i].timetag.iv = pobj->time.iv;
-          piecarr[i].timetag.su = pobj->time.su;
-          if (mLog.isLogging()) {
-            char buf[200];
-            sprintf(buf, "%s%s%s%s%s%s%s%s%s %dms", pobj->bl ? "bl " : "", pobj->nt ? "nt " : "", pobj->sb ? "sb " : "", pobj->iv ? "iv " : "", pobj->ei ? "ei " : "",
-                    pobj->oci.gc ? "gc " : "",
-                    pobj->oci.cl1 ? "cl1 " : "",
-                    pobj->oci.cl2 ? "cl2 " : "",
-                    pobj->oci.cl3 ? "cl3 " : "",
-                    pobj->elapsed.milliseconds);
-            LogPoint(logpointbuf, int(piecarr[i].address), double(piecarr[i].value), buf, &piecarr[i].timetag);
-          }
-        }
-        LogPoint(logpointbuf, -1, 0, nullptr, nullptr);
-        dataIndication(piecarr, papdu->asduh.num);
-        delete[] piecarr;
-      }
-      break;
-      case C_SC_NA_1: { // SINGLE COMMAND
-        iec_type45* pobj;
-        pobj =  &papdu->nsq45.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "SINGLE COMMAND ADDRESS "
-              << unsigned(papdu->nsq45.ioa16) + (unsigned(papdu->nsq45.ioa8) << 16)
-              << " SCS "
-              << unsigned(pobj->scs)
-              << " QU "
-              << int(pobj->qu)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
-        }
-
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq45.ioa16 + (unsigned(papdu->nsq45.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.scs = pobj->scs;
-        iobj.qu = pobj->qu;
-        iobj.se = pobj->se;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_DC_NA_1: { // DOUBLE COMMAND
-        iec_type46* pobj;
-        pobj =  &papdu->nsq46.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "DOUBLE COMMAND ADDRESS "
-              << unsigned(papdu->nsq46.ioa16) + (unsigned(papdu->nsq46.ioa8) << 16)
-              << " DCS "
-              << unsigned(pobj->dcs)
-              << " QU "
-              << int(pobj->qu)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
-        }
-
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq46.ioa16 + (unsigned(papdu->nsq46.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.dcs = pobj->dcs;
-        iobj.qu = pobj->qu;
-        iobj.se = pobj->se;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_RC_NA_1: { // REG.STEP COMMAND
-        iec_type47* pobj;
-        pobj =  &papdu->nsq47.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "STEP REG. COMMAND ADDRESS "
-              << unsigned(papdu->nsq47.ioa16) + (unsigned(papdu->nsq47.ioa8) << 16)
-              << " RCS "
-              << unsigned(pobj->rcs)
-              << " QU "
-              << int(pobj->qu)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
-        }
-
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq47.ioa16 + (unsigned(papdu->nsq47.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.rcs = pobj->rcs;
-        iobj.qu = pobj->qu;
-        iobj.se = pobj->se;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_SC_TA_1: { // SINGLE COMMAND WITH TIME
-        iec_type58* pobj;
-        pobj =  &papdu->nsq58.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "SINGLE COMMAND ADDRESS "
-              << unsigned(papdu->nsq58.ioa16) + (unsigned(papdu->nsq58.ioa8) << 16)
-              << " SCS "
-              << unsigned(pobj->scs)
-              << " QU "
-              << int(pobj->qu)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq58.ioa16 + (unsigned(papdu->nsq58.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.scs = pobj->scs;
+          iobj.qu = pobj->qu;
+          iobj.se = pobj->se;
+          commandResponse(&iobj);
         }
+        break;
+        case C_DC_TA_1: { // DOUBLE COMMAND WITH TIME
+          iec_type59* pobj;
+          pobj =  &papdu->nsq59.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "DOUBLE COMMAND ADDRESS "
+                << unsigned(papdu->nsq59.ioa16) + (unsigned(papdu->nsq59.ioa8) << 16)
+                << " DCS "
+                << unsigned(pobj->dcs)
+                << " QU "
+                << int(pobj->qu)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq58.ioa16 + (unsigned(papdu->nsq58.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.scs = pobj->scs;
-        iobj.qu = pobj->qu;
-        iobj.se = pobj->se;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_DC_TA_1: { // DOUBLE COMMAND WITH TIME
-        iec_type59* pobj;
-        pobj =  &papdu->nsq59.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "DOUBLE COMMAND ADDRESS "
-              << unsigned(papdu->nsq59.ioa16) + (unsigned(papdu->nsq59.ioa8) << 16)
-              << " DCS "
-              << unsigned(pobj->dcs)
-              << " QU "
-              << int(pobj->qu)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq59.ioa16 + (unsigned(papdu->nsq59.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.dcs = pobj->dcs;
+          iobj.qu = pobj->qu;
+          iobj.se = pobj->se;
+          commandResponse(&iobj);
         }
+        break;
+        case C_RC_TA_1: { // REG. STEP COMMAND WITH TIME
+          iec_type60* pobj;
+          pobj =  &papdu->nsq60.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "STEP REG. COMMAND ADDRESS "
+                << unsigned(papdu->nsq60.ioa16) + (unsigned(papdu->nsq60.ioa8) << 16)
+                << " RCS "
+                << unsigned(pobj->rcs)
+                << " QU "
+                << int(pobj->qu)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq59.ioa16 + (unsigned(papdu->nsq59.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.dcs = pobj->dcs;
-        iobj.qu = pobj->qu;
-        iobj.se = pobj->se;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_RC_TA_1: { // REG. STEP COMMAND WITH TIME
-        iec_type60* pobj;
-        pobj =  &papdu->nsq60.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "STEP REG. COMMAND ADDRESS "
-              << unsigned(papdu->nsq60.ioa16) + (unsigned(papdu->nsq60.ioa8) << 16)
-              << " RCS "
-              << unsigned(pobj->rcs)
-              << " QU "
-              << int(pobj->qu)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq60.ioa16 + (unsigned(papdu->nsq60.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.rcs = pobj->rcs;
+          iobj.qu = pobj->qu;
+          iobj.se = pobj->se;
+          commandResponse(&iobj);
         }
+        break;
+        case C_SE_NA_1: { // NORMALISED COMMAND
+          iec_type48* pobj;
+          pobj =  &papdu->nsq48.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "NORMALISED COMMAND ADDRESS "
+                << unsigned(papdu->nsq48.ioa16) + (unsigned(papdu->nsq48.ioa8) << 16)
+                << " VAL "
+                << pobj->nva
+                << " QL "
+                << int(pobj->ql)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq60.ioa16 + (unsigned(papdu->nsq60.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.rcs = pobj->rcs;
-        iobj.qu = pobj->qu;
-        iobj.se = pobj->se;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_SE_NA_1: { // NORMALISED COMMAND
-        iec_type48* pobj;
-        pobj =  &papdu->nsq48.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "NORMALISED COMMAND ADDRESS "
-              << unsigned(papdu->nsq48.ioa16) + (unsigned(papdu->nsq48.ioa8) << 16)
-              << " VAL "
-              << pobj->nva
-              << " QL "
-              << int(pobj->ql)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq48.ioa16 + (unsigned(papdu->nsq48.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.qu = 0;
+          iobj.se = pobj->se;
+          iobj.value = pobj->nva;
+          commandResponse(&iobj);
         }
+        break;
+        case C_SE_TA_1: { // NORMALISED COMMAND WITH TIME
+          iec_type61* pobj;
+          pobj =  &papdu->nsq61.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "NORMALISED COMMAND ADDRESS "
+                << unsigned(papdu->nsq61.ioa16) + (unsigned(papdu->nsq61.ioa8) << 16)
+                << " VAL "
+                << pobj->nva
+                << " QL "
+                << int(pobj->ql)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq48.ioa16 + (unsigned(papdu->nsq48.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.qu = 0;
-        iobj.se = pobj->se;
-        iobj.value = pobj->nva;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_SE_TA_1: { // NORMALISED COMMAND WITH TIME
-        iec_type61* pobj;
-        pobj =  &papdu->nsq61.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "NORMALISED COMMAND ADDRESS "
-              << unsigned(papdu->nsq61.ioa16) + (unsigned(papdu->nsq61.ioa8) << 16)
-              << " VAL "
-              << pobj->nva
-              << " QL "
-              << int(pobj->ql)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq61.ioa16 + (unsigned(papdu->nsq61.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.qu = 0;
+          iobj.se = pobj->se;
+          iobj.value = pobj->nva;
+          commandResponse(&iobj);
         }
+        break;
+        case C_SE_NB_1: { // SCALED COMMAND
+          iec_type49* pobj;
+          pobj =  &papdu->nsq49.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "SCALED COMMAND ADDRESS "
+                << unsigned(papdu->nsq49.ioa16) + (unsigned(papdu->nsq49.ioa8) << 16)
+                << " VAL "
+                << pobj->sva
+                << " QL "
+                << int(pobj->ql)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq61.ioa16 + (unsigned(papdu->nsq61.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.qu = 0;
-        iobj.se = pobj->se;
-        iobj.value = pobj->nva;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_SE_NB_1: { // SCALED COMMAND
-        iec_type49* pobj;
-        pobj =  &papdu->nsq49.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "SCALED COMMAND ADDRESS "
-              << unsigned(papdu->nsq49.ioa16) + (unsigned(papdu->nsq49.ioa8) << 16)
-              << " VAL "
-              << pobj->sva
-              << " QL "
-              << int(pobj->ql)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq49.ioa16 + (unsigned(papdu->nsq49.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.qu = 0;
+          iobj.se = pobj->se;
+          iobj.value = pobj->sva;
+          commandResponse(&iobj);
         }
+        break;
+        case C_SE_TB_1: { // SCALED COMMAND WITH TIME
+          iec_type62* pobj;
+          pobj =  &papdu->nsq62.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "SCALED COMMAND ADDRESS "
+                << unsigned(papdu->nsq62.ioa16) + (unsigned(papdu->nsq62.ioa8) << 16)
+                << " VAL "
+                << pobj->sva
+                << " QL "
+                << int(pobj->ql)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq49.ioa16 + (unsigned(papdu->nsq49.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.qu = 0;
-        iobj.se = pobj->se;
-        iobj.value = pobj->sva;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_SE_TB_1: { // SCALED COMMAND WITH TIME
-        iec_type62* pobj;
-        pobj =  &papdu->nsq62.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "SCALED COMMAND ADDRESS "
-              << unsigned(papdu->nsq62.ioa16) + (unsigned(papdu->nsq62.ioa8) << 16)
-              << " VAL "
-              << pobj->sva
-              << " QL "
-              << int(pobj->ql)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq62.ioa16 + (unsigned(papdu->nsq62.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.qu = 0;
+          iobj.se = pobj->se;
+          iobj.value = pobj->sva;
+          iobj.timetag = pobj->time;
+          commandResponse(&iobj);
         }
+        break;
+        case C_SE_NC_1: { // FLOAT COMMAND
+          iec_type50* pobj;
+          pobj =  &papdu->nsq50.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "FLOAT COMMAND ADDRESS "
+                << unsigned(papdu->nsq50.ioa16) + (unsigned(papdu->nsq50.ioa8) << 16)
+                << " VAL "
+                << pobj->r32
+                << " QL "
+                << int(pobj->ql)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq62.ioa16 + (unsigned(papdu->nsq62.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.qu = 0;
-        iobj.se = pobj->se;
-        iobj.value = pobj->sva;
-        iobj.timetag = pobj->time;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_SE_NC_1: { // FLOAT COMMAND
-        iec_type50* pobj;
-        pobj =  &papdu->nsq50.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "FLOAT COMMAND ADDRESS "
-              << unsigned(papdu->nsq50.ioa16) + (unsigned(papdu->nsq50.ioa8) << 16)
-              << " VAL "
-              << pobj->r32
-              << " QL "
-              << int(pobj->ql)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq50.ioa16 + (unsigned(papdu->nsq50.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.qu = 0;
+          iobj.se = pobj->se;
+          iobj.value = pobj->r32;
+          commandResponse(&iobj);
         }
+        break;
+        case C_SE_TC_1: { // FLOAT COMMAND WITH TIME
+          iec_type63* pobj;
+          pobj = &papdu->nsq63.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "FLOAT COMMAND ADDRESS "
+                << unsigned(papdu->nsq63.ioa16) + (unsigned(papdu->nsq63.ioa8) << 16)
+                << " VAL "
+                << pobj->r32
+                << " QL "
+                << int(pobj->ql)
+                << " SE "
+                << unsigned(pobj->se);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq50.ioa16 + (unsigned(papdu->nsq50.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.qu = 0;
-        iobj.se = pobj->se;
-        iobj.value = pobj->r32;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_SE_TC_1: { // FLOAT COMMAND WITH TIME
-        iec_type63* pobj;
-        pobj = &papdu->nsq63.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "FLOAT COMMAND ADDRESS "
-              << unsigned(papdu->nsq63.ioa16) + (unsigned(papdu->nsq63.ioa8) << 16)
-              << " VAL "
-              << pobj->r32
-              << " QL "
-              << int(pobj->ql)
-              << " SE "
-              << unsigned(pobj->se);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq63.ioa16 + (unsigned(papdu->nsq63.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.qu = 0;
+          iobj.se = pobj->se;
+          iobj.value = pobj->r32;
+          commandResponse(&iobj);
         }
-
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq63.ioa16 + (unsigned(papdu->nsq63.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.qu = 0;
-        iobj.se = pobj->se;
-        iobj.value = pobj->r32;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case M_EI_NA_1: //70
-        mLog.pushMsg("R--> END OF INITIALIZATION");
-        break;
-      case INTERROGATION: // GI
-        tout_gi = gi_period; // restart count to next GI
-        if (papdu->asduh.cause == ACTCONFIRM) {
-          GIObjectCnt = 0;
-          mLog.pushMsg("     INTERROGATION ACT CON ------------------------------------------------------------------------");
-          interrogationActConfIndication();
-        } else if (papdu->asduh.cause == ACTTERM) {
-          mLog.pushMsg("     INTERROGATION ACT TERM ------------------------------------------------------------------------");
-          oss.str("");
-          oss << "     Total objects in Interrogation: "
-              << GIObjectCnt;
-          mLog.pushMsg(oss.str().c_str());
-
-          interrogationActTermIndication();
-        } else
-          mLog.pushMsg("     INTERROGATION");
         break;
-      case C_TS_TA_1: { // 107
-        iec_type107* pobj;
-        pobj = (iec_type107*)papdu->dados;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     TEST COMMAND COM TAG "
-              << " TSC " << unsigned(pobj->tsc)
-              << unsigned(pobj->time.year) << "year " << unsigned(pobj->time.month) << "month " << unsigned(pobj->time.mday) << "day "
-              << unsigned(pobj->time.hour) << "hour " << unsigned(pobj->time.min) << "min " << unsigned(pobj->time.msec / 1000) << "sec "
-              << unsigned(pobj->time.msec % 1000) << "msec";
-          mLog.pushMsg(oss.str().c_str());
-        }
+        case M_EI_NA_1: //70
+          mLog.pushMsg("R--> END OF INITIALIZATION");
+          break;
+        case INTERROGATION: { // GI
+          int qoi = static_cast<unsigned char>(papdu->dados[3]);
+          if (papdu->asduh.cause == ACTCONFIRM) {
+            if (!giSched.active())
+              GIObjectCnt = 0; // not of a GI (user requested)
+            if (giTime == stats_clock::time_point())
+              giTime = stats_clock::now();
+            giSched.actCon(qoi, papdu->asduh.pn != 0);
+            mLog.pushMsg(papdu->asduh.pn ? "     INTERROGATION ACT CON NEGATIVE -----------------------------------------------------------"
+                                         : "     INTERROGATION ACT CON ------------------------------------------------------------------------");
+            interrogationActConfIndication();
+          } else if (papdu->asduh.cause == ACTTERM) {
+            giSched.actTerm(qoi);
+            mLog.pushMsg("     INTERROGATION ACT TERM ------------------------------------------------------------------------");
+            if (mLog.willLog()) {
+              stringstream oss;
+              oss << "     Total objects in Interrogation: "
+                  << GIObjectCnt;
+              if (giSched.total() > 0)
+                oss << " (GI " << giSched.text() << ")";
+              mLog.pushMsg(oss.str().c_str());
+            }
+            // ACTCON of the first to ACTTERM of the last
+            if (!giSched.active() && giTime != stats_clock::time_point()) {
+              stats.giMs.add(uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+                  stats_clock::now() - giTime).count()));
+              giTime = stats_clock::time_point();
+            }
+
+            interrogationActTermIndication();
+          } else
+            mLog.pushMsg("     INTERROGATION");
+          giPump();
+          // restart count to the next GI, or to the retry of the one in progress
+          armTimer(tmGI, int64_t(giSched.active() ? gi_retry_time : gi_period) * 1000);
+        } break;
+        case C_TS_TA_1: { // 107
+          iec_type107* pobj;
+          pobj = (iec_type107*)papdu->dados;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     TEST COMMAND COM TAG "
+                << " TSC " << unsigned(pobj->tsc)
+                << unsigned(pobj->time.year) << "year " << unsigned(pobj->time.month) << "month " << unsigned(pobj->time.mday) << "day "
+                << unsigned(pobj->time.hour) << "hour " << unsigned(pobj->time.min) << "min " << unsigned(pobj->time.msec / 1000) << "sec "
+                << unsigned(pobj->time.msec % 1000) << "msec";
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        if (papdu->asduh.cause == ACTIVATION) {
-          confTestCommand();
-        }
-      }
-      break;
-      case C_RD_NA_1: { // READ COMMAND
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "READ COMMAND ADDRESS "
-              << unsigned(papdu->asdu102.ioa16) + (unsigned(papdu->asdu102.ioa8) << 16);
-
-          mLog.pushMsg(oss.str().c_str());
+          if (papdu->asduh.cause == ACTIVATION) {
+            confTestCommand();
+          }
         }
+        break;
+        case C_RD_NA_1: { // READ COMMAND
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "READ COMMAND ADDRESS "
+                << unsigned(papdu->asdu102.ioa16) + (unsigned(papdu->asdu102.ioa8) << 16);
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->asdu102.ioa16 + (unsigned(papdu->asdu102.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case C_CI_NA_1: { // 101
-        iec_type101* pobj;
-        pobj = (iec_type101*)&papdu->asdu101;
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     COUNTER INTERROGATION COMMAND, ADDRESS "
-              << (unsigned(papdu->asdu101.ioa16) + (unsigned(papdu->asdu101.ioa8) << 16))
-              << " FRZ "
-              << pobj->frz
-              << " RQT "
-              << int(pobj->rqt);
-          mLog.pushMsg(oss.str().c_str());
+            mLog.pushMsg(oss.str().c_str());
+          }
+
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->asdu102.ioa16 + (unsigned(papdu->asdu102.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          commandResponse(&iobj);
         }
-      }
-      break;
-      case C_CS_NA_1: { // 103
-        iec_type103* pobj;
-        pobj = (iec_type103*)&papdu->asdu103;
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     CLOCK SYNC COMMAND "
-              << unsigned(pobj->time.year) << "year " << unsigned(pobj->time.month) << "month " << unsigned(pobj->time.mday) << "day "
-              << unsigned(pobj->time.hour) << "hour " << unsigned(pobj->time.min) << "min " << unsigned(pobj->time.msec / 1000) << "sec "
-              << unsigned(pobj->time.msec % 1000) << "msec";
-          mLog.pushMsg(oss.str().c_str());
+        break;
+        case C_CI_NA_1: { // 101
+          iec_type101* pobj;
+          pobj = (iec_type101*)&papdu->asdu101;
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     COUNTER INTERROGATION COMMAND, ADDRESS "
+                << (unsigned(papdu->asdu101.ioa16) + (unsigned(papdu->asdu101.ioa8) << 16))
+                << " FRZ "
+                << pobj->frz
+                << " RQT "
+                << int(pobj->rqt);
+            mLog.pushMsg(oss.str().c_str());
+          }
         }
-      }
-      break;
-      case P_ME_NA_1: { // Parameter of measured value, normalized value
-        iec_type110* pobj;
-        pobj = &papdu->nsq110.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "PARAMETER OF MEASURED NORMALIZED VALUE, ADDRESS "
-              << unsigned(papdu->nsq110.ioa16) + (unsigned(papdu->nsq110.ioa8) << 16)
-              << " VAL "
-              << pobj->nva
-              << " KPA "
-              << int(pobj->kpa)
-              << " LPC "
-              << unsigned(pobj->lpc)
-              << " POP "
-              << unsigned(pobj->pop);
-          mLog.pushMsg(oss.str().c_str());
+        break;
+        case C_CS_NA_1: { // 103
+          iec_type103* pobj;
+          pobj = (iec_type103*)&papdu->asdu103;
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     CLOCK SYNC COMMAND "
+                << unsigned(pobj->time.year) << "year " << unsigned(pobj->time.month) << "month " << unsigned(pobj->time.mday) << "day "
+                << unsigned(pobj->time.hour) << "hour " << unsigned(pobj->time.min) << "min " << unsigned(pobj->time.msec / 1000) << "sec "
+                << unsigned(pobj->time.msec % 1000) << "msec";
+            mLog.pushMsg(oss.str().c_str());
+          }
         }
+        break;
+        case P_ME_NA_1: { // Parameter of measured value, normalized value
+          iec_type110* pobj;
+          pobj = &papdu->nsq110.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "PARAMETER OF MEASURED NORMALIZED VALUE, ADDRESS "
+                << unsigned(papdu->nsq110.ioa16) + (unsigned(papdu->nsq110.ioa8) << 16)
+                << " VAL "
+                << pobj->nva
+                << " KPA "
+                << int(pobj->kpa)
+                << " LPC "
+                << unsigned(pobj->lpc)
+                << " POP "
+                << unsigned(pobj->pop);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq110.ioa16 + (unsigned(papdu->nsq110.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.se = 0;
-        iobj.qu = pobj->kpa;
-        iobj.kpa = pobj->kpa;
-        iobj.pop = pobj->pop;
-        iobj.lpc = pobj->lpc;
-        iobj.value = pobj->nva;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case P_ME_NB_1: { // Parameter of scaled value, normalized value
-        iec_type111* pobj;
-        pobj =  &papdu->nsq111.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "PARAMETER OF MEASURED SCALED VALUE, ADDRESS "
-              << unsigned(papdu->nsq111.ioa16) + (unsigned(papdu->nsq111.ioa8) << 16)
-              << " VAL "
-              << pobj->sva
-              << " KPA "
-              << int(pobj->kpa)
-              << " LPC "
-              << unsigned(pobj->lpc)
-              << " POP "
-              << unsigned(pobj->pop);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq110.ioa16 + (unsigned(papdu->nsq110.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.se = 0;
+          iobj.qu = pobj->kpa;
+          iobj.kpa = pobj->kpa;
+          iobj.pop = pobj->pop;
+          iobj.lpc = pobj->lpc;
+          iobj.value = pobj->nva;
+          commandResponse(&iobj);
         }
+        break;
+        case P_ME_NB_1: { // Parameter of scaled value, normalized value
+          iec_type111* pobj;
+          pobj =  &papdu->nsq111.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "PARAMETER OF MEASURED SCALED VALUE, ADDRESS "
+                << unsigned(papdu->nsq111.ioa16) + (unsigned(papdu->nsq111.ioa8) << 16)
+                << " VAL "
+                << pobj->sva
+                << " KPA "
+                << int(pobj->kpa)
+                << " LPC "
+                << unsigned(pobj->lpc)
+                << " POP "
+                << unsigned(pobj->pop);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq111.ioa16 + (unsigned(papdu->nsq111.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.se = 0;
-        iobj.qu = pobj->kpa;
-        iobj.kpa = pobj->kpa;
-        iobj.pop = pobj->pop;
-        iobj.lpc = pobj->lpc;
-        iobj.value = pobj->sva;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case P_ME_NC_1: { // Parameter of measured value, float value
-        iec_type112* pobj;
-        pobj =  &papdu->nsq112.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "PARAMETER OF FLOAT NORMALIZED VALUE, ADDRESS "
-              << unsigned(papdu->nsq112.ioa16) + (unsigned(papdu->nsq112.ioa8) << 16)
-              << " VAL "
-              << pobj->r32
-              << " KPA "
-              << int(pobj->kpa)
-              << " LPC "
-              << unsigned(pobj->lpc)
-              << " POP "
-              << unsigned(pobj->pop);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq111.ioa16 + (unsigned(papdu->nsq111.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.se = 0;
+          iobj.qu = pobj->kpa;
+          iobj.kpa = pobj->kpa;
+          iobj.pop = pobj->pop;
+          iobj.lpc = pobj->lpc;
+          iobj.value = pobj->sva;
+          commandResponse(&iobj);
         }
+        break;
+        case P_ME_NC_1: { // Parameter of measured value, float value
+          iec_type112* pobj;
+          pobj =  &papdu->nsq112.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "PARAMETER OF FLOAT NORMALIZED VALUE, ADDRESS "
+                << unsigned(papdu->nsq112.ioa16) + (unsigned(papdu->nsq112.ioa8) << 16)
+                << " VAL "
+                << pobj->r32
+                << " KPA "
+                << int(pobj->kpa)
+                << " LPC "
+                << unsigned(pobj->lpc)
+                << " POP "
+                << unsigned(pobj->pop);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq110.ioa16 + (unsigned(papdu->nsq110.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.se = 0;
-        iobj.qu = pobj->kpa;
-        iobj.kpa = pobj->kpa;
-        iobj.pop = pobj->pop;
-        iobj.lpc = pobj->lpc;
-        iobj.value = pobj->r32;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      case P_AC_NA_1: { // Parameter activation
-        iec_type113* pobj;
-        pobj =  &papdu->nsq113.obj;
-
-        if (mLog.isLogging()) {
-          oss.str("");
-          oss << "     ";
-          if (papdu->asduh.cause == ACTCONFIRM)
-            oss << "ACTIVATION CONFIRMATION ";
-          else if (papdu->asduh.cause == ACTTERM)
-            oss << "ACTIVATION TERMINATION ";
-          if (papdu->asduh.pn == POSITIVE)
-            oss << "POSITIVE ";
-          else
-            oss << "NEGATIVE ";
-          oss << "PARAMETER ACTIVATION, ADDRESS "
-              << unsigned(papdu->nsq113.ioa16) + (unsigned(papdu->nsq113.ioa8) << 16)
-              << " QPA "
-              << unsigned(pobj->qpa);
-          mLog.pushMsg(oss.str().c_str());
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq110.ioa16 + (unsigned(papdu->nsq110.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.se = 0;
+          iobj.qu = pobj->kpa;
+          iobj.kpa = pobj->kpa;
+          iobj.pop = pobj->pop;
+          iobj.lpc = pobj->lpc;
+          iobj.value = pobj->r32;
+          commandResponse(&iobj);
         }
+        break;
+        case P_AC_NA_1: { // Parameter activation
+          iec_type113* pobj;
+          pobj =  &papdu->nsq113.obj;
+
+          if (mLog.willLog()) {
+            stringstream oss;
+            oss << "     ";
+            if (papdu->asduh.cause == ACTCONFIRM)
+              oss << "ACTIVATION CONFIRMATION ";
+            else if (papdu->asduh.cause == ACTTERM)
+              oss << "ACTIVATION TERMINATION ";
+            if (papdu->asduh.pn == POSITIVE)
+              oss << "POSITIVE ";
+            else
+              oss << "NEGATIVE ";
+            oss << "PARAMETER ACTIVATION, ADDRESS "
+                << unsigned(papdu->nsq113.ioa16) + (unsigned(papdu->nsq113.ioa8) << 16)
+                << " QPA "
+                << unsigned(pobj->qpa);
+            mLog.pushMsg(oss.str().c_str());
+          }
 
-        // send indication to user
-        iec_obj iobj;
-        iobj.address = papdu->nsq113.ioa16 + (unsigned(papdu->nsq113.ioa8) << 16);
-        iobj.ca = papdu->asduh.ca;
-        iobj.cause = papdu->asduh.cause;
-        iobj.pn = papdu->asduh.pn;
-        iobj.test = papdu->asduh.t;
-        iobj.type = papdu->asduh.type;
-        iobj.se = 0;
-        iobj.qu = pobj->qpa;
-        iobj.qpa = pobj->qpa;
-        iobj.value = pobj->qpa;
-        commandActRespIndication(&iobj);
-      }
-      break;
-      default:
-        mLog.pushMsg("!!! TYPE NOT IMPLEMENTED");
+          // send indication to user
+          iec_obj iobj;
+          iobj.address = papdu->nsq113.ioa16 + (unsigned(papdu->nsq113.ioa8) << 16);
+          iobj.ca = papdu->asduh.ca;
+          iobj.cause = papdu->asduh.cause;
+          iobj.pn = papdu->asduh.pn;
+          iobj.test = papdu->asduh.t;
+          iobj.type = papdu->asduh.type;
+          iobj.se = 0;
+          iobj.qu = pobj->qpa;
+          iobj.qpa = pobj->qpa;
+          iobj.value = pobj->qpa;
+          commandResponse(&iobj);
+        }
         break;
+        default:
+          mLog.pushMsg("!!! TYPE NOT IMPLEMENTED");
+          break;
+      }
     }
 
     if (accountandrespond) {
 
-      tout_testfr = t3_testfr;
-
-      if (msg_supervisory) {
-        // will wait t2 seconds or n messages to send supervisory window control
-        if (tout_supervisory < 0)
-          tout_supervisory = t2_supervisory;
-
-        if (tout_supervisory > 0)
-          tout_supervisory--;
-
-        if (tout_supervisory == 0) {
-          tout_supervisory = -1;
+      // acknowledge after w I-frames or t2 seconds, unless an I-frame sent
+      // before that carries the NR (a reply sent while parsing this one
+      // already cleared rx_unack)
+      if (rx_unack > 0) {
+        if (!msg_supervisory || rx_unack >= w_ack)
           sendSupervisory();
-        }
-      } else
-        sendSupervisory();
+        else if (!tmSupervisory.armed())
+          armTimer(tmSupervisory, t2_supervisory);
+      }
     }
   }
 }
 
 void iec104_class::sendSupervisory() {
-  stringstream oss;
   iec_apdu apdu;
 
   apdu.start = START;
   apdu.length = 4;
   apdu.NS = SUPERVISORY;
   apdu.NR = VR;
-  sendTCP(reinterpret_cast<char*>(&apdu), 6);
+  sendFrame(&apdu, 6);
+  rx_unack = 0;
+  timers->cancel(tmSupervisory);
+
+  if (mLog.willLog()) {
+    stringstream oss;
+    oss.setf(ios::hex, ios::basefield);
+    oss << "     SUPERVISORY " << VR;
+    mLog.pushMsg(oss.str().c_str());
+  }
+}
+
+void iec104_class::sendFrame(const void* frame, int sz) {
+  if (frameCapture)
+    frameCapture->record(frame, unsigned(sz), true);
+  if (mLog.willLog())
+    LogFrame(const_cast<char*>(static_cast<const char*>(frame)), sz, true);
+  if (sz > 6)
+    stats.iTx++;
+  else if (static_cast<const iec_apdu*>(frame)->NS == SUPERVISORY)
+    stats.sTx++;
+  else
+    stats.uTx++;
+  bool first = txBuf.empty();
+  txBuf.insert(txBuf.end(), static_cast<const char*>(frame), static_cast<const char*>(frame) + sz);
+  if (txBuf.size() >= tx_buf_max)
+    flushTCP();
+  else if (first && !txHold)
+    txReadyTCP();
+}
+
+void iec104_class::flushTCP() {
+  if (!txBuf.empty()) {
+    sendTCP(txBuf.data(), int(txBuf.size()));
+    txBuf.clear();
+  }
+}
+
+unsigned iec104_class::sendCommands(iec_obj* objs, unsigned numcmds) {
+  unsigned cnt = 0;
+  bool hold = txHold;
+  txHold = true;
+  for (unsigned i = 0; i < numcmds; i++)
+    if (sendCommand(&objs[i]))
+      cnt++;
+  txHold = hold;
+  if (!txHold)
+    flushTCP();
+  return cnt;
+}
+
+unsigned iec104_class::txUnack() {
+  return static_cast<unsigned short>(VS - ackVS) >> 1;
+}
+
+bool iec104_class::ackReceived(unsigned short nr) {
+  nr &= 0xFFFE;
+  if (static_cast<unsigned short>(nr - ackVS) > static_cast<unsigned short>(VS - ackVS)) {
+    // acknowledges a frame not sent
+    stats.seqErrors++;
+    mLog.pushMsg("*** NR SEQUENCE ERROR! ***********************");
+    if (seq_order_check) {
+      disconnectTCP();
+      return false;
+    }
+    return true;
+  }
+  bool progress = nr != ackVS;
+  ackVS = nr;
+  if (nr == VS)
+    timers->cancel(tmAck); // all acknowledged
+  else if (progress)
+    armTimer(tmAck, t1_ack);
+
+  // window opened, send what was waiting
+  while (!txQueue.empty() && txUnack() < k_unack) {
+    transmitIFrame(&txQueue.front().apdu, txQueue.front().sz);
+    txQueue.pop_front();
+  }
+  return true;
+}
+
+void iec104_class::sendIFrame(iec_apdu* apdu, int sz) {
+  if (!txQueue.empty() || txUnack() >= k_unack) {
+    // k window full, wait for the acknowledge from the slave
+    txQueue.push_back(tx_frame());
+    memcpy(&txQueue.back().apdu, apdu, size_t(sz));
+    txQueue.back().sz = sz;
+    return;
+  }
+  transmitIFrame(apdu, sz);
+}
 
-  oss.str("");
-  oss.setf(ios::hex, ios::basefield);
-  oss << "     SUPERVISORY " << VR;
-  mLog.pushMsg(oss.str().c_str());
+void iec104_class::transmitIFrame(iec_apdu* apdu, int sz) {
+  apdu->NS = VS;
+  apdu->NR = VR; // acknowledges the received I-frames
+  sendFrame(apdu, sz);
+  VS += 2;
+  rx_unack = 0;
+  timers->cancel(tmSupervisory);
+  if (!tmAck.armed())
+    armTimer(tmAck, t1_ack);
 }
 
 bool iec104_class::sendCommand(iec_obj* obj) {
   iec_apdu apducmd;
-  time_t tm1 = time(nullptr);
-  tm* agora = localtime(&tm1);
-  stringstream oss;
+  cp56time2a now56; // time tag of the commands with time
+  cp56time2aNow(now56);
 
   obj->cause = ACTIVATION;
 
@@ -2557,8 +2246,6 @@ bool iec104_class::sendCommand(iec_obj* obj) {
     case C_SC_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq45);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2573,11 +2260,10 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq45.obj.res = 0;
       apducmd.nsq45.obj.qu = obj->qu;
       apducmd.nsq45.obj.se = obj->se;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
 
-      if (mLog.isLogging()) {
-        oss.str("");
+      if (mLog.willLog()) {
+        stringstream oss;
         oss << "     SINGLE COMMAND ADDRESS "
             << unsigned(obj->address)
             << " SCS "
@@ -2595,8 +2281,6 @@ bool iec104_class::sendCommand(iec_obj* obj) {
     case C_DC_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq46);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2610,27 +2294,26 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq46.obj.dcs = obj->dcs;
       apducmd.nsq46.obj.qu = obj->qu;
       apducmd.nsq46.obj.se = obj->se;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     DOUBLE COMMAND ADDRESS "
-          << unsigned(obj->address)
-          << " DCS "
-          << unsigned(obj->dcs)
-          << " CA "
-          << obj->ca
-          << " QU "
-          << unsigned(obj->qu)
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     DOUBLE COMMAND ADDRESS "
+            << unsigned(obj->address)
+            << " DCS "
+            << unsigned(obj->dcs)
+            << " CA "
+            << obj->ca
+            << " QU "
+            << unsigned(obj->qu)
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_RC_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq47);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2644,26 +2327,25 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq47.obj.rcs = obj->rcs;
       apducmd.nsq47.obj.qu = obj->qu;
       apducmd.nsq47.obj.se = obj->se;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-      oss.str("");
-      oss << "     STEP REG. COMMAND ADDRESS "
-          << unsigned(obj->address)
-          << " RCS "
-          << unsigned(obj->rcs)
-          << " CA "
-          << obj->ca
-          << " QU "
-          << unsigned(obj->qu)
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     STEP REG. COMMAND ADDRESS "
+            << unsigned(obj->address)
+            << " RCS "
+            << unsigned(obj->rcs)
+            << " CA "
+            << obj->ca
+            << " QU "
+            << unsigned(obj->qu)
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_SC_TA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq58);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2678,41 +2360,27 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq58.obj.res = 0;
       apducmd.nsq58.obj.qu = obj->qu;
       apducmd.nsq58.obj.se = obj->se;
-      apducmd.nsq58.obj.time.year = static_cast<uint8_t>(agora->tm_year % 100);
-      apducmd.nsq58.obj.time.month = static_cast<uint8_t>(agora->tm_mon + 1);
-      apducmd.nsq58.obj.time.mday = static_cast<uint8_t>(agora->tm_mday);
-      apducmd.nsq58.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq58.obj.time.min = static_cast<uint8_t>(agora->tm_min);
-      apducmd.nsq58.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq58.obj.time.msec = static_cast<uint16_t>(agora->tm_sec * 1000);
-      apducmd.nsq58.obj.time.iv = 0;
-      apducmd.nsq58.obj.time.su = static_cast<uint8_t>(agora->tm_isdst);
-      apducmd.nsq58.obj.time.wday = static_cast<uint8_t>(agora->tm_wday);
-      apducmd.nsq58.obj.time.res1 = 0;
-      apducmd.nsq58.obj.time.res2 = 0;
-      apducmd.nsq58.obj.time.res3 = 0;
-      apducmd.nsq58.obj.time.res4 = 0;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     SINGLE COMMAND W/TIME ADDRESS "
-          << unsigned(obj->address)
-          << " SCS "
-          << unsigned(obj->scs)
-          << " CA "
-          << obj->ca
-          << " QU "
-          << unsigned(obj->qu)
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      apducmd.nsq58.obj.time = now56;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     SINGLE COMMAND W/TIME ADDRESS "
+            << unsigned(obj->address)
+            << " SCS "
+            << unsigned(obj->scs)
+            << " CA "
+            << obj->ca
+            << " QU "
+            << unsigned(obj->qu)
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_DC_TA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq59);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2726,41 +2394,27 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq59.obj.dcs = obj->dcs;
       apducmd.nsq59.obj.qu = obj->qu;
       apducmd.nsq59.obj.se = obj->se;
-      apducmd.nsq59.obj.time.year = static_cast<uint8_t>(agora->tm_year % 100);
-      apducmd.nsq59.obj.time.month = static_cast<uint8_t>(agora->tm_mon + 1);
-      apducmd.nsq59.obj.time.mday = static_cast<uint8_t>(agora->tm_mday);
-      apducmd.nsq59.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq59.obj.time.min = static_cast<uint8_t>(agora->tm_min);
-      apducmd.nsq59.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq59.obj.time.msec = static_cast<uint16_t>(agora->tm_sec * 1000);
-      apducmd.nsq59.obj.time.iv = 0;
-      apducmd.nsq59.obj.time.su = static_cast<uint8_t>(agora->tm_isdst);
-      apducmd.nsq59.obj.time.wday = static_cast<uint8_t>(agora->tm_wday);
-      apducmd.nsq59.obj.time.res1 = 0;
-      apducmd.nsq59.obj.time.res2 = 0;
-      apducmd.nsq59.obj.time.res3 = 0;
-      apducmd.nsq59.obj.time.res4 = 0;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     DOUBLE COMMAND W/TIME ADDRESS "
-          << unsigned(obj->address)
-          << " DCS "
-          << unsigned(obj->dcs)
-          << " CA "
-          << obj->ca
-          << " QU "
-          << unsigned(obj->qu)
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      apducmd.nsq59.obj.time = now56;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     DOUBLE COMMAND W/TIME ADDRESS "
+            << unsigned(obj->address)
+            << " DCS "
+            << unsigned(obj->dcs)
+            << " CA "
+            << obj->ca
+            << " QU "
+            << unsigned(obj->qu)
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_RC_TA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq60);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2774,40 +2428,26 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq60.obj.rcs = obj->rcs;
       apducmd.nsq60.obj.qu = obj->qu;
       apducmd.nsq60.obj.se = obj->se;
-      apducmd.nsq60.obj.time.year = static_cast<uint8_t>(agora->tm_year % 100);
-      apducmd.nsq60.obj.time.month = static_cast<uint8_t>(agora->tm_mon + 1);
-      apducmd.nsq60.obj.time.mday = static_cast<uint8_t>(agora->tm_mday);
-      apducmd.nsq60.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq60.obj.time.min = static_cast<uint8_t>(agora->tm_min);
-      apducmd.nsq60.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq60.obj.time.msec = static_cast<uint16_t>(agora->tm_sec * 1000);
-      apducmd.nsq60.obj.time.iv = 0;
-      apducmd.nsq60.obj.time.su = static_cast<uint8_t>(agora->tm_isdst);
-      apducmd.nsq60.obj.time.wday = static_cast<uint8_t>(agora->tm_wday);
-      apducmd.nsq60.obj.time.res1 = 0;
-      apducmd.nsq60.obj.time.res2 = 0;
-      apducmd.nsq60.obj.time.res3 = 0;
-      apducmd.nsq60.obj.time.res4 = 0;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-      oss.str("");
-      oss << "     STEP REG. COMMAND W/TIME ADDRESS "
-          << unsigned(obj->address)
-          << " RCS "
-          << unsigned(obj->rcs)
-          << " CA "
-          << obj->ca
-          << " QU "
-          << unsigned(obj->qu)
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      apducmd.nsq60.obj.time = now56;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     STEP REG. COMMAND W/TIME ADDRESS "
+            << unsigned(obj->address)
+            << " RCS "
+            << unsigned(obj->rcs)
+            << " CA "
+            << obj->ca
+            << " QU "
+            << unsigned(obj->qu)
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_SE_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq48);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2821,25 +2461,24 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq48.obj.nva = short(obj->value);
       apducmd.nsq48.obj.ql = 0;
       apducmd.nsq48.obj.se = obj->se;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     NORMALISED COMMAND ADDRESS "
-          << unsigned(obj->address)
-          << " VAL "
-          << short(obj->value)
-          << " CA "
-          << obj->ca
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     NORMALISED COMMAND ADDRESS "
+            << unsigned(obj->address)
+            << " VAL "
+            << short(obj->value)
+            << " CA "
+            << obj->ca
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_SE_TA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq61);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2853,39 +2492,25 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq61.obj.nva = short(obj->value);
       apducmd.nsq61.obj.ql = 0;
       apducmd.nsq61.obj.se = obj->se;
-      apducmd.nsq61.obj.time.year = static_cast<uint8_t>(agora->tm_year % 100);
-      apducmd.nsq61.obj.time.month = static_cast<uint8_t>(agora->tm_mon + 1);
-      apducmd.nsq61.obj.time.mday = static_cast<uint8_t>(agora->tm_mday);
-      apducmd.nsq61.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq61.obj.time.min = static_cast<uint8_t>(agora->tm_min);
-      apducmd.nsq61.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq61.obj.time.msec = static_cast<uint16_t>(agora->tm_sec * 1000);
-      apducmd.nsq61.obj.time.iv = 0;
-      apducmd.nsq61.obj.time.su = static_cast<uint8_t>(agora->tm_isdst);
-      apducmd.nsq61.obj.time.wday = static_cast<uint8_t>(agora->tm_wday);
-      apducmd.nsq61.obj.time.res1 = 0;
-      apducmd.nsq61.obj.time.res2 = 0;
-      apducmd.nsq61.obj.time.res3 = 0;
-      apducmd.nsq61.obj.time.res4 = 0;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     NORMALISED COMMAND W/TIME ADDRESS "
-          << unsigned(obj->address)
-          << " VAL "
-          << short(obj->value)
-          << " CA "
-          << obj->ca
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      apducmd.nsq61.obj.time = now56;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     NORMALISED COMMAND W/TIME ADDRESS "
+            << unsigned(obj->address)
+            << " VAL "
+            << short(obj->value)
+            << " CA "
+            << obj->ca
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_SE_NB_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq49);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2899,25 +2524,24 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq49.obj.sva = short(obj->value);
       apducmd.nsq49.obj.ql = 0;
       apducmd.nsq49.obj.se = obj->se;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     SCALED COMMAND ADDRESS "
-          << unsigned(obj->address)
-          << " VAL "
-          << short(obj->value)
-          << " CA "
-          << obj->ca
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     SCALED COMMAND ADDRESS "
+            << unsigned(obj->address)
+            << " VAL "
+            << short(obj->value)
+            << " CA "
+            << obj->ca
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_SE_TB_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq62);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2931,39 +2555,25 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq62.obj.sva = short(obj->value);
       apducmd.nsq62.obj.ql = 0;
       apducmd.nsq62.obj.se = obj->se;
-      apducmd.nsq62.obj.time.year = static_cast<uint8_t>(agora->tm_year % 100);
-      apducmd.nsq62.obj.time.month = static_cast<uint8_t>(agora->tm_mon + 1);
-      apducmd.nsq62.obj.time.mday = static_cast<uint8_t>(agora->tm_mday);
-      apducmd.nsq62.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq62.obj.time.min = static_cast<uint8_t>(agora->tm_min);
-      apducmd.nsq62.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq62.obj.time.msec = static_cast<uint16_t>(agora->tm_sec * 1000);
-      apducmd.nsq62.obj.time.iv = 0;
-      apducmd.nsq62.obj.time.su = static_cast<uint8_t>(agora->tm_isdst);
-      apducmd.nsq62.obj.time.wday = static_cast<uint8_t>(agora->tm_wday);
-      apducmd.nsq62.obj.time.res1 = 0;
-      apducmd.nsq62.obj.time.res2 = 0;
-      apducmd.nsq62.obj.time.res3 = 0;
-      apducmd.nsq62.obj.time.res4 = 0;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     SCALED COMMAND W/TIME ADDRESS "
-          << unsigned(obj->address)
-          << " VAL "
-          << short(obj->value)
-          << " CA "
-          << obj->ca
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      apducmd.nsq62.obj.time = now56;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     SCALED COMMAND W/TIME ADDRESS "
+            << unsigned(obj->address)
+            << " VAL "
+            << short(obj->value)
+            << " CA "
+            << obj->ca
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_SE_NC_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq50);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -2977,25 +2587,24 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq50.obj.r32 = float(obj->value);
       apducmd.nsq50.obj.ql = 0;
       apducmd.nsq50.obj.se = obj->se;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     FLOAT COMMAND ADDRESS "
-          << unsigned(obj->address)
-          << " VAL "
-          << obj->value
-          << " CA "
-          << obj->ca
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     FLOAT COMMAND ADDRESS "
+            << unsigned(obj->address)
+            << " VAL "
+            << obj->value
+            << " CA "
+            << obj->ca
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_SE_TC_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq63);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3009,39 +2618,25 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq63.obj.r32 = float(obj->value);
       apducmd.nsq63.obj.ql = 0;
       apducmd.nsq63.obj.se = obj->se;
-      apducmd.nsq63.obj.time.year = static_cast<uint8_t>(agora->tm_year % 100);
-      apducmd.nsq63.obj.time.month = static_cast<uint8_t>(agora->tm_mon + 1);
-      apducmd.nsq63.obj.time.mday = static_cast<uint8_t>(agora->tm_mday);
-      apducmd.nsq63.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq63.obj.time.min = static_cast<uint8_t>(agora->tm_min);
-      apducmd.nsq63.obj.time.hour = static_cast<uint8_t>(agora->tm_hour);
-      apducmd.nsq63.obj.time.msec = static_cast<uint16_t>(agora->tm_sec * 1000);
-      apducmd.nsq63.obj.time.iv = 0;
-      apducmd.nsq63.obj.time.su = static_cast<uint8_t>(agora->tm_isdst);
-      apducmd.nsq63.obj.time.wday = static_cast<uint8_t>(agora->tm_wday);
-      apducmd.nsq63.obj.time.res1 = 0;
-      apducmd.nsq63.obj.time.res2 = 0;
-      apducmd.nsq63.obj.time.res3 = 0;
-      apducmd.nsq63.obj.time.res4 = 0;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     SCALED COMMAND W/TIME ADDRESS "
-          << unsigned(obj->address)
-          << " VAL "
-          << obj->value
-          << " CA "
-          << obj->ca
-          << " SE "
-          << unsigned(obj->se);
-      mLog.pushMsg(oss.str().c_str());
+      apducmd.nsq63.obj.time = now56;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     SCALED COMMAND W/TIME ADDRESS "
+            << unsigned(obj->address)
+            << " VAL "
+            << obj->value
+            << " CA "
+            << obj->ca
+            << " SE "
+            << unsigned(obj->se);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_CS_NA_1: // Clock Sync
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.asdu103);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3053,23 +2648,22 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.asdu103.ioa8 = 0;
       apducmd.asdu103.ioa16 = 0;
       apducmd.asdu103.time = obj->timetag;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     CLOCK SYNC COMMAND "
-          << " CA "
-          << obj->ca << " "
-          << unsigned(obj->timetag.year) << "year " << unsigned(obj->timetag.month) << "month " << unsigned(obj->timetag.mday) << "day "
-          << unsigned(obj->timetag.hour) << "hour " << unsigned(obj->timetag.min) << "min " << unsigned(obj->timetag.msec / 1000) << "sec "
-          << unsigned(obj->timetag.msec % 1000) << "msec";
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     CLOCK SYNC COMMAND "
+            << " CA "
+            << obj->ca << " "
+            << unsigned(obj->timetag.year) << "year " << unsigned(obj->timetag.month) << "month " << unsigned(obj->timetag.mday) << "day "
+            << unsigned(obj->timetag.hour) << "hour " << unsigned(obj->timetag.min) << "min " << unsigned(obj->timetag.msec / 1000) << "sec "
+            << unsigned(obj->timetag.msec % 1000) << "msec";
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_RP_NA_1: // reset process command
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.asdu107);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
       apducmd.asduh.cause = obj->cause;
@@ -3078,20 +2672,19 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.asduh.oa = masterAddress;
       apducmd.asduh.ca = obj->ca;
       apducmd.asdu105.qrp = static_cast<unsigned char>(obj->value);
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     RESET PROCESS COMMAND"
-          << " QRP "
-          << unsigned(apducmd.asdu105.qrp);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     RESET PROCESS COMMAND"
+            << " QRP "
+            << unsigned(apducmd.asdu105.qrp);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_TS_TA_1: // test command with time tag
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.asdu107);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3105,23 +2698,22 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.asdu107.time = obj->timetag;
       apducmd.asdu107.tsc = test_command_count;
       test_command_count++;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     TEST COMMAND WITH TIME TAG"
-          << " TSC "
-          << apducmd.asdu107.tsc << " "
-          << unsigned(obj->timetag.year) << "year " << unsigned(obj->timetag.month) << "month " << unsigned(obj->timetag.mday) << "day "
-          << unsigned(obj->timetag.hour) << "hour " << unsigned(obj->timetag.min) << "min " << unsigned(obj->timetag.msec / 1000) << "sec "
-          << unsigned(obj->timetag.msec % 1000) << "msec";
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     TEST COMMAND WITH TIME TAG"
+            << " TSC "
+            << apducmd.asdu107.tsc << " "
+            << unsigned(obj->timetag.year) << "year " << unsigned(obj->timetag.month) << "month " << unsigned(obj->timetag.mday) << "day "
+            << unsigned(obj->timetag.hour) << "hour " << unsigned(obj->timetag.min) << "min " << unsigned(obj->timetag.msec / 1000) << "sec "
+            << unsigned(obj->timetag.msec % 1000) << "msec";
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case P_ME_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq110);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3136,29 +2728,28 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq110.obj.kpa = obj->kpa;
       apducmd.nsq110.obj.lpc = obj->lpc;
       apducmd.nsq110.obj.pop = obj->pop;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     PARAMETER OF MEASURED NORMALIZED VALUE, ADDRESS "
-          << unsigned(obj->address)
-          << " CA "
-          << obj->ca
-          << " VAL "
-          << short(obj->value)
-          << " KPA "
-          << unsigned(obj->kpa)
-          << " POP "
-          << unsigned(obj->pop)
-          << " LPC "
-          << unsigned(obj->lpc);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     PARAMETER OF MEASURED NORMALIZED VALUE, ADDRESS "
+            << unsigned(obj->address)
+            << " CA "
+            << obj->ca
+            << " VAL "
+            << short(obj->value)
+            << " KPA "
+            << unsigned(obj->kpa)
+            << " POP "
+            << unsigned(obj->pop)
+            << " LPC "
+            << unsigned(obj->lpc);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case P_ME_NB_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq111);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3173,29 +2764,28 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq111.obj.kpa = obj->kpa;
       apducmd.nsq111.obj.lpc = obj->lpc;
       apducmd.nsq111.obj.pop = obj->pop;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     PARAMETER OF MEASURED SCALED VALUE, ADDRESS "
-          << unsigned(obj->address)
-          << " CA "
-          << obj->ca
-          << " VAL "
-          << short(obj->value)
-          << " KPA "
-          << unsigned(obj->kpa)
-          << " POP "
-          << unsigned(obj->pop)
-          << " LPC "
-          << unsigned(obj->lpc);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     PARAMETER OF MEASURED SCALED VALUE, ADDRESS "
+            << unsigned(obj->address)
+            << " CA "
+            << obj->ca
+            << " VAL "
+            << short(obj->value)
+            << " KPA "
+            << unsigned(obj->kpa)
+            << " POP "
+            << unsigned(obj->pop)
+            << " LPC "
+            << unsigned(obj->lpc);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case P_ME_NC_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq112);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3210,29 +2800,28 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq112.obj.kpa = obj->kpa;
       apducmd.nsq112.obj.lpc = obj->lpc;
       apducmd.nsq112.obj.pop = obj->pop;
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     PARAMETER OF MEASURED FLOAT VALUE, ADDRESS "
-          << unsigned(obj->address)
-          << " CA "
-          << obj->ca
-          << " VAL "
-          << double(obj->value)
-          << " KPA "
-          << unsigned(obj->kpa)
-          << " POP "
-          << unsigned(obj->pop)
-          << " LPC "
-          << unsigned(obj->lpc);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     PARAMETER OF MEASURED FLOAT VALUE, ADDRESS "
+            << unsigned(obj->address)
+            << " CA "
+            << obj->ca
+            << " VAL "
+            << double(obj->value)
+            << " KPA "
+            << unsigned(obj->kpa)
+            << " POP "
+            << unsigned(obj->pop)
+            << " LPC "
+            << unsigned(obj->lpc);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case P_AC_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.nsq113);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3244,23 +2833,22 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.nsq113.ioa16 = obj->address & 0x0000FFFF;
       apducmd.nsq113.ioa8 = static_cast<uint8_t>(obj->address >> 16);
       apducmd.nsq113.obj.qpa = short(obj->qpa);
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     PARAMETER ACTIVATION, ADDRESS "
-          << unsigned(obj->address)
-          << " QPA "
-          << short(obj->qpa)
-          << " CA "
-          << obj->ca;
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     PARAMETER ACTIVATION, ADDRESS "
+            << unsigned(obj->address)
+            << " QPA "
+            << short(obj->qpa)
+            << " CA "
+            << obj->ca;
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_CI_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.asdu101);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3273,21 +2861,20 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.asdu101.ioa8 = static_cast<uint8_t>(obj->address >> 16);
       apducmd.asdu101.frz = obj->qu;
       apducmd.asdu101.rqt = uint8_t(obj->value);
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
-
-      oss.str("");
-      oss << "     COUNTER INTERROGATION COMMAND, ADDRESS "
-          << unsigned(obj->address)
-          << " FRZ " << unsigned(obj->frz)
-          << " RQT " << unsigned(obj->value);
-      mLog.pushMsg(oss.str().c_str());
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
+
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     COUNTER INTERROGATION COMMAND, ADDRESS "
+            << unsigned(obj->address)
+            << " FRZ " << unsigned(obj->frz)
+            << " RQT " << unsigned(obj->value);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     case C_RD_NA_1:
       apducmd.start = START;
       apducmd.length = sizeof(apducmd.NS) + sizeof(apducmd.NR) + sizeof(apducmd.asduh) + sizeof(apducmd.asdu102);
-      apducmd.NS = VS;
-      apducmd.NR = VR;
       apducmd.asduh.type = obj->type;
       apducmd.asduh.num = 1;
       apducmd.asduh.sq = 0;
@@ -3298,18 +2885,24 @@ bool iec104_class::sendCommand(iec_obj* obj) {
       apducmd.asduh.ca = obj->ca;
       apducmd.asdu102.ioa16 = obj->address & 0x0000FFFF;
       apducmd.asdu102.ioa8 = static_cast<uint8_t>(obj->address >> 16);
-      sendTCP(reinterpret_cast<char*>(&apducmd), apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
-      VS += 2;
+      sendIFrame(&apducmd, apducmd.length + sizeof(apducmd.start) + sizeof(apducmd.length));
 
-      oss.str("");
-      oss << "     READ COMMAND, ADDRESS "
-          << unsigned(obj->address);
-      mLog.pushMsg(oss.str().c_str());
+      if (mLog.willLog()) {
+        stringstream oss;
+        oss << "     READ COMMAND, ADDRESS "
+            << unsigned(obj->address);
+        mLog.pushMsg(oss.str().c_str());
+      }
       break;
     default:
       return false;
   }
 
+  if (cmdTrack != nullptr && iec104_cmdtracker::tracked(obj->type)) {
+    stats.cmdSent++;
+    cmdTrack->sent(*obj, sbo_execute, monoUs());
+    armCmdTimer();
+  }
   return true;
 }
 
@@ -33,9 +33,19 @@
 // IEC 60870-5-104 BASE CLASS, MASTER IMPLEMENTATION
 
 #include "iec104_types.h"
+#include "iec104_capture.h"
+#include "iec104_framer.h"
+#include "iec104_gi.h"
+#include "iec104_stats.h"
+#include "iec104_time.h"
+#include "iec104_timerwheel.h"
 #include "logmsg.h"
+#include <array>
+#include <chrono>
+#include <deque>
 #include <map>
 #include <string>
+#include <vector>
 
 #pragma pack(push)
 #pragma pack(1) // byte aligned structures
@@ -90,10 +100,50 @@ struct iec_obj {
   uint8_t lpc : 1;  // lpc
   uint8_t ei : 1;   // elapsed invalid
   uint8_t test : 1; // test bit
+
+  int64_t arrival_us; // arrival (system clock), us since epoch
 };
 
 #pragma pack(pop)
 
+// quality of a point normalized over the types: the qualifier bits of its
+// type, the bits that do not apply to the type are clear
+enum iec_quality : uint8_t {
+  QUALITY_IV = 0x01, // invalid
+  QUALITY_NT = 0x02, // not topical
+  QUALITY_SB = 0x04, // substituted
+  QUALITY_BL = 0x08, // blocked
+  QUALITY_OV = 0x10, // overflow
+  QUALITY_T = 0x20,  // transient (step position)
+  QUALITY_CY = 0x40, // counter carry
+  QUALITY_EI = 0x80, // elapsed time invalid (protection events)
+};
+
+// POINTS OF AN ASDU IN COLUMNS
+// The fields of the decoded objects that the bulk consumers use (statistics,
+// SOE store, point cache), converted once per asdu to naturally aligned arrays:
+// their loops read only the columns they need, without packed struct or bit
+// field access. objs is the iec_obj view of the same points, for the others.
+struct iec_points {
+  unsigned size = 0;
+  const iec_obj *objs = nullptr;
+  int64_t time_us[IEC_OBJECT_MAX];    // time tag, us since epoch (-1: no time tag or not valid)
+  int64_t arrival_us[IEC_OBJECT_MAX]; // us since epoch
+  double value[IEC_OBJECT_MAX];
+  uint32_t address[IEC_OBJECT_MAX];
+  uint16_t ca[IEC_OBJECT_MAX];
+  uint8_t type[IEC_OBJECT_MAX];
+  uint8_t quality[IEC_OBJECT_MAX]; // iec_quality
+  // n objects of one type, mask: iec_quality bits of the type, timetag: the
+  // type has CP56Time2a time tags
+  void assign(const iec_obj *o, unsigned n, uint8_t mask, bool timetag);
+};
+
+class iec104_pointcache;
+class iec104_soe_writer;
+class iec104_deadband;
+class iec104_cmdtracker;
+
 class iec104_class {
 public:
   static const unsigned int M_SP_NA_1 = 1;  // single-point information
@@ -195,14 +245,20 @@ public:
 
   // ---- user called funcions, must be called by the user -----------------
   iec104_class();         // user called constructor on derived class
-  void onConnectTCP();    // user called, when tcp connected
+  // user called, when tcp connected, started: STARTDT was already confirmed
+  // on the connection (by the user, see QIec104 connect racing)
+  void onConnectTCP(bool started = false);
   void onDisconnectTCP(); // user called, when tcp disconnected
-  void onTimerSecond();   // user called, each second timer
-  void packetReadyTCP();  // user called, when packet ready to be read from tcp
-                          // connection
+  void packetReadyTCP();  // user called, when data ready to be read from tcp
+                          // connection (never blocks, partial apdus are kept)
+  void flushTCP();        // user called, after txReadyTCP(): sends the queued
+                          // frames in one sendTCP
 
   void solicitGI();                           // General Interrogation
   void solicitInterrogation(char group = 20); // Group interrogation
+  // general interrogation by groups: bit g for group g (1..16), up to
+  // parallel of them in progress at once, 0: station interrogation (QOI 20)
+  void setGIGroups(uint32_t groups, unsigned parallel) { giSched.configure(groups, parallel); }
   void setSecondaryIP(char *ip);
   void setSecondaryIP_backup(char *ip);
   char *getSecondaryIP();
@@ -214,25 +270,77 @@ public:
   int getPrimaryAddress();
   void disableSequenceOrderCheck(); // allow sequence out of order
   bool sendCommand(iec_obj *obj);   // Command, return false if not send
+  // commands in back-to-back apdus, in one tcp write (k window permitting),
+  // returns the number of commands sent
+  unsigned sendCommands(iec_obj *objs, unsigned numcmds);
   int getPortTCP();
   void setPortTCP(unsigned port);
   void setGIPeriod(unsigned period);
-  std::map<int, std::string> mapTiStr;
-  std::map<int, std::string> mapCauseStr;
-  std::string asduTiStr(int ti);
-  std::string causeStr(int cause);
+  unsigned getGIPeriod() const { return unsigned(gi_period); }
+  // k: max sent I-frames not acknowledged, w: acknowledge after w received
+  // I-frames (w <= k of the slave)
+  void setWindow(unsigned k, unsigned w);
+  // t1: acknowledge timeout of sent apdus, t2: acknowledge timeout when no
+  // data is sent, t3: test frame after idle time (seconds, ms resolution)
+  void setTimeouts(double t1, double t2, double t3);
+  int getTimeoutT1() const { return t1_ack; } // ms
+  // the protocol timers run on this wheel (not owned), shared by the sessions
+  // of a thread, default: a wheel of the session. The user advances the wheel
+  // (advance(monoMs())) at its nextDeadline(). Set before connecting.
+  void setTimerWheel(iec104_timerwheel *wheel);
+  iec104_timerwheel *timerWheel() { return timers; }
+  void stopTimers(); // cancel the protocol timers (session ending)
+  static const std::map<int, std::string> mapTiStr; // shared by all sessions
+  static const std::map<int, std::string> mapCauseStr;
+  static std::string asduTiStr(int ti);
+  static std::string causeStr(int cause);
+  const iec104_stats &getStats() const { return stats; } // protocol thread only
+  void clearStats() { stats.clear(); }
+  // record the frames of the link (nullptr: off), capture not owned
+  void setCapture(iec104_capture_writer *cap) { frameCapture = cap; }
+  // process a received apdu not read from the link (replay of a capture),
+  // nothing is sent in response
+  void replayAPDU(iec_apdu *papdu, int sz);
+  // last values of the points (nullptr: off), cache not owned.
+  // staleSeconds: when starting, only interrogate the groups with points not
+  // updated in this time (0: general interrogation as without a cache)
+  void setPointCache(iec104_pointcache *pc, unsigned staleSeconds);
+  // history of the time tagged points (nullptr: off), store not owned
+  void setSOE(iec104_soe_writer *soe) { soeStore = soe; }
+  // change filter of the measured values passed to dataIndication (nullptr:
+  // off), filter not owned
+  void setDeadband(iec104_deadband *db) { deadband = db; }
+  // commands in flight matched to their responses, for the latencies and the
+  // timeouts (nullptr: off), tracker not owned
+  void setCommandTracker(iec104_cmdtracker *trk) { cmdTrack = trk; }
+  // execute the selects at their positive ACTCON, on the protocol thread
+  // (needs the tracker)
+  void setSBOExecute(bool on) { sbo_execute = on; }
+  bool getSBOExecute() const { return sbo_execute; }
 
 private:
   unsigned short VS;      // sender packet control counter
   unsigned short VR;      // receiver packet control counter
   void confTestCommand(); // test command activation confirmation
   void sendStartDTACT();  // send STARTDTACT
-  int tout_startdtact;    // timeout control
+  void startDTConfirmed(); // STARTDTCON received
   void sendSupervisory(); // send supervisory window control frame
-  int tout_supervisory;   // countdown to send supervisory window control
-  int tout_gi;            // countdown to send general interrogation
-  int tout_testfr;        // countdown to send test frame
-  bool broken_msg = false;
+  unsigned short ackVS;   // NR received from slave, sent I-frames before it are acknowledged
+  unsigned rx_unack;      // I-frames received and not acknowledged since the last NR sent
+  bool ackReceived(unsigned short nr); // NR received from slave (I or S frame), false: disconnected
+  unsigned txUnack();                  // sent I-frames not acknowledged
+  void sendIFrame(iec_apdu *apdu, int sz); // send (or queue when k is reached) I-frame
+  void transmitIFrame(iec_apdu *apdu, int sz);
+  void sendFrame(const void *frame, int sz); // queue frame in the output buffer
+  static const unsigned tx_buf_max = 32 * 1024; // output buffer flushed at this size
+  std::vector<char> txBuf; // frames (already numbered) waiting for flushTCP
+  bool txHold = false;     // batch being queued, flushed by its caller
+  struct tx_frame {
+    iec_apdu apdu;
+    int sz;
+  };
+  std::deque<tx_frame> txQueue; // I-frames waiting for the k window
+  iec104_framer rxFramer; // receive stage, keeps partial apdus between reads
   bool connectedTCP; // tcp connection state
   bool
       seq_order_check; // if set: test message order, disconnect if out of order
@@ -244,14 +352,73 @@ private:
   unsigned Port;                   // iec104 tcp port (defaults to 2404)
   char slaveIP[21];                // slave (secondary, main RTU) IP address
   char slaveIP_backup[21];         // slave (secondary, backup RTU) IP address
-  static const int t3_testfr = 10;
-  static const int t2_supervisory = 8;
-  static const int t1_startdtact = 6;
-  int gi_period; // minimum time for request between GI's
+  int t3_testfr;      // ms
+  int t2_supervisory; // ms
+  int t1_ack;         // ms, also timeout of STARTDTACT
+  unsigned k_unack;   // max unacknowledged sent I-frames
+  unsigned w_ack;     // acknowledge after this received I-frames
+  int gi_period; // minimum time for request between GI's (seconds)
   static const int gi_retry_time =
       45; // wait time to retry when requested a GI and not responded
+  static const int gi_startup_time = 15; // GI after STARTDTCON (seconds)
+  // protocol timers, armed (monotonic ms deadlines) and cancelled on the events
+  iec104_timerwheel ownTimers{monoMs()};
+  iec104_timerwheel *timers = &ownTimers;
+  iec104_timer tmStartDT{[this] { startDTTimeout(); }}; // t1 of STARTDTACT, retry
+  iec104_timer tmAck{[this] { ackTimeout(); }};         // t1 of the sent I-frames
+  iec104_timer tmSupervisory{[this] { supervisoryTimeout(); }}; // t2 of the received I-frames
+  iec104_timer tmTestFr{[this] { testFrTimeout(); }};   // t3, from the last frame received
+  iec104_timer tmGI{[this] { giTimeout(); }};           // next general interrogation
+  iec104_timer tmCmd{[this] { cmdTimeout(); }};         // first command in flight to expire
+  void armTimer(iec104_timer &t, int64_t ms) { timers->arm(t, monoMs() + ms); }
+  void startDTTimeout();
+  void ackTimeout();
+  void supervisoryTimeout();
+  void testFrTimeout();
+  void giTimeout();
+  void cmdTimeout();
+  void armCmdTimer();
   unsigned short test_command_count = 0; // test command counter
-  char logPointBuf[15000] = "     ";
+  iec_obj objArena[IEC_OBJECT_MAX]; // decoded objects of the current asdu
+  iec104_stats stats;
+  typedef std::chrono::steady_clock stats_clock;
+  stats_clock::time_point rxTime; // tcp data of the current packetReadyTCP read
+  int64_t rxWallUs = 0;           // the same, us since epoch (arrival of the points)
+  iec_points points;              // columns of the objects of the current asdu
+  stats_clock::time_point giTime; // first ACTCON of the general interrogation
+  iec104_capture_writer *frameCapture = nullptr;
+  iec104_pointcache *pointCache = nullptr;
+  iec104_soe_writer *soeStore = nullptr;
+  iec104_deadband *deadband = nullptr;
+  iec104_cmdtracker *cmdTrack = nullptr;
+  bool sbo_execute = false;
+  void commandResponse(iec_obj *obj); // response of a command, to commandActRespIndication
+  unsigned cache_stale = 0;     // seconds, 0: no group interrogation from the cache
+  // link down longer than this (seconds): the points not updated since the link
+  // came up are stale, whatever their age (changes of the outage not received)
+  static const int cache_outage_time = 5;
+  int64_t linkDownMs = 0;       // wall clock the data transfer stopped, 0: not in this run
+  int64_t linkUpMs = 0;         // wall clock of the last STARTDTCON
+  bool gi_startup = false;      // next GI is the first of the connection
+  iec104_gischeduler giSched;   // interrogations of the GI in progress
+  void startupInterrogation();  // GI, or interrogation of the stale groups only
+  void sendInterrogation(int qoi);
+  void giPump(); // the interrogations that can be sent now
+
+  // table driven decoder of the monitor direction asdus, indexed by TI
+  typedef void (iec104_class::*asdu_decoder)(iec_apdu *papdu, int sz);
+  typedef int (*point_formatter)(char *buf, const iec_obj *obj);
+  struct asdu_decoder_entry {
+    asdu_decoder decode; // fills objArena from the asdu (nullptr: not a monitor type)
+    point_formatter fmt; // qualifier text of one decoded object, for the log
+    bool timetag;        // objects carry a CP56Time2a time tag
+    uint8_t quality;     // iec_quality bits of the type
+  };
+  template <class T> void decodeASDU(iec_apdu *papdu, int sz);
+  static constexpr std::array<asdu_decoder_entry, 256> makeDecoderTable();
+  static const std::array<asdu_decoder_entry, 256> decoderTable;
+  static const unsigned log_points_rec = TLogMsg::SLOT_DATA / sizeof(iec_obj); // decoded points per log record
+  static void renderPoints(std::string &out, const void *rec, unsigned size);
 
 protected:
   void LogFrame(char *frame, int size, bool is_send);
@@ -270,8 +437,6 @@ protected:
 
   // ---- pure virtual funcions, user defined on derived class (mandatory)---
 
-  // wait milliseconds for data bytes
-  virtual void waitBytes(int bytes, int msTout) = 0;
   // make tcp connection, user provided
   virtual void connectTCP() = 0;
   // tcp disconnect, user provided
@@ -287,7 +452,14 @@ protected:
 
   // user point process, user provided. (on one call must be only objects of one
   // type)
+  // obj points to the decoder arena of this connection, it is valid only until
+  // the call returns and is overwritten by the next asdu. Sinks that consume
+  // the points inside the call can use them in place (no copy), sinks that
+  // need the points later (queued signals, other threads) must copy them.
   virtual void dataIndication(iec_obj * /*obj*/, unsigned /*numpoints*/) {}
+  // the points of an asdu as the point cache records them, before the change
+  // filter of dataIndication (hot standby replication of the cache)
+  virtual void cacheIndication(iec_obj * /*obj*/, unsigned /*numpoints*/) {}
   // inform user that ACTCONFIRM of Interrogation was received from slave
   virtual void interrogationActConfIndication() {}
   // inform user that ACTTERM of Interrogation was received from slave
@@ -296,6 +468,10 @@ protected:
   virtual void commandActRespIndication(iec_obj * /*obj*/) {}
   // user process APDU
   virtual void userprocAPDU(iec_apdu * /* papdu */, int /* sz */) {}
+  // frames were queued to send, the user should call flushTCP() once the
+  // current event (tcp read, timer, request) is processed, so that all the
+  // frames queued meanwhile go in one tcp write. Default: flush now.
+  virtual void txReadyTCP() { flushTCP(); }
 
   // -------------------------------------------------------------------------
 };
@@ -0,0 +1,122 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_cmdtrack.h"
+
+bool iec104_cmdtracker::tracked(uint8_t type) {
+  return (type >= iec104_class::C_SC_NA_1 && type <= iec104_class::C_BO_TA_1) ||
+         type == iec104_class::C_CI_NA_1 ||
+         (type >= iec104_class::P_ME_NA_1 && type <= iec104_class::P_AC_NA_1);
+}
+
+bool iec104_cmdtracker::selectable(uint8_t type) {
+  return (type >= iec104_class::C_SC_NA_1 && type <= iec104_class::C_SE_NC_1) ||
+         (type >= iec104_class::C_SC_TA_1 && type <= iec104_class::C_SE_TC_1);
+}
+
+iec104_command *iec104_cmdtracker::find(uint16_t ca, uint32_t address, uint8_t type) {
+  for (iec104_command &c : mCmds)
+    if (c.cmd.address == address && c.cmd.ca == ca && c.cmd.type == type)
+      return &c;
+  return nullptr;
+}
+
+void iec104_cmdtracker::remove(iec104_command *c) {
+  *c = mCmds.back();
+  mCmds.pop_back();
+}
+
+void iec104_cmdtracker::sent(const iec_obj &cmd, bool autoExecute, int64_t now_us) {
+  bool select = selectable(cmd.type) && cmd.se == iec104_class::SELECT;
+  iec104_command *c = find(cmd.ca, cmd.address, cmd.type);
+  int64_t start = now_us;
+  if (c == nullptr) {
+    mCmds.emplace_back();
+    c = &mCmds.back();
+  } else if (c->select && !select) {
+    start = c->startUs;
+  }
+  c->cmd = cmd;
+  c->select = select;
+  c->autoExecute = autoExecute && select;
+  c->confirmed = false;
+  c->startUs = start;
+  c->sentUs = now_us;
+  c->deadlineUs = deadline(now_us);
+}
+
+iec104_cmdtracker::result iec104_cmdtracker::response(const iec_obj &resp, int64_t now_us,
+                                                      int64_t &latency_us, iec104_command &cmd) {
+  iec104_command *c = find(resp.ca, resp.address, resp.type);
+  if (c == nullptr)
+    return UNMATCHED;
+  cmd = *c;
+  if (resp.cause == iec104_class::ACTTERM) {
+    latency_us = now_us - c->startUs;
+    remove(c);
+    return TERMINATED;
+  }
+  if (resp.pn == iec104_class::NEGATIVE) { // ACTCON or unknown type/cause/CA/IOA
+    latency_us = now_us - c->sentUs;
+    remove(c);
+    return CONFIRMED;
+  }
+  if (resp.cause != iec104_class::ACTCONFIRM)
+    return UNMATCHED;
+  latency_us = now_us - c->sentUs;
+  if (c->select) {
+    // kept for the execute (of the engine or of the user), the sequence timed
+    // as one, or forgotten at the timeout
+    c->confirmed = true;
+    c->deadlineUs = deadline(now_us);
+    return SELECTED;
+  }
+  c->confirmed = true;
+  c->deadlineUs = deadline(now_us);
+  return CONFIRMED;
+}
+
+void iec104_cmdtracker::expire(int64_t now_us, std::vector<iec104_command> &expired) {
+  for (size_t i = 0; i < mCmds.size();)
+    if (mCmds[i].deadlineUs >= 0 && mCmds[i].deadlineUs <= now_us) {
+      expired.push_back(mCmds[i]);
+      remove(&mCmds[i]);
+    } else {
+      i++;
+    }
+}
+
+int64_t iec104_cmdtracker::nextDeadline() const {
+  int64_t d = -1;
+  for (const iec104_command &c : mCmds)
+    if (c.deadlineUs >= 0 && (d < 0 || c.deadlineUs < d))
+      d = c.deadlineUs;
+  return d;
+}
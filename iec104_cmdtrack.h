@@ -0,0 +1,83 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_CMDTRACK_H
+#define IEC104_CMDTRACK_H
+
+// COMMANDS IN FLIGHT, MATCHED TO THEIR RESPONSES
+// The commands sent (TI 45..64, 101, 110..113) by (CA, IOA, TI) until their
+// ACTCON and ACTTERM, for the latencies, or the timeout. One command per
+// point, those of different points overlap: the selects of several points
+// wait for their ACTCON at once, each point executed at its own.
+
+#include <stdint.h>
+#include <vector>
+#include "iec104_class.h"
+
+struct iec104_command {
+  iec_obj cmd;        // as sent
+  bool select;        // select of a select-execute (TI with the S/E qualifier)
+  bool autoExecute;   // select executed by the engine at its positive ACTCON
+  bool confirmed;     // ACTCON received, waiting ACTTERM (or the execute of a select)
+  int64_t startUs;    // first command of the point (the select), steady clock
+  int64_t sentUs;     // this command
+  int64_t deadlineUs; // ACTCON or ACTTERM expected before, -1: no timeout
+};
+
+class iec104_cmdtracker {
+public:
+  enum result {
+    UNMATCHED,  // no command of the point in flight
+    SELECTED,   // positive ACTCON of a select, latency from sent
+    CONFIRMED,  // ACTCON of an execute, or negative response, latency from sent
+    TERMINATED, // ACTTERM, latency from the start (the select)
+  };
+  static bool tracked(uint8_t type);
+  static bool selectable(uint8_t type);
+  void setTimeout(int64_t us) { mTimeoutUs = us; } // 0 or less: no timeout
+  // an execute after the select of its point continues the sequence
+  void sent(const iec_obj &cmd, bool autoExecute, int64_t now_us);
+  // ACTCON, ACTTERM or negative response, cmd: copy of the command matched
+  result response(const iec_obj &resp, int64_t now_us, int64_t &latency_us, iec104_command &cmd);
+  // commands past their deadline, removed
+  void expire(int64_t now_us, std::vector<iec104_command> &expired);
+  int64_t nextDeadline() const; // us, -1: none
+  size_t size() const { return mCmds.size(); }
+  void clear() { mCmds.clear(); }
+
+private:
+  std::vector<iec104_command> mCmds; // a few, searched linearly
+  int64_t mTimeoutUs = 30000000;
+  iec104_command *find(uint16_t ca, uint32_t address, uint8_t type);
+  void remove(iec104_command *c);
+  int64_t deadline(int64_t now_us) const { return mTimeoutUs > 0 ? now_us + mTimeoutUs : -1; }
+};
+
+#endif // IEC104_CMDTRACK_H
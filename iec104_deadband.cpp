@@ -0,0 +1,112 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_deadband.h"
+#include <math.h>
+
+void iec104_deadband::configure(double absolute, double percent, bool cyclicChanged) {
+  mAbsolute = absolute > 0 ? absolute : 0;
+  mPercent = percent > 0 ? percent : 0;
+  mCyclicChanged = cyclicChanged;
+}
+
+bool iec104_deadband::measured(uint8_t type) {
+  return (type >= iec104_class::M_ME_NA_1 && type <= iec104_class::M_ME_NC_1) ||
+         type == iec104_class::M_ME_ND_1 ||
+         (type >= iec104_class::M_ME_TD_1 && type <= iec104_class::M_ME_TF_1);
+}
+
+void iec104_deadband::grow() {
+  std::vector<rec> old;
+  old.swap(mTable);
+  mTable.assign(old.empty() ? 1024 : old.size() * 2, rec{0, 0, 0, 0, 0});
+  mCount = 0;
+  for (const rec &r : old)
+    if (r.used) {
+      rec *n = find(r.ca, r.address);
+      *n = r;
+    }
+}
+
+// the record of the point, a new one (used 0) when not found
+iec104_deadband::rec *iec104_deadband::find(uint16_t ca, uint32_t address) {
+  if (mCount >= mTable.size() / 4 * 3)
+    grow();
+  size_t mask = mTable.size() - 1;
+  uint64_t key = (uint64_t(ca) << 24) | (address & 0xFFFFFF);
+  size_t h = size_t((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+  for (;; h = (h + 1) & mask) {
+    rec *r = &mTable[h];
+    if (!r->used) {
+      r->ca = ca;
+      r->address = address;
+      mCount++;
+      return r;
+    }
+    if (r->ca == ca && r->address == address)
+      return r;
+  }
+}
+
+unsigned iec104_deadband::filter(const iec_points &points, iec_obj *objs) {
+  if (points.size == 0 || !measured(points.type[0]))
+    return points.size;
+  // COT 20..36, the whole state asked for
+  uint8_t cause = points.objs[0].cause;
+  bool interrogated = cause >= 20 && cause <= 36;
+  bool cyclic = cause == iec104_class::CYCLIC;
+  unsigned n = 0;
+  for (unsigned i = 0; i < points.size; i++) {
+    rec *r = find(points.ca[i], points.address[i]);
+    double v = points.value[i];
+    bool pass = !r->used || interrogated || r->quality != points.quality[i];
+    if (!pass) {
+      double delta = fabs(v - r->value);
+      double band = mPercent * fabs(r->value) / 100;
+      if (band < mAbsolute)
+        band = mAbsolute;
+      if (band > 0)
+        pass = delta >= band;
+      else
+        pass = !(cyclic && mCyclicChanged) || v != r->value;
+    }
+    if (!pass) {
+      mDropped++;
+      continue;
+    }
+    r->used = 1;
+    r->quality = points.quality[i];
+    r->value = v;
+    if (n != i)
+      objs[n] = objs[i];
+    n++;
+  }
+  return n;
+}
@@ -0,0 +1,75 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_DEADBAND_H
+#define IEC104_DEADBAND_H
+
+// CHANGE FILTER OF THE MEASURED VALUES, IN FRONT OF THE CONSUMERS
+// The last value passed of each measured point (TI 9..14, 21, 34..36) keyed by
+// (CA, IOA): a value is dropped when it moved less than the deadband from it,
+// with the same quality. Interrogation responses, quality changes and the first
+// value of a point always pass, the other types are not filtered. The point
+// cache, the SOE store and the statistics see all the points.
+
+#include <vector>
+#include "iec104_class.h"
+
+class iec104_deadband {
+public:
+  // absolute: deadband in the units of the value, percent: of the last value
+  // passed (the larger of the two applies), cyclicChanged: cyclic values
+  // (COT 1) pass only when changed
+  void configure(double absolute, double percent, bool cyclicChanged);
+  bool active() const { return mAbsolute > 0 || mPercent > 0 || mCyclicChanged; }
+  // the objects of points that pass, compacted at the start of objs (the
+  // objects of points), returns their number
+  unsigned filter(const iec_points &points, iec_obj *objs);
+  uint64_t dropped() const { return mDropped; }
+  void clear() { mTable.clear(); mCount = 0; }
+
+private:
+  struct rec {
+    uint32_t address;
+    uint16_t ca;
+    uint8_t used;
+    uint8_t quality;
+    double value;
+  };
+  std::vector<rec> mTable; // open addressing, power of 2, up to 3/4 full
+  size_t mCount = 0;
+  double mAbsolute = 0, mPercent = 0;
+  bool mCyclicChanged = false;
+  uint64_t mDropped = 0;
+  rec *find(uint16_t ca, uint32_t address);
+  void grow();
+  static bool measured(uint8_t type);
+};
+
+#endif // IEC104_DEADBAND_H
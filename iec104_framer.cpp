@@ -0,0 +1,107 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include <string.h>
+
+#include "iec104_framer.h"
+
+static const unsigned char START = 0x68;
+
+iec104_framer::iec104_framer() {
+  clear();
+}
+
+void iec104_framer::clear() {
+  rd = 0;
+  wr = 0;
+  discarded = 0;
+}
+
+unsigned iec104_framer::size() const {
+  return wr - rd;
+}
+
+unsigned iec104_framer::freeSpace() const {
+  return BUFSIZE - size();
+}
+
+char* iec104_framer::writePtr(unsigned& contig) {
+  unsigned pos = wr & (BUFSIZE - 1);
+  contig = BUFSIZE - pos;
+  if (contig > freeSpace())
+    contig = freeSpace();
+  return reinterpret_cast<char*>(buf + pos);
+}
+
+void iec104_framer::commit(unsigned n) {
+  if (n > freeSpace())
+    n = freeSpace();
+  wr += n;
+}
+
+unsigned iec104_framer::discardedBytes() const {
+  return discarded;
+}
+
+int iec104_framer::nextAPDU(iec_apdu* papdu) {
+  // look for a START
+  while (size() > 0 && at(rd) != START) {
+    rd++;
+    discarded++;
+  }
+
+  if (size() < 2)
+    return 0;
+
+  unsigned len = at(rd + 1);
+  if (len < 4 || len > APDU_MAXLEN) {
+    // apdu length must be >= 4, skip this START and resync on the next one
+    rd++;
+    discarded++;
+    return -1;
+  }
+
+  unsigned apdusz = len + 2;
+  if (size() < apdusz)
+    return 0; // wait for the rest of the apdu on the next read
+
+  // copy out, the apdu may wrap around the end of the buffer
+  unsigned pos = rd & (BUFSIZE - 1);
+  unsigned first = BUFSIZE - pos;
+  unsigned char* dst = reinterpret_cast<unsigned char*>(papdu);
+  if (first >= apdusz) {
+    memcpy(dst, buf + pos, apdusz);
+  } else {
+    memcpy(dst, buf + pos, first);
+    memcpy(dst + first, buf, apdusz - first);
+  }
+  rd += apdusz;
+
+  return int(apdusz);
+}
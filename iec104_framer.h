@@ -0,0 +1,65 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef IEC104_FRAMER_H
+#define IEC104_FRAMER_H
+
+// IEC 60870-5-104 RECEIVE STAGE, SPLITS A TCP BYTE STREAM IN APDUS
+
+#include "iec104_types.h"
+
+class iec104_framer {
+public:
+  static const unsigned BUFSIZE = 8192; // ring buffer size, must be a power of 2
+  static const unsigned APDU_MAXLEN = 253; // max value of the apdu length field
+
+  iec104_framer();
+  void clear();             // discard all buffered bytes
+  unsigned size() const;    // bytes buffered
+  unsigned freeSpace() const;
+  // contiguous free area to write into, contig returns the usable size
+  // (can be less than freeSpace() when the free area wraps around)
+  char *writePtr(unsigned &contig);
+  void commit(unsigned n); // n bytes were written at writePtr()
+  // copies the next complete apdu to papdu
+  // return: apdu size (length field + 2) when found,
+  //         0 when no complete apdu is buffered (a partial one is kept),
+  //         -1 when an invalid frame header was discarded
+  int nextAPDU(iec_apdu *papdu);
+  unsigned discardedBytes() const; // bytes skipped looking for START
+
+private:
+  unsigned char buf[BUFSIZE];
+  unsigned rd; // read index (free running, masked on access)
+  unsigned wr; // write index (free running, masked on access)
+  unsigned discarded;
+  unsigned char at(unsigned pos) const { return buf[pos & (BUFSIZE - 1)]; }
+};
+
+#endif // IEC104_FRAMER_H
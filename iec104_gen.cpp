@@ -0,0 +1,120 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_gen.h"
+#include "iec104_time.h"
+#include <string.h>
+
+namespace {
+
+// apdu bytes after the control field and the asdu header
+const unsigned ASDU_DATA_MAX = iec104_framer::APDU_MAXLEN - 4 - sizeof(iec_unit_id);
+
+cp56time2a now56; // time tag of the asdu being encoded
+
+// point value of each generated type, the qualifiers are zero (good quality)
+void setPoint(iec_type1 &o, unsigned v) { o.sp = v & 1; }
+void setPoint(iec_type3 &o, unsigned v) { o.dp = 1 + (v & 1); }
+void setPoint(iec_type5 &o, unsigned v) { o.mv = v & 0x3F; }
+void setPoint(iec_type7 &o, unsigned v) { o.bsi.bsi = v; }
+void setPoint(iec_type9 &o, unsigned v) { o.mv = int16_t(v); }
+void setPoint(iec_type11 &o, unsigned v) { o.mv = int16_t(v); }
+void setPoint(iec_type13 &o, unsigned v) { o.mv = float(v) / 10; }
+void setPoint(iec_type15 &o, unsigned v) { o.bcr = v; o.sq = v & 0x1F; }
+void setPoint(iec_type21 &o, unsigned v) { o.mv = int16_t(v); }
+void setPoint(iec_type30 &o, unsigned v) { o.sp = v & 1; o.time = now56; }
+void setPoint(iec_type31 &o, unsigned v) { o.dp = 1 + (v & 1); o.time = now56; }
+void setPoint(iec_type32 &o, unsigned v) { o.mv = v & 0x3F; o.time = now56; }
+void setPoint(iec_type33 &o, unsigned v) { o.bsi.bsi = v; o.time = now56; }
+void setPoint(iec_type34 &o, unsigned v) { o.mv = int16_t(v); o.time = now56; }
+void setPoint(iec_type35 &o, unsigned v) { o.mv = int16_t(v); o.time = now56; }
+void setPoint(iec_type36 &o, unsigned v) { o.mv = float(v) / 10; o.time = now56; }
+void setPoint(iec_type37 &o, unsigned v) { o.bcr = v; o.sq = v & 0x1F; o.time = now56; }
+
+template <class T>
+unsigned encodeT(iec_apdu &apdu, bool sq, uint32_t ioa, unsigned n, unsigned v) {
+  unsigned maxn = sq ? (ASDU_DATA_MAX - 3) / sizeof(T) : ASDU_DATA_MAX / sizeof(iec_nsq_obj<T>);
+  if (maxn > 127)
+    maxn = 127;
+  if (n > maxn)
+    n = maxn;
+  unsigned len;
+  if (sq) {
+    apdu.sq1.ioa16 = uint16_t(ioa);
+    apdu.sq1.ioa8 = uint8_t(ioa >> 16);
+    T *o = reinterpret_cast<T *>(apdu.dados + 3);
+    memset(o, 0, n * sizeof(T));
+    for (unsigned i = 0; i < n; i++)
+      setPoint(o[i], v + i);
+    len = 3 + n * sizeof(T);
+  } else {
+    iec_nsq_obj<T> *o = reinterpret_cast<iec_nsq_obj<T> *>(apdu.dados);
+    memset(o, 0, n * sizeof(iec_nsq_obj<T>));
+    for (unsigned i = 0; i < n; i++) {
+      o[i].ioa16 = uint16_t(ioa + i);
+      o[i].ioa8 = uint8_t((ioa + i) >> 16);
+      setPoint(o[i].obj, v + i);
+    }
+    len = n * sizeof(iec_nsq_obj<T>);
+  }
+  apdu.asduh.num = n & 0x7F;
+  apdu.asduh.sq = sq;
+  apdu.length = uint8_t(4 + sizeof(iec_unit_id) + len);
+  return n;
+}
+
+} // namespace
+
+void iec104_genTime() { cp56time2aNow(now56); }
+
+unsigned iec104_genASDU(iec_apdu &apdu, unsigned ti, bool sq, uint32_t ioa,
+                        unsigned n, unsigned v) {
+  apdu.asduh.type = uint8_t(ti);
+  switch (ti) {
+  case 1: return encodeT<iec_type1>(apdu, sq, ioa, n, v);
+  case 3: return encodeT<iec_type3>(apdu, sq, ioa, n, v);
+  case 5: return encodeT<iec_type5>(apdu, sq, ioa, n, v);
+  case 7: return encodeT<iec_type7>(apdu, sq, ioa, n, v);
+  case 9: return encodeT<iec_type9>(apdu, sq, ioa, n, v);
+  case 11: return encodeT<iec_type11>(apdu, sq, ioa, n, v);
+  case 13: return encodeT<iec_type13>(apdu, sq, ioa, n, v);
+  case 15: return encodeT<iec_type15>(apdu, sq, ioa, n, v);
+  case 21: return encodeT<iec_type21>(apdu, sq, ioa, n, v);
+  case 30: return encodeT<iec_type30>(apdu, sq, ioa, n, v);
+  case 31: return encodeT<iec_type31>(apdu, sq, ioa, n, v);
+  case 32: return encodeT<iec_type32>(apdu, sq, ioa, n, v);
+  case 33: return encodeT<iec_type33>(apdu, sq, ioa, n, v);
+  case 34: return encodeT<iec_type34>(apdu, sq, ioa, n, v);
+  case 35: return encodeT<iec_type35>(apdu, sq, ioa, n, v);
+  case 36: return encodeT<iec_type36>(apdu, sq, ioa, n, v);
+  case 37: return encodeT<iec_type37>(apdu, sq, ioa, n, v);
+  default: return 0;
+  }
+}
@@ -0,0 +1,49 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_GEN_H
+#define IEC104_GEN_H
+
+// IEC 60870-5-104 MONITOR DIRECTION ASDU GENERATOR (SLAVE SIMULATOR, BENCHMARKS)
+
+#include "iec104_types.h"
+#include "iec104_framer.h"
+
+// points of type ti from address ioa in one asdu (split at the apdu size),
+// value v is used for the first point and incremented. Sets type, num, sq and
+// the apdu length, not the cause nor the addresses. Returns the number of
+// points encoded, 0 if the type is not generated (generated: 1, 3, 5, 7, 9,
+// 11, 13, 15, 21, 30..37)
+unsigned iec104_genASDU(iec_apdu &apdu, unsigned ti, bool sq, uint32_t ioa,
+                        unsigned n, unsigned v);
+// time tag of the asdus generated next: now
+void iec104_genTime();
+
+#endif // IEC104_GEN_H
@@ -0,0 +1,192 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_gi.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void iec104_gischeduler::configure(uint32_t groups, unsigned parallel) {
+  mGroups = groups & 0x1FFFE;
+  mParallel = parallel < 1 ? 1 : parallel > 16 ? 16 : parallel;
+}
+
+void iec104_gischeduler::clear() {
+  for (entry &e : mQ) {
+    e.st = IDLE;
+    e.tries = 0;
+    e.refused = false;
+    e.received = 0;
+  }
+  mTotal = mDone = 0;
+}
+
+void iec104_gischeduler::start(uint32_t groups) {
+  uint32_t g = groups ? groups & 0x1FFFE : mGroups;
+  clear();
+  for (int i = 0; i <= 16; i++)
+    if (g == 0 ? i == 0 : (g & (1u << i)) != 0) {
+      mQ[i].st = PENDING;
+      mTotal++;
+    }
+}
+
+unsigned iec104_gischeduler::inProgress() const {
+  unsigned n = 0;
+  for (const entry &e : mQ)
+    if (e.st == SENT || e.st == ACTIVE)
+      n++;
+  return n;
+}
+
+int iec104_gischeduler::next() {
+  if (inProgress() >= mParallel)
+    return -1;
+  for (int i = 0; i <= 16; i++)
+    if (mQ[i].st == PENDING) {
+      mQ[i].st = SENT;
+      mQ[i].tries++;
+      mQ[i].received = 0;
+      return 20 + i;
+    }
+  return -1;
+}
+
+void iec104_gischeduler::actCon(int qoi, bool negative) {
+  int i = index(qoi);
+  if (i < 0 || mQ[i].st != SENT)
+    return;
+  if (negative) {
+    // not supported by the slave, not repeated
+    mQ[i].st = DONE;
+    mQ[i].refused = true;
+    mDone++;
+  } else
+    mQ[i].st = ACTIVE;
+}
+
+void iec104_gischeduler::actTerm(int qoi) {
+  int i = index(qoi);
+  // ACTCON may be missing
+  if (i < 0 || (mQ[i].st != SENT && mQ[i].st != ACTIVE))
+    return;
+  entry &e = mQ[i];
+  if (e.expected != 0 && e.received < e.expected && e.tries <= MAX_RETRIES) {
+    e.st = PENDING;
+    mRetries++;
+    return;
+  }
+  // the count of the slave when complete, or when short again after the retries
+  e.expected = e.received;
+  e.st = DONE;
+  mDone++;
+}
+
+void iec104_gischeduler::objects(int cause, unsigned n) {
+  int i = index(cause);
+  if (i >= 0 && (mQ[i].st == SENT || mQ[i].st == ACTIVE))
+    mQ[i].received += n;
+}
+
+unsigned iec104_gischeduler::timeout() {
+  unsigned n = 0;
+  for (entry &e : mQ)
+    if (e.st == SENT || e.st == ACTIVE) {
+      if (e.tries <= MAX_RETRIES) {
+        e.st = PENDING;
+        mRetries++;
+        n++;
+      } else {
+        e.st = DONE;
+        mDone++;
+      }
+    }
+  return n;
+}
+
+uint64_t iec104_gischeduler::received() const {
+  uint64_t n = 0;
+  for (const entry &e : mQ)
+    if (e.st != IDLE)
+      n += e.received;
+  return n;
+}
+
+uint64_t iec104_gischeduler::expected() const {
+  uint64_t n = 0;
+  for (const entry &e : mQ)
+    if (e.st != IDLE && !e.refused) {
+      if (e.expected == 0)
+        return 0;
+      n += e.expected;
+    }
+  return n;
+}
+
+std::string iec104_gischeduler::text() const {
+  char buf[120];
+  int pos = snprintf(buf, sizeof(buf), "%u/%u %s, %llu", mDone, mTotal,
+                     mQ[0].st != IDLE ? "station" : "groups",
+                     static_cast<unsigned long long>(received()));
+  if (expected() != 0)
+    pos += snprintf(buf + pos, sizeof(buf) - size_t(pos), "/%llu",
+                    static_cast<unsigned long long>(expected()));
+  snprintf(buf + pos, sizeof(buf) - size_t(pos), " objects, %llu retries",
+           static_cast<unsigned long long>(mRetries));
+  return buf;
+}
+
+uint32_t iec104_gischeduler::parseGroups(const std::string &s) {
+  uint32_t groups = 0;
+  const char *p = s.c_str();
+  while (*p) {
+    char *end;
+    long a = strtol(p, &end, 10), b = a;
+    if (end == p)
+      return 0;
+    p = end;
+    if (*p == '-') {
+      b = strtol(p + 1, &end, 10);
+      if (end == p + 1)
+        return 0;
+      p = end;
+    }
+    if (a < 1 || b > 16 || a > b)
+      return 0;
+    for (long g = a; g <= b; g++)
+      groups |= 1u << g;
+    while (*p == ' ')
+      p++;
+    if (*p == ',')
+      p++;
+    else if (*p)
+      return 0;
+  }
+  return groups;
+}
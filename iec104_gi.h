@@ -0,0 +1,95 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_GI_H
+#define IEC104_GI_H
+
+// GENERAL INTERROGATION SCHEDULER
+// A round of interrogations: the station one (QOI 20) or a station GI split
+// in group interrogations (QOI 21..36), up to `parallel` of them in progress
+// at once (sent in the k window). The objects received per interrogation are
+// compared with the count of its last complete round: the ones short of
+// objects, or without ACTTERM in the retry time, are interrogated again, not
+// the whole round. Negative confirmations are not repeated.
+
+#include <stdint.h>
+#include <string>
+
+class iec104_gischeduler {
+public:
+  static const unsigned MAX_RETRIES = 2; // of an interrogation in a round
+
+  iec104_gischeduler() { clear(); }
+  // groups: bit g for group g (1..16), 0: station interrogation (QOI 20)
+  void configure(uint32_t groups, unsigned parallel);
+  uint32_t groups() const { return mGroups; }
+  // a round of the configured interrogation (groups 0), or of these groups
+  void start(uint32_t groups = 0);
+  // QOI of the next interrogation to send now, -1: none
+  int next();
+  void actCon(int qoi, bool negative);
+  void actTerm(int qoi);
+  void objects(int cause, unsigned n); // monitor objects of cause 20..36
+  // retry time without progress: the interrogations without ACTTERM are sent
+  // again, returns the number of them
+  unsigned timeout();
+  bool active() const { return mTotal > 0 && mDone < mTotal; }
+  void clear(); // disconnection, the learned counts are kept
+
+  // progress of the round
+  unsigned total() const { return mTotal; } // interrogations
+  unsigned done() const { return mDone; }
+  uint64_t received() const;
+  uint64_t expected() const; // 0: not known (first round)
+  uint64_t retries() const { return mRetries; } // since the start
+  // "3/16 groups, 1200/5000 objects, 1 retries"
+  std::string text() const;
+  // "1-4,7" "" -> bits of the groups (bit g), 0: none or invalid
+  static uint32_t parseGroups(const std::string &s);
+
+private:
+  enum state : uint8_t { IDLE, PENDING, SENT, ACTIVE, DONE };
+  struct entry {
+    state st;
+    uint8_t tries;
+    bool refused;      // negative ACTCON in this round
+    uint32_t received; // objects of the current try
+    uint32_t expected; // objects of the last complete try, 0: not known
+  };
+  entry mQ[17] = {}; // by QOI - 20, value initialized: expected not known
+  uint32_t mGroups = 0;
+  unsigned mParallel = 1;
+  unsigned mTotal, mDone;
+  uint64_t mRetries = 0;
+  static int index(int qoi) { return qoi >= 20 && qoi <= 36 ? qoi - 20 : -1; }
+  unsigned inProgress() const;
+};
+
+#endif // IEC104_GI_H
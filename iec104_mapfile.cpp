@@ -0,0 +1,125 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_mapfile.h"
+#include <stdio.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+iec104_mapfile::iec104_mapfile() {
+  mBase = nullptr;
+  mSize = 0;
+  mOpenedSize = 0;
+#ifdef _WIN32
+  mFile = INVALID_HANDLE_VALUE;
+  mMapping = nullptr;
+#else
+  mFd = -1;
+#endif
+}
+
+iec104_mapfile::~iec104_mapfile() { close(); }
+
+bool iec104_mapfile::open(const std::string &path, uint64_t size, bool truncate) {
+  close();
+
+#ifdef _WIN32
+  HANDLE f = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                         truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (f == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER fsz;
+  mOpenedSize = GetFileSizeEx(f, &fsz) ? uint64_t(fsz.QuadPart) : 0;
+  // the mapping extends the file to its size, a larger file is mapped in part
+  HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READWRITE, DWORD(size >> 32),
+                                DWORD(size & 0xFFFFFFFF), nullptr);
+  void *p = m ? MapViewOfFile(m, FILE_MAP_WRITE, 0, 0, size_t(size)) : nullptr;
+  if (p == nullptr) {
+    if (m)
+      CloseHandle(m);
+    CloseHandle(f);
+    return false;
+  }
+  mFile = f;
+  mMapping = m;
+#else
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  mOpenedSize = fstat(fd, &st) == 0 ? uint64_t(st.st_size) : 0;
+  void *p = MAP_FAILED;
+  if (ftruncate(fd, off_t(size)) == 0)
+    p = mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (p == MAP_FAILED) {
+    ::close(fd);
+    return false;
+  }
+  mFd = fd;
+#endif
+
+  mBase = static_cast<char *>(p);
+  mSize = size;
+  return true;
+}
+
+void iec104_mapfile::close(uint64_t keepsize) {
+  if (mBase == nullptr)
+    return;
+  if (keepsize == 0 || keepsize > mSize)
+    keepsize = mSize;
+#ifdef _WIN32
+  FlushViewOfFile(mBase, 0);
+  UnmapViewOfFile(mBase);
+  CloseHandle(mMapping);
+  LARGE_INTEGER li;
+  li.QuadPart = LONGLONG(keepsize);
+  SetFilePointerEx(mFile, li, nullptr, FILE_BEGIN);
+  SetEndOfFile(mFile);
+  CloseHandle(mFile);
+  mFile = INVALID_HANDLE_VALUE;
+  mMapping = nullptr;
+#else
+  munmap(mBase, size_t(mSize));
+  if (keepsize != mSize && ftruncate(mFd, off_t(keepsize)) != 0)
+    perror("mapfile");
+  ::close(mFd);
+  mFd = -1;
+#endif
+  mBase = nullptr;
+  mSize = 0;
+}
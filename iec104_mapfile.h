@@ -0,0 +1,65 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_MAPFILE_H
+#define IEC104_MAPFILE_H
+
+// FILE MAPPED IN MEMORY, READ/WRITE, PREALLOCATED TO ITS SIZE
+
+#include <stdint.h>
+#include <string>
+
+class iec104_mapfile {
+public:
+  iec104_mapfile();
+  ~iec104_mapfile();
+  // size bytes mapped, truncate: start empty (zeroed), else the contents are kept
+  // (and zeroed beyond the former end)
+  bool open(const std::string &path, uint64_t size, bool truncate);
+  // unmap, keepsize: file size (less than the mapped size), 0: all
+  void close(uint64_t keepsize = 0);
+  bool isOpen() const { return mBase != nullptr; }
+  char *data() const { return mBase; }
+  uint64_t size() const { return mSize; }
+  uint64_t openedSize() const { return mOpenedSize; } // file size before open
+
+private:
+  char *mBase;
+  uint64_t mSize;
+  uint64_t mOpenedSize;
+#ifdef _WIN32
+  void *mFile;
+  void *mMapping;
+#else
+  int mFd;
+#endif
+};
+
+#endif // IEC104_MAPFILE_H
@@ -0,0 +1,163 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_pointcache.h"
+#include <string.h>
+
+bool iec104_pointcache::open(const std::string &path, unsigned capacity) {
+  close();
+  // capacity points in a table at most 3/4 full
+  uint32_t cap = 64;
+  while (cap < uint64_t(capacity) * 4 / 3 && cap < 0x80000000u)
+    cap <<= 1;
+  uint64_t size = sizeof(pointcache_header) + uint64_t(cap) * sizeof(pointcache_rec);
+  if (!mFile.open(path, size, false))
+    return false;
+  mHdr = reinterpret_cast<pointcache_header *>(mFile.data());
+  mRecs = reinterpret_cast<pointcache_rec *>(mFile.data() + sizeof(pointcache_header));
+  bool valid = mFile.openedSize() == size && memcmp(mHdr->magic, "I104PNT1", 8) == 0 &&
+               mHdr->version == 1 && mHdr->hdrsize == sizeof(pointcache_header) &&
+               mHdr->recsize == sizeof(pointcache_rec) && mHdr->capacity == cap;
+  if (!valid) {
+    memset(mHdr, 0, sizeof(*mHdr));
+    memcpy(mHdr->magic, "I104PNT1", 8);
+    mHdr->version = 1;
+    mHdr->hdrsize = sizeof(pointcache_header);
+    mHdr->recsize = sizeof(pointcache_rec);
+    mHdr->capacity = cap;
+    clear();
+  }
+  return true;
+}
+
+void iec104_pointcache::clear() {
+  memset(mRecs, 0, size_t(mHdr->capacity) * sizeof(pointcache_rec));
+  mHdr->count = 0;
+}
+
+pointcache_rec *iec104_pointcache::find(uint16_t ca, uint32_t address, bool insert) {
+  uint32_t mask = mHdr->capacity - 1;
+  uint64_t key = (uint64_t(ca) << 24) | (address & 0xFFFFFF);
+  uint32_t h = uint32_t((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+  for (;; h = (h + 1) & mask) {
+    pointcache_rec *r = &mRecs[h];
+    if (!r->used) {
+      // kept at most 3/4 full, the probe always ends
+      if (!insert || mHdr->count >= mHdr->capacity / 4 * 3)
+        return nullptr;
+      r->used = 1;
+      r->group = 0;
+      mHdr->count++;
+      return r;
+    }
+    if (r->obj.ca == ca && r->obj.address == address)
+      return r;
+  }
+}
+
+void iec104_pointcache::update(const iec_points &points, int64_t now_ms) {
+  if (points.size == 0)
+    return;
+  // COT 21..36: interrogated by group 1..16 (one cause per asdu)
+  uint8_t group = groupOf(points.objs[0].cause);
+  for (unsigned i = 0; i < points.size; i++) {
+    pointcache_rec *r = find(points.ca[i], points.address[i], true);
+    if (r == nullptr) {
+      mDropped++;
+      continue;
+    }
+    r->obj = points.objs[i];
+    r->updated_ms = now_ms;
+    if (group != 0)
+      r->group = group;
+  }
+}
+
+void iec104_pointcache::points(std::vector<iec_obj> &objs) const {
+  if (mHdr == nullptr)
+    return;
+  objs.reserve(objs.size() + mHdr->count);
+  for (uint32_t i = 0; i < mHdr->capacity; i++)
+    if (mRecs[i].used)
+      objs.push_back(mRecs[i].obj);
+}
+
+void iec104_pointcache::put(const pointcache_rec &rec) {
+  if (mHdr == nullptr)
+    return;
+  pointcache_rec *r = find(rec.obj.ca, rec.obj.address, true);
+  if (r == nullptr) {
+    mDropped++;
+    return;
+  }
+  // a new record has updated_ms 0
+  if (rec.updated_ms < r->updated_ms)
+    return;
+  r->obj = rec.obj;
+  r->updated_ms = rec.updated_ms;
+  if (rec.group != 0)
+    r->group = rec.group;
+}
+
+void iec104_pointcache::records(std::vector<pointcache_rec> &recs) const {
+  if (mHdr == nullptr)
+    return;
+  recs.reserve(recs.size() + mHdr->count);
+  for (uint32_t i = 0; i < mHdr->capacity; i++)
+    if (mRecs[i].used)
+      recs.push_back(mRecs[i]);
+}
+
+int64_t iec104_pointcache::newest() const {
+  int64_t ms = 0;
+  if (mHdr == nullptr)
+    return 0;
+  for (uint32_t i = 0; i < mHdr->capacity; i++)
+    if (mRecs[i].used && mRecs[i].updated_ms > ms)
+      ms = mRecs[i].updated_ms;
+  return ms;
+}
+
+uint32_t iec104_pointcache::staleGroups(int64_t now_ms, int64_t maxage_ms, bool &unknown) const {
+  uint32_t groups = 0;
+  unknown = false;
+  if (mHdr == nullptr)
+    return 0;
+  for (uint32_t i = 0; i < mHdr->capacity; i++) {
+    const pointcache_rec &r = mRecs[i];
+    if (!r.used || now_ms - r.updated_ms <= maxage_ms)
+      continue;
+    if (r.group == 0)
+      unknown = true;
+    else
+      groups |= 1u << r.group;
+  }
+  return groups;
+}
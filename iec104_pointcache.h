@@ -0,0 +1,96 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_POINTCACHE_H
+#define IEC104_POINTCACHE_H
+
+// LAST VALUE OF THE POINTS, KEYED BY (CA, IOA), IN A MAPPED FILE
+// Hash table of fixed records (open addressing), updated from the decoder and
+// kept across restarts: the point table and I104M get the last state at once,
+// and only the groups not refreshed lately need an interrogation.
+
+#include <vector>
+#include "iec104_class.h"
+#include "iec104_mapfile.h"
+
+#pragma pack(push)
+#pragma pack(1)
+
+struct pointcache_header {
+  char magic[8];     // "I104PNT1"
+  uint32_t version;  // 1
+  uint32_t hdrsize;  // bytes of this header, records follow
+  uint32_t recsize;  // bytes of the record (layout check)
+  uint32_t capacity; // records, power of 2
+  uint32_t count;    // records used
+  uint32_t res;
+};
+
+struct pointcache_rec {
+  uint8_t used;
+  uint8_t group;      // interrogation group 1..16, 0: not known (station GI or spontaneous)
+  int64_t updated_ms; // wall clock of the last update, ms since epoch
+  iec_obj obj;
+};
+
+#pragma pack(pop)
+
+class iec104_pointcache {
+public:
+  // capacity: points (table of a power of 2, up to 3/4 full), a file of other capacity
+  // or layout is started empty
+  bool open(const std::string &path, unsigned capacity);
+  void close() { mFile.close(); mHdr = nullptr; mRecs = nullptr; }
+  bool isOpen() const { return mHdr != nullptr; }
+  unsigned count() const { return mHdr ? mHdr->count : 0; }
+  uint64_t dropped() const { return mDropped; } // points not cached, table full
+  void update(const iec_points &points, int64_t now_ms); // the points of an asdu
+  void points(std::vector<iec_obj> &objs) const; // all the cached points
+  // records of another cache (hot standby replication): a record older than
+  // the cached one is ignored, group 0 keeps the known group
+  void put(const pointcache_rec &rec);
+  void records(std::vector<pointcache_rec> &recs) const; // all the used records
+  // interrogation group of a cause of transmission, 0: not known
+  static uint8_t groupOf(uint8_t cause) { return cause >= 21 && cause <= 36 ? uint8_t(cause - 20) : 0; }
+  // groups (bit g for group g) with points not updated since before
+  // now_ms - maxage_ms, unknown: points of no known group are as old
+  uint32_t staleGroups(int64_t now_ms, int64_t maxage_ms, bool &unknown) const;
+  int64_t newest() const; // ms since epoch of the last update of any point, 0: empty
+  void clear();
+
+private:
+  iec104_mapfile mFile;
+  pointcache_header *mHdr = nullptr;
+  pointcache_rec *mRecs = nullptr;
+  uint64_t mDropped = 0;
+  pointcache_rec *find(uint16_t ca, uint32_t address, bool insert);
+};
+
+#endif // IEC104_POINTCACHE_H
@@ -0,0 +1,381 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_soe.h"
+#include <string.h>
+#include <algorithm>
+#include <filesystem>
+
+namespace {
+
+// civil date of days since epoch (proleptic gregorian), thread safe
+void civilDate(int64_t days, int &y, unsigned &m, unsigned &d) {
+  days += 719468;
+  int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  unsigned doe = unsigned(days - era * 146097);
+  unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  unsigned mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = int(int64_t(yoe) + era * 400 + (m <= 2));
+}
+
+// sorted by time tag, the first max_events kept, returns true if some dropped
+bool trimEvents(std::vector<soe_event> &out, size_t max_events) {
+  std::stable_sort(out.begin(), out.end(), [](const soe_event &a, const soe_event &b) {
+    return a.time_ms < b.time_ms;
+  });
+  if (out.size() <= max_events)
+    return false;
+  out.resize(max_events);
+  return true;
+}
+
+inline uint64_t soeKey(unsigned ca, uint32_t address) {
+  return (uint64_t(ca) << 24) | (address & 0xFFFFFF);
+}
+
+} // namespace
+
+std::string iec104_soe_reader::fileName(int64_t hour) {
+  int y;
+  unsigned m, d;
+  int64_t days = hour >= 0 ? hour / 24 : (hour - 23) / 24;
+  civilDate(days, y, m, d);
+  char buf[40];
+  snprintf(buf, sizeof(buf), "soe_%04d%02u%02u_%02u.dat", y, m, d, unsigned(hour - days * 24));
+  return buf;
+}
+
+bool iec104_soe_writer::open(const std::string &dir) {
+  close();
+  std::error_code ec;
+  std::filesystem::create_directories(dir, ec);
+  if (!std::filesystem::is_directory(dir, ec))
+    return false;
+  mDir = dir;
+  mTime.reserve(soe_block_rows);
+  mArrival.reserve(soe_block_rows);
+  mValue.reserve(soe_block_rows);
+  mAddress.reserve(soe_block_rows);
+  mCa.reserve(soe_block_rows);
+  mFlags.reserve(soe_block_rows);
+  mType.reserve(soe_block_rows);
+  mTimetag.reserve(soe_block_rows);
+  return true;
+}
+
+void iec104_soe_writer::close() {
+  flush();
+  if (mFile != nullptr)
+    fclose(mFile);
+  mFile = nullptr;
+  mFileHour = -1;
+  mDir.clear();
+}
+
+// the file of the hour, appended when it exists (restart in the same hour)
+bool iec104_soe_writer::openHour(int64_t hour) {
+  if (mFile != nullptr)
+    fclose(mFile);
+  mFileHour = hour;
+  std::string path = mDir + "/" + iec104_soe_reader::fileName(hour);
+  mFile = fopen(path.c_str(), "r+b");
+  if (mFile != nullptr) {
+    if (fread(&mHdr, sizeof(mHdr), 1, mFile) == 1 && memcmp(mHdr.magic, "I104SOE1", 8) == 0 &&
+        mHdr.version == 1 && resumeFile(path))
+      return true;
+    if (mFile != nullptr)
+      fclose(mFile);
+  }
+  mFile = fopen(path.c_str(), "w+b");
+  if (mFile == nullptr)
+    return false;
+  memset(&mHdr, 0, sizeof(mHdr));
+  memcpy(mHdr.magic, "I104SOE1", 8);
+  mHdr.version = 1;
+  mHdr.hdrsize = sizeof(mHdr);
+  mHdr.min_ms = INT64_MAX;
+  mHdr.max_ms = INT64_MIN;
+  return fwrite(&mHdr, sizeof(mHdr), 1, mFile) == 1;
+}
+
+// appended after the blocks the header counts: a block partly written when the
+// process stopped (not yet counted) is cut off, the reader walks the blocks in
+// sequence
+bool iec104_soe_writer::resumeFile(const std::string &path) {
+  if (fseek(mFile, 0, SEEK_END) != 0)
+    return false;
+  uint64_t size = uint64_t(ftell(mFile));
+  if (fseek(mFile, long(mHdr.hdrsize), SEEK_SET) != 0)
+    return false;
+  uint64_t end = mHdr.hdrsize;
+  soe_file_header hdr = mHdr;
+  hdr.blocks = 0;
+  hdr.events = 0;
+  hdr.min_ms = INT64_MAX;
+  hdr.max_ms = INT64_MIN;
+  soe_block_header bh;
+  while (hdr.blocks < mHdr.blocks && fread(&bh, sizeof(bh), 1, mFile) == 1 &&
+         soeBlockValid(bh) && end + bh.bytes <= size &&
+         fseek(mFile, long(bh.bytes - sizeof(bh)), SEEK_CUR) == 0) {
+    hdr.blocks++;
+    hdr.events += bh.rows;
+    hdr.min_ms = std::min(hdr.min_ms, bh.min_ms);
+    hdr.max_ms = std::max(hdr.max_ms, bh.max_ms);
+    end += bh.bytes;
+  }
+  if (size != end || hdr.blocks != mHdr.blocks) {
+    fclose(mFile);
+    mFile = nullptr;
+    std::error_code ec;
+    std::filesystem::resize_file(path, end, ec);
+    if (ec || (mFile = fopen(path.c_str(), "r+b")) == nullptr)
+      return false;
+    mHdr = hdr;
+    if (fwrite(&mHdr, sizeof(mHdr), 1, mFile) != 1)
+      return false;
+  }
+  return fseek(mFile, 0, SEEK_END) == 0;
+}
+
+void iec104_soe_writer::append(const iec_points &points) {
+  if (mDir.empty() || points.size == 0)
+    return;
+  int64_t hour = points.arrival_us[0] / 3600000000LL;
+  if (hour != mFileHour && !mTime.empty())
+    flush(); // a block is in the file of its arrival hour
+  for (unsigned i = 0; i < points.size; i++) {
+    uint16_t flags = points.quality[i];
+    if (points.objs[i].timetag.su)
+      flags |= SOE_SU;
+    int64_t ms = points.time_us[i] / 1000;
+    if (points.time_us[i] < 0) {
+      ms = points.arrival_us[i] / 1000;
+      flags |= SOE_TIME_IV;
+    }
+    mTime.push_back(ms);
+    mArrival.push_back(points.arrival_us[i]);
+    mValue.push_back(points.value[i]);
+    mAddress.push_back(points.address[i]);
+    mCa.push_back(points.ca[i]);
+    mFlags.push_back(flags);
+    mType.push_back(points.type[i]);
+    mTimetag.push_back(points.objs[i].timetag);
+    mEvents++;
+    if (mTime.size() >= soe_block_rows)
+      flush();
+  }
+}
+
+template <class T> static bool writeColumn(FILE *f, const std::vector<T> &col) {
+  return fwrite(col.data(), sizeof(T), col.size(), f) == col.size();
+}
+
+void iec104_soe_writer::flush() {
+  if (mTime.empty())
+    return;
+  int64_t hour = mArrival[0] / 3600000000LL;
+  if ((hour != mFileHour || mFile == nullptr) && !openHour(hour)) {
+    // no file: the events are lost, not kept growing
+    clearBlock();
+    return;
+  }
+
+  std::vector<uint64_t> keys(mTime.size());
+  for (size_t i = 0; i < mTime.size(); i++)
+    keys[i] = soeKey(mCa[i], mAddress[i]);
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  soe_block_header bh;
+  memset(&bh, 0, sizeof(bh));
+  bh.rows = uint32_t(mTime.size());
+  bh.keys = uint32_t(keys.size());
+  bh.bytes = uint32_t(sizeof(bh) + keys.size() * sizeof(uint64_t) + mTime.size() * soe_row_bytes);
+  bh.min_ms = *std::min_element(mTime.begin(), mTime.end());
+  bh.max_ms = *std::max_element(mTime.begin(), mTime.end());
+
+  bool ok = fwrite(&bh, sizeof(bh), 1, mFile) == 1 && writeColumn(mFile, keys) &&
+            writeColumn(mFile, mTime) && writeColumn(mFile, mArrival) &&
+            writeColumn(mFile, mValue) && writeColumn(mFile, mAddress) &&
+            writeColumn(mFile, mCa) && writeColumn(mFile, mFlags) &&
+            writeColumn(mFile, mType) && writeColumn(mFile, mTimetag);
+  if (ok) {
+    // the block is in the file before the header counts it
+    fflush(mFile);
+    mHdr.blocks++;
+    mHdr.events += bh.rows;
+    mHdr.min_ms = std::min(mHdr.min_ms, bh.min_ms);
+    mHdr.max_ms = std::max(mHdr.max_ms, bh.max_ms);
+    fseek(mFile, 0, SEEK_SET);
+    fwrite(&mHdr, sizeof(mHdr), 1, mFile);
+    fseek(mFile, 0, SEEK_END);
+    fflush(mFile);
+  }
+
+  clearBlock();
+}
+
+void iec104_soe_writer::clearBlock() {
+  mTime.clear();
+  mArrival.clear();
+  mValue.clear();
+  mAddress.clear();
+  mCa.clear();
+  mFlags.clear();
+  mType.clear();
+  mTimetag.clear();
+}
+
+void iec104_soe_reader::query(int64_t from_ms, int64_t to_ms, int ca, int64_t address,
+                              std::vector<soe_event> &out, size_t max_events) const {
+  if (from_ms > to_ms || max_events == 0)
+    return;
+  // files are of the arrival hour, events are searched by time tag
+  int64_t first = std::max(from_ms, INT64_MIN / 2) - soe_query_margin_ms;
+  int64_t last = std::min(to_ms, INT64_MAX / 2) + soe_query_margin_ms;
+  first = (first >= 0 ? first : first - 3599999) / 3600000;
+  last = (last >= 0 ? last : last - 3599999) / 3600000;
+  std::vector<std::string> files;
+  if (last - first <= soe_query_scan_hours) {
+    for (int64_t h = first; h <= last; h++)
+      files.push_back(mDir + "/" + fileName(h)); // not there: queryFile skips it
+  } else {
+    // the names sort by hour, of the years 1970..9999
+    std::string firstName = fileName(std::max<int64_t>(first, 0));
+    std::string lastName = fileName(std::min<int64_t>(last, 70389527));
+    std::error_code ec;
+    for (const auto &e : std::filesystem::directory_iterator(mDir, ec)) {
+      std::string name = e.path().filename().string();
+      if (name.size() == 19 && name.compare(0, 4, "soe_") == 0 &&
+          name.compare(name.size() - 4, 4, ".dat") == 0 && name >= firstName &&
+          name <= lastName)
+        files.push_back(e.path().string());
+    }
+    std::sort(files.begin(), files.end());
+  }
+  // an event of a later (arrival hour) file may have an earlier time tag: all
+  // the files are read, the window shrinks as the first events are known
+  int64_t to = to_ms;
+  for (const std::string &f : files)
+    queryFile(f, from_ms, to, ca, address, out, max_events);
+  trimEvents(out, max_events);
+}
+
+void iec104_soe_reader::queryFile(const std::string &path, int64_t from_ms, int64_t &to_ms,
+                                  int ca, int64_t address, std::vector<soe_event> &out,
+                                  size_t max_events) const {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (f == nullptr)
+    return;
+  soe_file_header fh;
+  if (fread(&fh, sizeof(fh), 1, f) != 1 || memcmp(fh.magic, "I104SOE1", 8) != 0 ||
+      fh.max_ms < from_ms || fh.min_ms > to_ms || fseek(f, long(fh.hdrsize), SEEK_SET) != 0) {
+    fclose(f);
+    return;
+  }
+
+  bool onePoint = ca >= 0 && address >= 0;
+  uint64_t key = onePoint ? soeKey(unsigned(ca), uint32_t(address)) : 0;
+  std::vector<char> buf;
+  soe_block_header bh;
+  for (uint32_t b = 0; b < fh.blocks; b++) {
+    if (out.size() >= 2 * max_events && trimEvents(out, max_events))
+      to_ms = out.back().time_ms;
+    // a bad block header: the rest of the file can't be walked
+    if (fread(&bh, sizeof(bh), 1, f) != 1 || !soeBlockValid(bh))
+      break;
+    size_t rest = bh.bytes - sizeof(bh);
+    if (bh.max_ms < from_ms || bh.min_ms > to_ms) {
+      // time index: not in the window
+      if (fseek(f, long(rest), SEEK_CUR) != 0)
+        break;
+      continue;
+    }
+    if (onePoint) {
+      // point index: the sorted keys of the block
+      std::vector<uint64_t> keys(bh.keys);
+      if (fread(keys.data(), sizeof(uint64_t), keys.size(), f) != keys.size())
+        break;
+      rest -= keys.size() * sizeof(uint64_t);
+      if (!std::binary_search(keys.begin(), keys.end(), key)) {
+        if (fseek(f, long(rest), SEEK_CUR) != 0)
+          break;
+        continue;
+      }
+    } else if (fseek(f, long(bh.keys * sizeof(uint64_t)), SEEK_CUR) != 0) {
+      break;
+    } else {
+      rest -= bh.keys * sizeof(uint64_t);
+    }
+    buf.resize(rest);
+    if (fread(buf.data(), 1, rest, f) != rest)
+      break;
+
+    // columns, in decreasing alignment from the (aligned) buffer start
+    size_t n = bh.rows;
+    const char *p = buf.data();
+    const int64_t *time = reinterpret_cast<const int64_t *>(p);
+    p += n * sizeof(int64_t);
+    const int64_t *arrival = reinterpret_cast<const int64_t *>(p);
+    p += n * sizeof(int64_t);
+    const double *value = reinterpret_cast<const double *>(p);
+    p += n * sizeof(double);
+    const uint32_t *addr = reinterpret_cast<const uint32_t *>(p);
+    p += n * sizeof(uint32_t);
+    const uint16_t *cas = reinterpret_cast<const uint16_t *>(p);
+    p += n * sizeof(uint16_t);
+    const uint16_t *flags = reinterpret_cast<const uint16_t *>(p);
+    p += n * sizeof(uint16_t);
+    const uint8_t *type = reinterpret_cast<const uint8_t *>(p);
+    p += n * sizeof(uint8_t);
+    const cp56time2a *timetag = reinterpret_cast<const cp56time2a *>(p);
+
+    for (size_t i = 0; i < n; i++) {
+      if (time[i] < from_ms || time[i] > to_ms)
+        continue;
+      if (onePoint && (addr[i] != uint32_t(address) || cas[i] != unsigned(ca)))
+        continue;
+      soe_event e;
+      e.time_ms = time[i];
+      e.arrival_us = arrival[i];
+      e.address = addr[i];
+      e.ca = cas[i];
+      e.type = type[i];
+      e.flags = flags[i];
+      e.value = value[i];
+      e.timetag = timetag[i];
+      out.push_back(e);
+    }
+  }
+  fclose(f);
+}
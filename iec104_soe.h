@@ -0,0 +1,165 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_SOE_H
+#define IEC104_SOE_H
+
+// SEQUENCE OF EVENTS (SOE) HISTORY IN COLUMNAR FILES
+// The time tagged points are appended to one file per hour (of arrival, UTC)
+// in a directory: soe_YYYYMMDD_HH.dat. A file is a header and blocks of up to
+// soe_block_rows events. Each block has its time range (time index) and the
+// sorted keys (CA, IOA) of its events (point index), then one column per
+// field, so a query reads only the blocks of its time window and point.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "iec104_class.h"
+
+enum soe_flags : uint16_t {
+  // the low byte is the iec_quality of the point
+  SOE_IV = QUALITY_IV, // invalid
+  SOE_NT = QUALITY_NT, // not topical
+  SOE_SB = QUALITY_SB, // substituted
+  SOE_BL = QUALITY_BL, // blocked
+  SOE_OV = QUALITY_OV, // overflow
+  SOE_T = QUALITY_T,   // transient
+  SOE_CY = QUALITY_CY, // counter carry
+  SOE_EI = QUALITY_EI, // elapsed time invalid (protection events)
+  SOE_TIME_IV = 0x100, // time tag invalid, time_ms is the arrival time
+  SOE_SU = 0x200,      // summer time
+};
+
+// one event of a query
+struct soe_event {
+  int64_t time_ms;    // time tag, ms since epoch (arrival when not valid)
+  int64_t arrival_us; // arrival, us since epoch
+  uint32_t address;
+  uint16_t ca;
+  uint8_t type;
+  uint16_t flags; // soe_flags
+  double value;
+  cp56time2a timetag; // as received
+};
+
+#pragma pack(push)
+#pragma pack(1)
+
+struct soe_file_header {
+  char magic[8];       // "I104SOE1"
+  uint32_t version;    // 1
+  uint32_t hdrsize;    // bytes of this header, blocks follow
+  uint32_t blocks;
+  uint32_t res;
+  uint64_t events;
+  int64_t min_ms;      // time range of the events of the file
+  int64_t max_ms;
+};
+
+// followed by the columns: uint64 key[keys] (ca << 24 | ioa, sorted),
+// int64 time_ms[rows], int64 arrival_us[rows], double value[rows],
+// uint32 address[rows], uint16 ca[rows], uint16 flags[rows], uint8 type[rows],
+// cp56time2a timetag[rows]
+struct soe_block_header {
+  uint32_t rows;
+  uint32_t keys;
+  uint32_t bytes; // of the block, with this header
+  uint32_t res;
+  int64_t min_ms;
+  int64_t max_ms;
+};
+
+#pragma pack(pop)
+
+static const unsigned soe_block_rows = 4096;
+// bytes of the columns of one row (without the keys)
+static const unsigned soe_row_bytes = sizeof(int64_t) * 2 + sizeof(double) + sizeof(uint32_t) +
+                                      sizeof(uint16_t) * 2 + sizeof(uint8_t) + sizeof(cp56time2a);
+// the sizes of a block header agree (a file not truncated, nor foreign)
+inline bool soeBlockValid(const soe_block_header &bh) {
+  return bh.rows <= soe_block_rows && bh.keys <= bh.rows &&
+         bh.bytes == sizeof(bh) + uint64_t(bh.keys) * sizeof(uint64_t) +
+                         uint64_t(bh.rows) * soe_row_bytes;
+}
+// a query opens the files of arrival hours from its time window less/plus this
+// margin (events arrived late, buffered by the RTU, or of a skewed RTU clock)
+static const int64_t soe_query_margin_ms = 2 * 3600000LL;
+// longer windows (hours) list the directory instead of trying each hour
+static const int64_t soe_query_scan_hours = 24 * 31;
+
+class iec104_soe_writer {
+public:
+  ~iec104_soe_writer() { close(); }
+  bool open(const std::string &dir);
+  void close();
+  bool isOpen() const { return !mDir.empty(); }
+  // the time tagged points of an asdu
+  void append(const iec_points &points);
+  void flush(); // write the pending events as a block
+  uint64_t events() const { return mEvents; }
+
+private:
+  std::string mDir;
+  FILE *mFile = nullptr;
+  int64_t mFileHour = -1; // hour of arrival of the open file
+  soe_file_header mHdr;
+  uint64_t mEvents = 0;
+  // columns of the block being filled
+  std::vector<int64_t> mTime;
+  std::vector<int64_t> mArrival;
+  std::vector<double> mValue;
+  std::vector<uint32_t> mAddress;
+  std::vector<uint16_t> mCa;
+  std::vector<uint16_t> mFlags;
+  std::vector<uint8_t> mType;
+  std::vector<cp56time2a> mTimetag;
+  bool openHour(int64_t hour);
+  bool resumeFile(const std::string &path); // mFile after its last complete block
+  void clearBlock();
+};
+
+class iec104_soe_reader {
+public:
+  explicit iec104_soe_reader(const std::string &dir) : mDir(dir) {}
+  // events of time tag in [from_ms, to_ms], of one point when ca/address are
+  // not negative, sorted by time tag, the max_events first by time tag
+  void query(int64_t from_ms, int64_t to_ms, int ca, int64_t address,
+             std::vector<soe_event> &out, size_t max_events = 1000000) const;
+  static std::string fileName(int64_t hour); // file of an hour since epoch
+
+private:
+  std::string mDir;
+  // to_ms is lowered to the last event kept when out is trimmed to max_events
+  void queryFile(const std::string &path, int64_t from_ms, int64_t &to_ms, int ca,
+                 int64_t address, std::vector<soe_event> &out, size_t max_events) const;
+};
+
+#endif // IEC104_SOE_H
@@ -0,0 +1,179 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_stats.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+void iec104_histogram::clear() {
+  memset(mBuckets, 0, sizeof(mBuckets));
+  mCount = 0;
+  mSum = 0;
+  mMax = 0;
+}
+
+uint64_t iec104_histogram::upperBound(unsigned b) {
+  if (b < SUB)
+    return b;
+  unsigned shift = b / SUB - 1;
+  uint64_t lower = uint64_t(SUB + b % SUB) << shift;
+  return lower + (uint64_t(1) << shift) - 1;
+}
+
+uint64_t iec104_histogram::percentile(double p) const {
+  if (mCount == 0)
+    return 0;
+  uint64_t target = uint64_t(p / 100 * double(mCount) + 0.5);
+  if (target < 1)
+    target = 1;
+  uint64_t acc = 0;
+  for (unsigned b = 0; b < BUCKETS; b++) {
+    acc += mBuckets[b];
+    if (acc >= target) {
+      uint64_t ub = upperBound(b);
+      return ub < mMax ? ub : mMax;
+    }
+  }
+  return mMax;
+}
+
+std::string iec104_histogram::text() const {
+  char buf[200];
+  snprintf(buf, sizeof(buf), "n=%llu avg=%.1f p50=%llu p90=%llu p99=%llu max=%llu",
+           static_cast<unsigned long long>(mCount), mean(),
+           static_cast<unsigned long long>(percentile(50)),
+           static_cast<unsigned long long>(percentile(90)),
+           static_cast<unsigned long long>(percentile(99)),
+           static_cast<unsigned long long>(mMax));
+  return buf;
+}
+
+void iec104_stats::clear() {
+  iRx = iTx = sRx = sTx = uRx = uTx = 0;
+  memset(objects, 0, sizeof(objects));
+  seqErrors = 0;
+  brokenAPDUs = 0;
+  filtered = 0;
+  bytesRead = 0;
+  readBytes.clear();
+  decodeNs.clear();
+  indicationUs.clear();
+  fieldMs.clear();
+  giMs.clear();
+  giDone = giTotal = 0;
+  giObjects = giExpected = giRetries = 0;
+  cmdConUs.clear();
+  cmdTermUs.clear();
+  cmdSent = cmdNegative = cmdTimeouts = cmdUnmatched = 0;
+}
+
+std::string iec104_stats::text() const {
+  char buf[300];
+  std::string s;
+  snprintf(buf, sizeof(buf),
+           "I-frames rx %llu tx %llu\nS-frames rx %llu tx %llu\nU-frames rx %llu tx %llu\n"
+           "sequence errors %llu, broken apdus %llu\nbytes read %llu, objects filtered %llu\n",
+           static_cast<unsigned long long>(iRx), static_cast<unsigned long long>(iTx),
+           static_cast<unsigned long long>(sRx), static_cast<unsigned long long>(sTx),
+           static_cast<unsigned long long>(uRx), static_cast<unsigned long long>(uTx),
+           static_cast<unsigned long long>(seqErrors),
+           static_cast<unsigned long long>(brokenAPDUs),
+           static_cast<unsigned long long>(bytesRead),
+           static_cast<unsigned long long>(filtered));
+  s += buf;
+  s += "objects by TI:";
+  for (unsigned ti = 0; ti < 256; ti++)
+    if (objects[ti]) {
+      snprintf(buf, sizeof(buf), " %u=%llu", ti, static_cast<unsigned long long>(objects[ti]));
+      s += buf;
+    }
+  s += "\nbytes per read:        " + readBytes.text();
+  s += "\ndecode ns per asdu:    " + decodeNs.text();
+  s += "\nread to indication us: " + indicationUs.text();
+  s += "\nfield time tag ms:     " + fieldMs.text();
+  s += "\nGI ms:                 " + giMs.text();
+  snprintf(buf, sizeof(buf), "\nGI progress:           %u/%u, objects %llu/%llu, retries %llu\n",
+           giDone, giTotal, static_cast<unsigned long long>(giObjects),
+           static_cast<unsigned long long>(giExpected),
+           static_cast<unsigned long long>(giRetries));
+  s += buf;
+  s += "command to ACTCON us:  " + cmdConUs.text();
+  s += "\ncommand to ACTTERM us: " + cmdTermUs.text();
+  snprintf(buf, sizeof(buf), "\ncommands sent %llu, negative %llu, timeouts %llu, unmatched %llu\n",
+           static_cast<unsigned long long>(cmdSent), static_cast<unsigned long long>(cmdNegative),
+           static_cast<unsigned long long>(cmdTimeouts),
+           static_cast<unsigned long long>(cmdUnmatched));
+  s += buf;
+  return s;
+}
+
+std::string iec104_stats::line() const {
+  char buf[300];
+  std::string s;
+  snprintf(buf, sizeof(buf),
+           "i_rx=%llu i_tx=%llu s_rx=%llu s_tx=%llu u_rx=%llu u_tx=%llu "
+           "seq_err=%llu broken=%llu bytes=%llu filtered=%llu",
+           static_cast<unsigned long long>(iRx), static_cast<unsigned long long>(iTx),
+           static_cast<unsigned long long>(sRx), static_cast<unsigned long long>(sTx),
+           static_cast<unsigned long long>(uRx), static_cast<unsigned long long>(uTx),
+           static_cast<unsigned long long>(seqErrors),
+           static_cast<unsigned long long>(brokenAPDUs),
+           static_cast<unsigned long long>(bytesRead),
+           static_cast<unsigned long long>(filtered));
+  s += buf;
+  for (unsigned ti = 0; ti < 256; ti++)
+    if (objects[ti]) {
+      snprintf(buf, sizeof(buf), " ti%u=%llu", ti, static_cast<unsigned long long>(objects[ti]));
+      s += buf;
+    }
+  const iec104_histogram *h[] = {&readBytes, &decodeNs, &indicationUs, &fieldMs, &giMs,
+                                 &cmdConUs, &cmdTermUs};
+  const char *name[] = {"read_bytes", "decode_ns", "indication_us", "field_ms", "gi_ms",
+                        "cmd_con_us", "cmd_term_us"};
+  for (unsigned i = 0; i < 7; i++) {
+    snprintf(buf, sizeof(buf), " %s_p50=%llu %s_p99=%llu %s_max=%llu", name[i],
+             static_cast<unsigned long long>(h[i]->percentile(50)), name[i],
+             static_cast<unsigned long long>(h[i]->percentile(99)), name[i],
+             static_cast<unsigned long long>(h[i]->max()));
+    s += buf;
+  }
+  snprintf(buf, sizeof(buf), " gi_done=%u gi_total=%u gi_objects=%llu gi_expected=%llu gi_retries=%llu",
+           giDone, giTotal, static_cast<unsigned long long>(giObjects),
+           static_cast<unsigned long long>(giExpected),
+           static_cast<unsigned long long>(giRetries));
+  s += buf;
+  snprintf(buf, sizeof(buf), " cmd_sent=%llu cmd_negative=%llu cmd_timeouts=%llu cmd_unmatched=%llu",
+           static_cast<unsigned long long>(cmdSent), static_cast<unsigned long long>(cmdNegative),
+           static_cast<unsigned long long>(cmdTimeouts),
+           static_cast<unsigned long long>(cmdUnmatched));
+  s += buf;
+  return s;
+}
@@ -0,0 +1,121 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_STATS_H
+#define IEC104_STATS_H
+
+// IEC 60870-5-104 LINK STATISTICS: COUNTERS AND LATENCY HISTOGRAMS
+
+#include "iec104_types.h"
+#include <stdint.h>
+#include <string>
+
+// log-linear histogram (HDR style): values below 8 exact, then 8 buckets per
+// power of 2 (12.5% resolution), no allocation on add
+class iec104_histogram {
+public:
+  static const unsigned SUB = 8;
+  static const unsigned BUCKETS = 62 * SUB;
+
+  iec104_histogram() { clear(); }
+  void clear();
+  void add(uint64_t v) {
+    mBuckets[bucket(v)]++;
+    mCount++;
+    mSum += v;
+    if (v > mMax)
+      mMax = v;
+  }
+  uint64_t count() const { return mCount; }
+  uint64_t max() const { return mMax; }
+  double mean() const { return mCount ? double(mSum) / double(mCount) : 0; }
+  uint64_t percentile(double p) const; // upper bound of the bucket, p in 0..100
+  // "n=... avg=... p50=... p90=... p99=... max=..."
+  std::string text() const;
+
+private:
+  uint32_t mBuckets[BUCKETS];
+  uint64_t mCount;
+  uint64_t mSum;
+  uint64_t mMax;
+  static unsigned bucket(uint64_t v) {
+    if (v < SUB)
+      return unsigned(v);
+    unsigned shift = msb(v) - 3; // v >> shift in 8..15
+    return (shift + 1) * SUB + unsigned((v >> shift) & (SUB - 1));
+  }
+  static uint64_t upperBound(unsigned b);
+  static unsigned msb(uint64_t v) { // index of the highest bit set, v > 0
+    unsigned n = 0;
+    for (unsigned step = 32; step > 0; step >>= 1)
+      if (v >> step) {
+        v >>= step;
+        n += step;
+      }
+    return n;
+  }
+};
+
+// counters of one link, updated by the protocol thread (copy them to read from
+// other threads)
+struct iec104_stats {
+  uint64_t iRx, iTx; // I-frames
+  uint64_t sRx, sTx; // S-frames
+  uint64_t uRx, uTx; // U-frames
+  uint64_t objects[256]; // information objects received, by TI
+  uint64_t seqErrors;    // NS or NR out of sequence
+  uint64_t brokenAPDUs;  // invalid frames, asdus shorter than their objects
+  uint64_t filtered;     // objects not indicated, under the deadband
+  uint64_t bytesRead;
+  iec104_histogram readBytes;    // bytes per packetReadyTCP
+  iec104_histogram decodeNs;     // decode time of each monitor asdu, ns
+  iec104_histogram indicationUs; // tcp read to dataIndication, us
+  iec104_histogram fieldMs;      // field time tag to arrival, ms (time tagged TIs)
+  iec104_histogram giMs;         // general interrogation, ACTCON to ACTTERM, ms
+  // progress of the last general interrogation
+  unsigned giDone, giTotal; // interrogations (station or groups) terminated
+  uint64_t giObjects;       // objects received
+  uint64_t giExpected;      // objects of the last complete one, 0: not known
+  uint64_t giRetries;       // interrogations sent again, in total
+  // commands (with a command tracker)
+  iec104_histogram cmdConUs;  // command to its ACTCON, us
+  iec104_histogram cmdTermUs; // first command of the point (select) to ACTTERM, us
+  uint64_t cmdSent;
+  uint64_t cmdNegative;  // negative responses
+  uint64_t cmdTimeouts;  // no ACTCON in the timeout
+  uint64_t cmdUnmatched; // responses to no command in flight
+
+  iec104_stats() { clear(); }
+  void clear();
+  std::string text() const; // several lines, for a panel
+  std::string line() const; // one line of key=value, for export
+};
+
+#endif // IEC104_STATS_H
@@ -0,0 +1,213 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_time.h"
+#include <string.h>
+#include <time.h>
+#include <chrono>
+
+namespace {
+
+const int64_t us_hour = 3600000000LL;
+const int64_t us_day = 24 * us_hour;
+
+// one day of the local calendar
+struct day_cache {
+  unsigned key = 0;       // (year, month, mday) + 1, 0: empty
+  int64_t midnight = 0;   // us since epoch of the local 00:00
+  bool dstChange = false; // the day has a daylight saving change
+  uint8_t year, month, mday, wday, su;
+};
+
+bool localTm(time_t secs, struct tm &t) {
+#ifdef _WIN32
+  return localtime_s(&t, &secs) == 0;
+#else
+  return localtime_r(&secs, &t) != nullptr;
+#endif
+}
+
+// us since epoch of a local time, by the libc calendar, isdst as tm_isdst
+int64_t mktimeUs(unsigned year, unsigned month, unsigned mday, unsigned hour, int isdst = -1) {
+  struct tm tmh;
+  memset(&tmh, 0, sizeof(tmh));
+  tmh.tm_year = int(year) + 100;
+  tmh.tm_mon = int(month) - 1;
+  tmh.tm_mday = int(mday);
+  tmh.tm_hour = int(hour);
+  tmh.tm_isdst = isdst;
+  time_t secs = mktime(&tmh);
+  return secs == time_t(-1) ? -1 : int64_t(secs) * 1000000;
+}
+
+inline unsigned dayKey(unsigned year, unsigned month, unsigned mday) {
+  return ((year * 16 + month) * 32 + mday) + 1;
+}
+
+// the day (year 2000 + year) in the cache, false: not a valid date
+bool loadDay(day_cache &c, unsigned year, unsigned month, unsigned mday) {
+  // from the noon (no daylight saving change there): no change in the day when
+  // the midnight is 12 h before and the next noon 24 h after
+  int64_t noon = mktimeUs(year, month, mday, 12);
+  if (noon < 0)
+    return false;
+  int64_t midnight = noon - 12 * us_hour;
+  c.dstChange = mktimeUs(year, month, mday, 0) != midnight ||
+                mktimeUs(year, month, mday + 1, 12) != noon + us_day;
+  c.key = dayKey(year, month, mday);
+  c.midnight = midnight;
+  struct tm t;
+  if (!localTm(time_t(noon / 1000000), t))
+    return false;
+  c.year = uint8_t(year);
+  c.month = uint8_t(month);
+  c.mday = uint8_t(mday);
+  c.wday = uint8_t(t.tm_wday == 0 ? 7 : t.tm_wday);
+  c.su = uint8_t(t.tm_isdst > 0);
+  return true;
+}
+
+thread_local day_cache decodeDay;
+thread_local day_cache encodeDay;
+
+inline bool validFields(const cp56time2a &t) {
+  return !t.iv && t.month >= 1 && t.month <= 12 && t.mday >= 1 && t.hour <= 23 && t.min <= 59 &&
+         t.msec < 60000;
+}
+
+int64_t decodeSlow(const cp56time2a &t) {
+  if (!loadDay(decodeDay, t.year, t.month, t.mday)) {
+    decodeDay.key = 0;
+    return -1;
+  }
+  if (decodeDay.dstChange) {
+    int64_t h = mktimeUs(t.year, t.month, t.mday, t.hour);
+    // the hour repeated when the daylight saving ends, by the SU bit
+    int64_t hsu = mktimeUs(t.year, t.month, t.mday, t.hour, t.su);
+    struct tm lt;
+    if (hsu >= 0 && hsu != h && localTm(time_t(hsu / 1000000), lt) && lt.tm_hour == int(t.hour) &&
+        (lt.tm_isdst > 0) == (t.su != 0))
+      h = hsu;
+    return h < 0 ? -1 : h + int64_t(t.min) * 60000000 + int64_t(t.msec) * 1000;
+  }
+  return decodeDay.midnight + (int64_t(t.hour) * 60 + t.min) * 60000000 + int64_t(t.msec) * 1000;
+}
+
+} // namespace
+
+int64_t cp56time2aToUs(const cp56time2a &t) {
+  if (!validFields(t))
+    return -1;
+  if (dayKey(t.year, t.month, t.mday) == decodeDay.key && !decodeDay.dstChange)
+    return decodeDay.midnight + (int64_t(t.hour) * 60 + t.min) * 60000000 + int64_t(t.msec) * 1000;
+  return decodeSlow(t);
+}
+
+void cp56time2aToUs(const cp56time2a *first, size_t stride, unsigned n, int64_t *us) {
+  const char *p = reinterpret_cast<const char *>(first);
+  for (unsigned i = 0; i < n; i++, p += stride) {
+    const cp56time2a &t = *reinterpret_cast<const cp56time2a *>(p);
+    // the objects of an asdu are mostly of the same day: the cached midnight
+    if (validFields(t) && dayKey(t.year, t.month, t.mday) == decodeDay.key && !decodeDay.dstChange)
+      us[i] = decodeDay.midnight + (int64_t(t.hour) * 60 + t.min) * 60000000 + int64_t(t.msec) * 1000;
+    else
+      us[i] = cp56time2aToUs(t);
+  }
+}
+
+void usToCp56time2a(int64_t us, cp56time2a &t) {
+  memset(&t, 0, sizeof(t));
+  day_cache &c = encodeDay;
+  if (c.key == 0 || c.dstChange || us < c.midnight || us >= c.midnight + us_day) {
+    struct tm lt;
+    if (!localTm(time_t(us / 1000000), lt)) {
+      t.iv = 1;
+      return;
+    }
+    if (!loadDay(c, unsigned(lt.tm_year % 100), unsigned(lt.tm_mon + 1), unsigned(lt.tm_mday))) {
+      c.key = 0;
+      t.iv = 1;
+      return;
+    }
+    if (c.dstChange) {
+      // fields from the libc calendar
+      t.msec = uint16_t(lt.tm_sec * 1000 + int((us / 1000) % 1000));
+      t.min = uint8_t(lt.tm_min);
+      t.hour = uint8_t(lt.tm_hour);
+      t.mday = c.mday;
+      t.wday = c.wday;
+      t.month = c.month;
+      t.year = c.year;
+      t.su = uint8_t(lt.tm_isdst > 0);
+      return;
+    }
+  }
+  int64_t ms = (us - c.midnight) / 1000;
+  t.msec = uint16_t(ms % 60000);
+  t.min = uint8_t((ms / 60000) % 60);
+  t.hour = uint8_t(ms / 3600000);
+  t.mday = c.mday;
+  t.wday = c.wday;
+  t.month = c.month;
+  t.year = c.year;
+  t.su = c.su;
+}
+
+int64_t nowUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t monoMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t monoUs() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+char *formatTimeOfDay(char *buf, int64_t us) {
+  cp56time2a t;
+  usToCp56time2a(us, t);
+  unsigned v[4] = {t.hour, t.min, unsigned(t.msec / 1000), unsigned(t.msec % 1000)};
+  char *p = buf;
+  for (int i = 0; i < 3; i++) {
+    *p++ = char('0' + v[i] / 10);
+    *p++ = char('0' + v[i] % 10);
+    *p++ = i < 2 ? ':' : '.';
+  }
+  *p++ = char('0' + v[3] / 100);
+  *p++ = char('0' + v[3] / 10 % 10);
+  *p++ = char('0' + v[3] % 10);
+  *p = 0;
+  return p;
+}
@@ -0,0 +1,62 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef IEC104_TIME_H
+#define IEC104_TIME_H
+
+// CP56Time2a <-> EPOCH TIME (us), LOCAL TIME
+// The calendar of one day (local midnight and date fields) is cached per
+// thread for each direction: converting a time of that day is arithmetic, the
+// libc calendar is called once per day (per call on daylight saving change days).
+
+#include <stddef.h>
+#include <stdint.h>
+#include "iec104_types.h"
+
+// us since epoch of a time tag, -1: not valid (iv set or bad fields)
+int64_t cp56time2aToUs(const cp56time2a &t);
+inline int64_t cp56time2aToMs(const cp56time2a &t) {
+  int64_t us = cp56time2aToUs(t);
+  return us < 0 ? -1 : us / 1000;
+}
+// n time tags, stride bytes apart (the time tags of the objects of an asdu)
+void cp56time2aToUs(const cp56time2a *first, size_t stride, unsigned n, int64_t *us);
+
+// local time tag of us since epoch (wday and su filled, iv clear)
+void usToCp56time2a(int64_t us, cp56time2a &t);
+int64_t nowUs(); // system clock, us since epoch
+int64_t monoMs(); // steady clock, ms (timers)
+int64_t monoUs(); // steady clock, us (latencies)
+inline void cp56time2aNow(cp56time2a &t) { usToCp56time2a(nowUs(), t); }
+// "hh:mm:ss.mmm" local time of us since epoch, buf of 13 bytes at least,
+// returns the end of the text
+char *formatTimeOfDay(char *buf, int64_t us);
+
+#endif // IEC104_TIME_H
@@ -0,0 +1,205 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "iec104_timerwheel.h"
+#include <string.h>
+
+iec104_timer::~iec104_timer() {
+  if (mWheel != nullptr)
+    mWheel->cancel(*this);
+}
+
+iec104_timerwheel::iec104_timerwheel(int64_t now_ms) : mNow(now_ms) {
+  for (unsigned i = 0; i < slots; i++)
+    mSlots[i] = nullptr;
+  memset(mUsed, 0, sizeof(mUsed));
+}
+
+iec104_timerwheel::~iec104_timerwheel() {
+  for (unsigned i = 0; i < slots; i++)
+    while (mSlots[i] != nullptr)
+      cancel(*mSlots[i]);
+  while (mExpiring != nullptr)
+    cancel(*mExpiring);
+}
+
+void iec104_timerwheel::arm(iec104_timer &t, int64_t deadline_ms) {
+  if (t.mWheel != nullptr)
+    t.mWheel->cancel(t);
+  t.mWheel = this;
+  t.mDeadline = deadline_ms;
+  mCount++;
+  insert(t, false);
+  if (onEarlier && (mWake < 0 || deadline_ms < mWake)) {
+    mWake = deadline_ms;
+    onEarlier(deadline_ms);
+  }
+}
+
+void iec104_timerwheel::cancel(iec104_timer &t) {
+  if (t.mWheel != this)
+    return;
+  unlink(t);
+  t.mWheel = nullptr;
+  mCount--;
+}
+
+// the slot by the distance to the deadline, a deadline beyond the last level
+// goes to its farthest slot and is inserted again when cascaded. Cascaded
+// timers of mNow go to its slot (expired next), others not before mNow + 1
+void iec104_timerwheel::insert(iec104_timer &t, bool cascaded) {
+  int64_t first = cascaded ? mNow : mNow + 1;
+  int64_t d = t.mDeadline > first ? t.mDeadline : first;
+  uint64_t delta = uint64_t(d - mNow);
+  unsigned s;
+  if (delta < l0_slots) {
+    s = unsigned(d) & (l0_slots - 1);
+  } else {
+    unsigned level = 1, shift = l0_bits;
+    while (level < levels - 1 && delta >= (uint64_t(1) << (shift + ln_bits))) {
+      level++;
+      shift += ln_bits;
+    }
+    if (delta >= (uint64_t(1) << (shift + ln_bits)))
+      d = mNow + (int64_t(1) << (shift + ln_bits)) - 1;
+    s = l0_slots + (level - 1) * ln_slots + (unsigned(d >> shift) & (ln_slots - 1));
+  }
+  t.mSlot = int(s);
+  t.mPrev = nullptr;
+  t.mNext = mSlots[s];
+  if (t.mNext != nullptr)
+    t.mNext->mPrev = &t;
+  mSlots[s] = &t;
+  mUsed[s >> 6] |= uint64_t(1) << (s & 63);
+}
+
+void iec104_timerwheel::unlink(iec104_timer &t) {
+  iec104_timer *&head = t.mSlot < 0 ? mExpiring : mSlots[t.mSlot];
+  if (t.mPrev != nullptr)
+    t.mPrev->mNext = t.mNext;
+  else
+    head = t.mNext;
+  if (t.mNext != nullptr)
+    t.mNext->mPrev = t.mPrev;
+  if (t.mSlot >= 0 && head == nullptr)
+    mUsed[t.mSlot >> 6] &= ~(uint64_t(1) << (t.mSlot & 63));
+  t.mNext = t.mPrev = nullptr;
+}
+
+void iec104_timerwheel::takeSlot(unsigned s) {
+  mExpiring = mSlots[s];
+  mSlots[s] = nullptr;
+  mUsed[s >> 6] &= ~(uint64_t(1) << (s & 63));
+  for (iec104_timer *t = mExpiring; t != nullptr; t = t->mNext)
+    t->mSlot = -1;
+}
+
+// the slot of level reached at mNow goes to the levels below (the level
+// above first, when this one wrapped)
+void iec104_timerwheel::cascade(unsigned level) {
+  unsigned shift = l0_bits + (level - 1) * ln_bits;
+  unsigned idx = unsigned(mNow >> shift) & (ln_slots - 1);
+  if (idx == 0 && level < levels - 1)
+    cascade(level + 1);
+  takeSlot(l0_slots + (level - 1) * ln_slots + idx);
+  while (mExpiring != nullptr) {
+    iec104_timer *t = mExpiring;
+    unlink(*t);
+    insert(*t, true);
+  }
+}
+
+// smallest k in 1..n with the slot first + (from + k) % n used, -1: none
+int iec104_timerwheel::nextUsed(unsigned first, unsigned n, unsigned from) const {
+  for (unsigned k = 1; k <= n;) {
+    unsigned i = (from + k) & (n - 1);
+    unsigned b = first + i;
+    unsigned span = 64 - (b & 63); // bits of this word from b, in the level
+    if (span > n - i)
+      span = n - i;
+    uint64_t w = mUsed[b >> 6] >> (b & 63);
+    if (span < 64)
+      w &= (uint64_t(1) << span) - 1;
+    if (w != 0) {
+      unsigned z = 0;
+      while (!(w & 1)) {
+        w >>= 1;
+        z++;
+      }
+      return k + z <= n ? int(k + z) : -1;
+    }
+    k += span;
+  }
+  return -1;
+}
+
+// next time after mNow that a level 0 slot expires or a slot cascades
+int64_t iec104_timerwheel::nextEvent() const {
+  int64_t next = -1;
+  int k = nextUsed(0, l0_slots, unsigned(mNow) & (l0_slots - 1));
+  if (k > 0)
+    next = mNow + k;
+  for (unsigned level = 1; level < levels; level++) {
+    unsigned shift = l0_bits + (level - 1) * ln_bits;
+    k = nextUsed(l0_slots + (level - 1) * ln_slots, ln_slots,
+                 unsigned(mNow >> shift) & (ln_slots - 1));
+    if (k > 0) {
+      int64_t t = ((mNow >> shift) + k) << shift;
+      if (next < 0 || t < next)
+        next = t;
+    }
+  }
+  return next;
+}
+
+void iec104_timerwheel::advance(int64_t now_ms) {
+  while (mCount > 0) {
+    int64_t t = nextEvent();
+    if (t < 0 || t > now_ms)
+      break;
+    mNow = t;
+    if ((t & (l0_slots - 1)) == 0)
+      cascade(1);
+    takeSlot(unsigned(t) & (l0_slots - 1));
+    while (mExpiring != nullptr) {
+      iec104_timer *e = mExpiring;
+      cancel(*e);
+      if (e->expire)
+        e->expire(); // may arm or cancel any timer
+    }
+  }
+  if (now_ms > mNow)
+    mNow = now_ms;
+}
+
+int64_t iec104_timerwheel::nextDeadline() const {
+  mWake = mCount > 0 ? nextEvent() : -1;
+  return mWake;
+}
@@ -0,0 +1,105 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+
+#ifndef IEC104_TIMERWHEEL_H
+#define IEC104_TIMERWHEEL_H
+
+// HIERARCHICAL TIMER WHEEL, MILLISECOND DEADLINES
+// Timers of the sessions of one thread (not thread safe). Level 0 has a slot
+// per ms for the next 256 ms, levels 1..3 have 64 slots of 256 ms, 16.4 s and
+// 17.5 min, cascaded to the level below when reached. Arm and cancel are a
+// list insert/unlink, so the timers are re-armed on every event (t3 at each
+// received frame) at no cost; the owner wakes the wheel at nextDeadline().
+
+#include <stdint.h>
+#include <functional>
+
+class iec104_timerwheel;
+
+// a timer is a member of its owner, expire is called from advance()
+class iec104_timer {
+public:
+  explicit iec104_timer(std::function<void()> fn = nullptr) : expire(std::move(fn)) {}
+  ~iec104_timer();
+  iec104_timer(const iec104_timer &) = delete;
+  iec104_timer &operator=(const iec104_timer &) = delete;
+  bool armed() const { return mWheel != nullptr; }
+  int64_t deadline() const { return mDeadline; }
+  std::function<void()> expire;
+
+private:
+  friend class iec104_timerwheel;
+  iec104_timer *mNext = nullptr;
+  iec104_timer *mPrev = nullptr;
+  iec104_timerwheel *mWheel = nullptr; // armed on
+  int64_t mDeadline = 0;               // monotonic ms
+  int mSlot = -1;                      // -1: in the list of expiring timers
+};
+
+class iec104_timerwheel {
+public:
+  explicit iec104_timerwheel(int64_t now_ms = 0);
+  ~iec104_timerwheel();
+  iec104_timerwheel(const iec104_timerwheel &) = delete;
+  iec104_timerwheel &operator=(const iec104_timerwheel &) = delete;
+
+  // (re)arm at deadline_ms (monotonic ms), a passed deadline expires at the
+  // next advance
+  void arm(iec104_timer &t, int64_t deadline_ms);
+  void cancel(iec104_timer &t);
+  // expire the timers up to now_ms, in deadline order (to the ms)
+  void advance(int64_t now_ms);
+  // time of the next expiry or cascade (wake the wheel then), -1: no timers
+  int64_t nextDeadline() const;
+  unsigned count() const { return mCount; } // armed timers
+  // called when a timer is armed to expire before the last nextDeadline()
+  // returned, to wake the wheel earlier
+  std::function<void(int64_t deadline_ms)> onEarlier;
+
+private:
+  static const unsigned l0_bits = 8, ln_bits = 6, levels = 4;
+  static const unsigned l0_slots = 1u << l0_bits, ln_slots = 1u << ln_bits;
+  static const unsigned slots = l0_slots + (levels - 1) * ln_slots;
+  iec104_timer *mSlots[slots];          // timers of each slot (lists)
+  iec104_timer *mExpiring = nullptr;    // taken out of the slot being expired/cascaded
+  uint64_t mUsed[slots / 64];           // bitmap of the slots not empty
+  int64_t mNow;                         // time the wheel was advanced to
+  mutable int64_t mWake = -1;           // last nextDeadline() given
+  unsigned mCount = 0;
+  void insert(iec104_timer &t, bool cascaded);
+  void unlink(iec104_timer &t);
+  void takeSlot(unsigned s); // to mExpiring
+  void cascade(unsigned level);
+  int64_t nextEvent() const;
+  int nextUsed(unsigned first, unsigned n, unsigned from) const;
+};
+
+#endif // IEC104_TIMERWHEEL_H
@@ -25,6 +25,8 @@
 
 #include <cstdint>
 
+#define IEC_OBJECT_MAX	127 // max information objects in one ASDU (7 bit count)
+
 #pragma pack(push)
 #pragma pack(1)
 
@@ -940,6 +942,14 @@ struct iec_apdu {
   };
 };
 
+// generic layout of an information object of a SQ=0 asdu, T is one of the iec_typeN above
+// (SQ=1 asdus have one address followed by an array of T)
+template <class T> struct iec_nsq_obj {
+  uint16_t ioa16;
+  uint8_t ioa8;
+  T obj;
+};
+
 #pragma pack(pop)
 
 #endif // __IEC104_TYPES_H
@@ -0,0 +1,201 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "logmodel.h"
+#include <QColor>
+#include <algorithm>
+#include <ctype.h>
+
+LogModel::LogModel(QObject *parent)
+    : QAbstractListModel(parent), mBlockBase(0), mFirstSeq(0), mCommitSeq(0),
+      mMaxLines(1000000) {}
+
+int LogModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid())
+    return 0;
+  if (!mFilter.empty())
+    return int(mMatch.size());
+  return int(mCommitSeq - mFirstSeq);
+}
+
+const LogModel::Line &LogModel::lineAt(int row) const {
+  if (!mFilter.empty())
+    return mLines[size_t(mMatch[size_t(row)] - mFirstSeq)];
+  return mLines[size_t(row)];
+}
+
+QVariant LogModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= rowCount())
+    return QVariant();
+
+  const Line &l = lineAt(index.row());
+  switch (role) {
+  case Qt::DisplayRole:
+    return QString::fromUtf8(textOf(l), int(l.size));
+  case Qt::ForegroundRole:
+    switch (l.cat) {
+    case CatI104M:
+      return QColor(Qt::lightGray);
+    case CatError:
+      return QColor(Qt::red);
+    default:
+      return QColor(Qt::black);
+    }
+  case Qt::BackgroundRole:
+    if (l.cat == CatCommand)
+      return QColor(Qt::lightGray);
+    break;
+  }
+  return QVariant();
+}
+
+LogModel::Category LogModel::category(const std::string &line) {
+  if (line.find("I104M") != std::string::npos)
+    return CatI104M;
+  if (line.find("COMMAND") != std::string::npos)
+    return CatCommand;
+  if (line.find('[') != std::string::npos)
+    return CatError;
+  return CatNormal;
+}
+
+void LogModel::setMaxLines(unsigned maxlines) {
+  mMaxLines = maxlines > 0 ? maxlines : 1;
+}
+
+void LogModel::append(const std::string &line) {
+  size_t sz = line.size();
+  if (mBlocks.empty() || mBlocks.back().size() + sz > mBlocks.back().capacity()) {
+    mBlocks.emplace_back();
+    mBlocks.back().reserve(std::max(BlockSize, sz));
+  }
+  std::vector<char> &b = mBlocks.back();
+  Line l;
+  l.block = mBlockBase + uint32_t(mBlocks.size() - 1);
+  l.offset = uint32_t(b.size());
+  l.size = uint32_t(sz);
+  l.cat = uint8_t(category(line));
+  b.insert(b.end(), line.begin(), line.end());
+  mLines.push_back(l);
+}
+
+bool LogModel::matches(const Line &l) const {
+  const char *t = textOf(l);
+  return std::search(t, t + l.size, mFilter.begin(), mFilter.end(),
+                     [](char a, char b) {
+                       return tolower((unsigned char)a) == b;
+                     }) != t + l.size;
+}
+
+void LogModel::commitLines() {
+  if (mLines.size() > mMaxLines) {
+    uint64_t newFirst = mFirstSeq + (mLines.size() - mMaxLines);
+    uint64_t shownEnd = std::min(newFirst, mCommitSeq);
+    size_t rows = 0;
+    if (!mFilter.empty()) {
+      while (rows < mMatch.size() && mMatch[rows] < shownEnd)
+        rows++;
+    } else if (shownEnd > mFirstSeq) {
+      rows = size_t(shownEnd - mFirstSeq);
+    }
+
+    if (rows)
+      beginRemoveRows(QModelIndex(), 0, int(rows) - 1);
+    if (!mFilter.empty())
+      mMatch.erase(mMatch.begin(), mMatch.begin() + rows);
+    mLines.erase(mLines.begin(), mLines.begin() + size_t(newFirst - mFirstSeq));
+    mFirstSeq = newFirst;
+    if (mCommitSeq < newFirst) // dropped before being shown
+      mCommitSeq = newFirst;
+    // release the blocks no longer referenced, keeps the one being filled
+    while (mBlocks.size() > 1 && mLines.front().block > mBlockBase) {
+      mBlocks.pop_front();
+      mBlockBase++;
+    }
+    if (rows)
+      endRemoveRows();
+  }
+
+  uint64_t end = mFirstSeq + mLines.size();
+  if (mCommitSeq == end)
+    return;
+
+  if (!mFilter.empty()) {
+    std::vector<uint64_t> found;
+    for (uint64_t s = mCommitSeq; s < end; s++)
+      if (matches(mLines[size_t(s - mFirstSeq)]))
+        found.push_back(s);
+    mCommitSeq = end;
+    if (found.empty())
+      return;
+    int first = int(mMatch.size());
+    beginInsertRows(QModelIndex(), first, first + int(found.size()) - 1);
+    mMatch.insert(mMatch.end(), found.begin(), found.end());
+    endInsertRows();
+  } else {
+    int first = int(mCommitSeq - mFirstSeq);
+    beginInsertRows(QModelIndex(), first, int(end - mFirstSeq) - 1);
+    mCommitSeq = end;
+    endInsertRows();
+  }
+}
+
+void LogModel::setFilter(const QString &text) {
+  std::string f = text.toStdString();
+  for (char &c : f)
+    c = char(tolower((unsigned char)c));
+  if (f == mFilter)
+    return;
+
+  beginResetModel();
+  mFilter = f;
+  mMatch.clear();
+  if (!mFilter.empty())
+    for (uint64_t s = mFirstSeq; s < mCommitSeq; s++)
+      if (matches(mLines[size_t(s - mFirstSeq)]))
+        mMatch.push_back(s);
+  endResetModel();
+}
+
+QString LogModel::lineText(int row) const {
+  if (row < 0 || row >= rowCount())
+    return QString();
+  const Line &l = lineAt(row);
+  return QString::fromUtf8(textOf(l), int(l.size));
+}
+
+void LogModel::clear() {
+  beginResetModel();
+  mLines.clear();
+  mBlocks.clear();
+  mMatch.clear();
+  mBlockBase = 0;
+  mFirstSeq = mCommitSeq = 0;
+  endResetModel();
+}
@@ -0,0 +1,89 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+// Model of the log view: the lines are kept packed in large text blocks with a
+// small record per line (position, size, colour category), so millions of lines
+// can be retained and the view only formats the rows it paints.
+// Lines are appended without signals and told to the view once per drain
+// (commitLines), that also drops the oldest lines above the limit.
+// An optional filter shows only the lines containing a text (case insensitive).
+
+#include <QAbstractListModel>
+#include <QString>
+#include <stdint.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+class LogModel : public QAbstractListModel {
+  Q_OBJECT
+
+public:
+  enum Category { CatNormal, CatI104M, CatCommand, CatError };
+
+  explicit LogModel(QObject *parent = nullptr);
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+  void setMaxLines(unsigned maxlines); // retained lines, applied at the next commitLines
+  void append(const std::string &line); // no signals
+  void commitLines(); // drop the oldest lines above the limit, insert the new in the view
+  void setFilter(const QString &text); // empty: all lines
+  QString lineText(int row) const;
+  void clear();
+
+  static Category category(const std::string &line);
+
+private:
+  struct Line {
+    uint32_t block;  // block id
+    uint32_t offset; // in the block
+    uint32_t size;
+    uint8_t cat;     // Category, computed once at append
+  };
+  static const size_t BlockSize = 1 << 20;
+
+  const Line &lineAt(int row) const;
+  const char *textOf(const Line &l) const { return mBlocks[l.block - mBlockBase].data() + l.offset; }
+  bool matches(const Line &l) const;
+
+  std::deque<Line> mLines;               // oldest first
+  std::deque<std::vector<char>> mBlocks; // text of the lines
+  uint32_t mBlockBase;                   // id of mBlocks.front()
+  uint64_t mFirstSeq;                    // sequence number of mLines.front()
+  uint64_t mCommitSeq;                   // lines below are in the view
+  size_t mMaxLines;
+  std::string mFilter;                   // lower case
+  std::deque<uint64_t> mMatch;           // filtered: sequence numbers of the rows
+};
+
+#endif // LOGMODEL_H
@@ -27,21 +27,47 @@
  * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
  */
 
+#include <string.h>
 #include "logmsg.h"
+#include "iec104_time.h"
 
 using namespace std;
 
 TLogMsg::TLogMsg()
 {
-    mMaxMsg = 1000;
+    mMaxMsg = 0;
+    mWrite = 0;
+    mRead = 0;
+    mDropped = 0;
+    mDropLine = false;
+    mLastSec = 0;
+    mPolicy = DropNewest;
     mDoLog = true;
     mRegTime = false;
     mLevel = 0;
+    setMaxMsg(4096);
 }
 
 void TLogMsg::setMaxMsg(unsigned int maxmsg)
 {
-    mMaxMsg = maxmsg;
+    unsigned int cap = 16;
+    while ( cap < maxmsg )
+        cap <<= 1;
+    if ( cap == mMaxMsg )
+        return;
+
+    mSlots.reset( new TLogSlot[cap] );
+    for ( unsigned int i = 0; i < cap; i++ )
+        mSlots[i].seq.store( 0, memory_order_relaxed );
+    mMaxMsg = cap;
+    mMask = cap - 1;
+    mWrite = 0;
+    mRead = 0;
+}
+
+void TLogMsg::setPolicy(TLogPolicy policy)
+{
+    mPolicy = policy;
 }
 
 void TLogMsg::setLevel(unsigned int level)
@@ -56,15 +82,13 @@ void TLogMsg::activateLog()
 
 void TLogMsg::deactivateLog()
 {
-    mLstLog.clear(); // clean lists
-    mLstTime.clear();
     mDoLog = false;
+    mRead.store( mWrite.load( memory_order_acquire ) ); // clean queue
 }
 
 void TLogMsg::doLogTime()
 {
-    mLstLog.clear(); // clean lists, sync
-    mLstTime.clear();
+    mRead.store( mWrite.load( memory_order_acquire ) ); // clean queue, sync
     mRegTime = true;
 }
 
@@ -75,7 +99,7 @@ void TLogMsg::dontLogTime()
 
 bool TLogMsg::haveMsg()
 {
-    return !mLstLog.empty();
+    return mRead.load( memory_order_relaxed ) != mWrite.load( memory_order_acquire );
 }
 
 bool TLogMsg::isLogging()
@@ -83,50 +107,179 @@ bool TLogMsg::isLogging()
     return mDoLog;
 }
 
+int TLogMsg::count()
+{
+    uint64_t n = mWrite.load( memory_order_acquire ) - mRead.load( memory_order_relaxed );
+    return int( n > mMaxMsg ? mMaxMsg : n );
+}
+
+unsigned long TLogMsg::dropped() const
+{
+    return mDropped.load( memory_order_relaxed );
+}
+
+bool TLogMsg::willLog( unsigned int level ) const
+{
+    if ( !mDoLog.load( memory_order_relaxed ) || level < mLevel.load( memory_order_relaxed ) )
+        return false;
+    return mPolicy.load( memory_order_relaxed ) == OverwriteOldest ||
+           mWrite.load( memory_order_relaxed ) - mRead.load( memory_order_acquire ) < mMaxMsg;
+}
+
+// producer: write one slot
+bool TLogMsg::put( TLogRender render, const void * rec, unsigned int size, bool append, int64_t time_us )
+{
+    uint64_t w = mWrite.load( memory_order_relaxed );
+    if ( mPolicy.load( memory_order_relaxed ) == DropNewest &&
+         w - mRead.load( memory_order_acquire ) >= mMaxMsg ) {
+        mDropped.fetch_add( 1, memory_order_relaxed );
+        return false;
+    }
+
+    TLogSlot & sl = mSlots[w & mMask];
+    sl.seq.store( 2 * w + 1, memory_order_relaxed );
+    atomic_thread_fence( memory_order_release );
+    sl.render = render;
+    sl.time_us = time_us;
+    sl.size = uint16_t( size );
+    sl.append = append;
+    memcpy( sl.data, rec, size );
+    sl.seq.store( 2 * w + 2, memory_order_release );
+    mWrite.store( w + 1, memory_order_release );
+    return true;
+}
+
+// consumer: copy message n out of its slot
+int TLogMsg::get( uint64_t n, TLogSlot & copy )
+{
+    const TLogSlot & sl = mSlots[n & mMask];
+    uint64_t seq = sl.seq.load( memory_order_acquire );
+    if ( seq < 2 * n + 2 )
+        return 0;
+    if ( seq > 2 * n + 2 )
+        return -1;
+
+    copy.render = sl.render;
+    copy.time_us = sl.time_us;
+    copy.size = sl.size < SLOT_DATA ? sl.size : uint16_t( SLOT_DATA );
+    copy.append = sl.append;
+    memcpy( copy.data, sl.data, copy.size );
+
+    atomic_thread_fence( memory_order_acquire );
+    if ( sl.seq.load( memory_order_relaxed ) != seq ) // overwritten while copying
+        return -1;
+    return 1;
+}
+
 // coloca a mensagem na fila
 void TLogMsg::pushMsg( const char * msg, unsigned int level )
 {
-    if ( mDoLog && ( mLstLog.size() < mMaxMsg ) && ( mLevel <= level ) ) {
-        mLstLog.push_back( msg );
-        if ( mRegTime ) { // coloca hora na fila, se for o caso
-            mLstTime.push_back( time( NULL ) );
+    if ( !mDoLog.load( memory_order_relaxed ) || level < mLevel.load( memory_order_relaxed ) ) {
+        mDropLine = true;
+        return;
+    }
+
+    int64_t t = mRegTime.load( memory_order_relaxed ) ? nowUs() : 0;
+    unsigned int len = unsigned( strlen( msg ) );
+    unsigned int pos = 0;
+    mDropLine = false;
+    do { // long text takes more slots, on the same line
+        unsigned int n = len - pos < SLOT_DATA ? len - pos : SLOT_DATA;
+        if ( !put( nullptr, msg + pos, n, pos != 0, t ) ) {
+            mDropLine = true;
+            break;
         }
+        pos += n;
+    } while ( pos < len );
+}
+
+// coloca o registro binario na fila, o texto so e formatado ao retirar
+void TLogMsg::pushRecord( TLogRender render, const void * rec, unsigned int size, unsigned int level, bool append )
+{
+    if ( size > SLOT_DATA )
+        size = SLOT_DATA;
+
+    if ( append ) { // continua a linha anterior, se ela foi aceita
+        if ( !mDropLine && mDoLog.load( memory_order_relaxed ) && !put( render, rec, size, true, 0 ) )
+            mDropLine = true;
+        return;
     }
+
+    if ( !mDoLog.load( memory_order_relaxed ) || level < mLevel.load( memory_order_relaxed ) ) {
+        mDropLine = true;
+        return;
+    }
+
+    int64_t t = mRegTime.load( memory_order_relaxed ) ? nowUs() : 0;
+    mDropLine = !put( render, rec, size, false, t );
 }
 
-int TLogMsg::count()
+void TLogMsg::render( string & out, const TLogSlot & sl )
 {
-    return int(mLstLog.size());
+    if ( sl.render == nullptr )
+        out.append( sl.data, sl.size );
+    else
+        sl.render( out, sl.data, sl.size );
 }
 
 // Tira mensagem da fila
 string TLogMsg::pullMsg()
 {
-    if ( mLstLog.empty() || !mDoLog )
-        return "";
-
-    string s = mLstLog.front();   // pega a primeira da fila
-    mLstLog.pop_front();          // retira-a da fila
-
-    // se tem registro de hora, pega a hora e formata para exibir antes da mensagem
-    if (mRegTime){
-        char buffer [201];
-        static time_t hora_ant;
-        time_t hora = mLstTime.front();
-        mLstTime.pop_front();
-        if (hora != hora_ant)
-          {
-          struct tm * timeinfo;
-          timeinfo = localtime ( &hora );
-          // strftime ( buffer,200,"%d/%m %H:%M:%S ",timeinfo );
-          strftime ( buffer,200,"%H:%M:%S ",timeinfo );
-          s = buffer + s;
-          }
-        else
-          s = "         " + s;
-        hora_ant = hora;
-    }
-
+    string s;
+    pullMsg( s );
     return s;
 }
 
+bool TLogMsg::pullMsg( string & s )
+{
+    s.clear();
+    if ( !mDoLog )
+        return false;
+
+    TLogSlot sl;
+    uint64_t r = mRead.load( memory_order_relaxed );
+    for ( ;; ) {
+        int st = get( r, sl );
+        if ( st == 0 ) {
+            mRead.store( r, memory_order_release );
+            return false;
+        }
+        if ( st > 0 && !sl.append )
+            break;
+        // overwritten by the producer (OverwriteOldest) or rest of a lost line: skip
+        if ( st < 0 ) {
+            uint64_t oldest = mWrite.load( memory_order_acquire ) - mMaxMsg + 1;
+            mDropped.fetch_add( static_cast<unsigned long>( oldest - r ), memory_order_relaxed );
+            r = oldest;
+        } else {
+            r++;
+        }
+    }
+
+    int64_t time_us = sl.time_us;
+    render( s, sl ); // pega a primeira da fila
+    r++;             // retira-a da fila
+
+    // registros que continuam a mesma linha
+    while ( get( r, sl ) > 0 && sl.append ) {
+        render( s, sl );
+        r++;
+    }
+    mRead.store( r, memory_order_release );
+
+    // se tem registro de hora, formata para exibir antes da mensagem
+    if ( mRegTime ) {
+        char buffer [20];
+        time_t hora = time_t( time_us / 1000000 );
+        // hh:mm:ss.mmm from the cached calendar of the day (no localtime)
+        char * end = formatTimeOfDay( buffer, time_us );
+        if ( hora == mLastSec )
+            memset( buffer, ' ', 8 );
+        end[0] = ' ';
+        end[1] = 0;
+        mLastSec = hora;
+        s.insert( 0, buffer );
+    }
+
+    return true;
+}
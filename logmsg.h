@@ -31,34 +31,72 @@
 #define LOGMSG_H
 
 // Buffered  message
+// Fixed capacity ring of preallocated slots, one producer thread (pushMsg, pushRecord)
+// and one consumer thread (pullMsg, haveMsg) without locks or allocation on push.
 
 #include <time.h>
-#include <list>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
 #include <string>
 
+// renders a binary log record to text, called only when the message is pulled
+typedef void (*TLogRender)(std::string & out, const void * rec, unsigned int size);
+
 class TLogMsg
 {
 public:
+    enum TLogPolicy {
+        DropNewest,     // ring full: new messages are dropped
+        OverwriteOldest // ring full: new messages overwrite the oldest not pulled
+    };
+    static const unsigned int SLOT_DATA = 288; // bytes of one slot, longer messages take more slots
+
     TLogMsg();
     void pushMsg(const char * msg, unsigned int level=0); // level: 0=less important
+    // queue a binary record, formatted by render only when pulled
+    // append: the record continues the line of the previous record
+    void pushRecord(TLogRender render, const void * rec, unsigned int size, unsigned int level=0, bool append=false);
+    bool willLog(unsigned int level=0) const; // a message of this level would be queued
     std::string pullMsg();
+    bool pullMsg(std::string & s); // reuses s, false when there is no message
     void activateLog();
     void deactivateLog();
     void doLogTime();
     void dontLogTime();
-    void setMaxMsg(unsigned int maxmsg);
+    void setMaxMsg(unsigned int maxmsg); // ring slots (rounded up to a power of 2), call before use
+    void setPolicy(TLogPolicy policy);
     bool haveMsg();
     void setLevel(unsigned int nivel); // set exibition level
     bool isLogging();
     int count();
+    unsigned long dropped() const; // slots lost to a full ring (a long line takes several)
 
 private:
-    std::list <std::string> mLstLog;
-    std::list <time_t> mLstTime;
+    struct TLogSlot {
+        std::atomic<uint64_t> seq; // 2*n+2: holds message n, odd: being written
+        TLogRender render;         // nullptr for text
+        int64_t time_us;           // wall clock of the line, us
+        uint16_t size;
+        bool append;
+        char data[SLOT_DATA];
+    };
+    bool put(TLogRender render, const void * rec, unsigned int size, bool append, int64_t time_us);
+    int get(uint64_t n, TLogSlot & copy); // 1: ok, 0: not written yet, -1: overwritten
+    static void render(std::string & out, const TLogSlot & sl);
+
+    std::unique_ptr<TLogSlot[]> mSlots;
+    uint64_t mMask;
+    std::atomic<uint64_t> mWrite; // next message to write (producer)
+    std::atomic<uint64_t> mRead;  // next message to read (consumer)
+    std::atomic<unsigned long> mDropped;
+    bool mDropLine;               // producer: last line was dropped, drop its appended records
+    time_t mLastSec;              // consumer: second of the last pulled line
     unsigned int mMaxMsg;
-    bool mDoLog;
-    bool mRegTime;
-    unsigned int mLevel; // exibition level 0=all, 1 an on, exibit more information progressively
+    std::atomic<TLogPolicy> mPolicy;
+    std::atomic<bool> mDoLog;
+    std::atomic<bool> mRegTime;
+    std::atomic<unsigned int> mLevel; // exibition level 0=all, 1 an on, exibit more information progressively
 };
 
 #endif // LOGMSG_H
@@ -28,10 +28,26 @@
  */
 
 #include <QtWidgets/QApplication>
+#include <string.h>
 #include "mainwindow.h"
+#include "concentrator.h"
 
 int main(int argc, char *argv[])
 {
+    // concentrator mode, many RTUs without user interface:
+    // QTester104 --concentrator [ini file]
+    if (argc > 1 && strcmp(argv[1], "--concentrator") == 0) {
+        QCoreApplication a(argc, argv);
+        Concentrator c(argc > 2 ? QString(argv[2]) : Concentrator::defaultIniName());
+        if (c.sessionCount() == 0) {
+            fprintf(stderr, "No [RTUn] sections with IP_ADDRESS in the ini file!\n");
+            return 1;
+        }
+        QObject::connect(&a, &QCoreApplication::aboutToQuit, &c, &Concentrator::stop);
+        c.start();
+        return a.exec();
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
 
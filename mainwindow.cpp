@@ -32,7 +32,13 @@
 #include <QClipboard>
 #include <QCloseEvent>
 #include <QDateTime>
+#include <QDateTimeEdit>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFormLayout>
+#include <QHeaderView>
 #include <QItemSelectionModel>
 #include <QRegularExpression>
 #include <string>
@@ -72,6 +78,64 @@ MainWindow::MainWindow(QWidget *parent)
   i104.setSecondaryIP(const_cast<char *>(IPEscravo.toStdString().c_str()));
   i104.setPortTCP(settings.value("RTU1/TCP_PORT", i104.getPortTCP()).toUInt());
   i104.setGIPeriod(settings.value("RTU1/GI_PERIOD", 330).toUInt());
+  i104.setGIGroups(iec104_gischeduler::parseGroups(
+                       settings.value("RTU1/GI_GROUPS", "").toString().toStdString()),
+                   settings.value("RTU1/GI_PARALLEL", 1).toUInt());
+  i104.setWindow(settings.value("IEC104/K", 12).toUInt(),
+                 settings.value("IEC104/W", 8).toUInt());
+  i104.setTimeouts(settings.value("IEC104/T1", 15).toDouble(),
+                   settings.value("IEC104/T2", 8).toDouble(),
+                   settings.value("IEC104/T3", 10).toDouble());
+  i104.setReconnect(settings.value("IEC104/RECONNECT_MIN", 1).toDouble(),
+                    settings.value("IEC104/RECONNECT_MAX", 30).toDouble());
+  i104.setStatsPeriod(mStatsExport.configure(settings));
+
+  // protocol engine and socket on their own thread, the ui gets batches of points
+  if (settings.value("IEC104/IO_THREAD", 0).toInt())
+    i104.startIOThread();
+
+  // binary capture of the frames of the link
+  QString captureFile = settings.value("CAPTURE/RECORD", "").toString();
+  if (captureFile != "" &&
+      !i104.startCapture(captureFile, settings.value("CAPTURE/SIZE_MB", 64).toUInt()))
+    i104.logMsg("CAPTURE: CAN'T CREATE FILE");
+
+  // hot standby: the secondary keeps the point cache of the primary, the
+  // takeover is detected in a few keep alive periods
+  I104M_HotStandby = settings.value("I104M/HOT_STANDBY", 0).toInt() != 0;
+  I104M_ms_kamsg =
+      settings.value("I104M/KEEPALIVE_MS", I104M_HotStandby ? 250 : 7000).toInt();
+  if (I104M_ms_kamsg < 10)
+    I104M_ms_kamsg = 10;
+
+  // last values of the points, kept across restarts
+  QString cacheFile = settings.value("CACHE/FILE", I104M_HotStandby ? "qtester104.pnt" : "").toString();
+  // hot standby: after a takeover only the groups not refreshed by the
+  // primary since two GI periods are interrogated
+  unsigned cacheStale = settings.value("CACHE/STALE", I104M_HotStandby ? 2 * i104.getGIPeriod() : 0).toUInt();
+  if (cacheFile != "" &&
+      !i104.openPointCache(cacheFile, settings.value("CACHE/CAPACITY", 65536).toUInt(),
+                           cacheStale))
+    i104.logMsg("CACHE: CAN'T OPEN FILE");
+  i104.setCacheReplication(I104M_HotStandby);
+
+  // history of the time tagged events
+  mSOEDir = settings.value("SOE/DIR", "").toString();
+  if (mSOEDir != "" &&
+      !i104.openSOE(mSOEDir, settings.value("SOE/FLUSH", 5).toUInt())) {
+    i104.logMsg("SOE: CAN'T OPEN DIRECTORY");
+    mSOEDir = "";
+  }
+
+  // measured values to the table and to OSHMI only when changed
+  i104.setChangeFilter(settings.value("DEADBAND/ABSOLUTE", 0).toDouble(),
+                       settings.value("DEADBAND/PERCENT", 0).toDouble(),
+                       settings.value("DEADBAND/CYCLIC_CHANGED", 0).toInt() != 0);
+
+  // commands timed to their responses, the selects executed at their ACTCON
+  // (SBO_EXECUTE=0: by OSHMI or the user, the select ACTCON is forwarded)
+  i104.setCommandTracking(settings.value("IEC104/COMMAND_TIMEOUT", 30).toDouble(),
+                          settings.value("IEC104/SBO_EXECUTE", 1).toInt() != 0);
 
   // this is for using with the OSHMI HMI in a dual architecture
   QSettings settings_oshmi("../conf/hmi.ini", QSettings::IniFormat);
@@ -102,6 +166,14 @@ MainWindow::MainWindow(QWidget *parent)
   udps = new QUdpSocket();
   udps->bind(I104M_porta_escuta);
   udps->open(QIODevice::ReadWrite);
+  I104M_fwd.setSocket(udps);
+  I104M_fwd.setHosts(I104M_host, I104M_host_dual);
+  I104M_fwd.setCoalesceTime(settings.value("I104M/COALESCE_US", 0).toUInt());
+  I104M_rep.setSocket(udps);
+  I104M_rep.setHost(I104M_host_dual);
+  if (I104M_HotStandby)
+    // room for a paced dump of the cache
+    udps->setSocketOption(QAbstractSocket::ReceiveBufferSizeSocketOption, 2 << 20);
 
   QString qs;
   QTextStream(&qs) << i104.getPortTCP();
@@ -117,50 +189,95 @@ MainWindow::MainWindow(QWidget *parent)
   ui->leIPRemoto->setText(IPEscravo);
 
   tmLogMsg = new QTimer();
+  tmRefresh = new QTimer();
   tmI104M_kamsg = new QTimer();
 
   connect(udps, SIGNAL(readyRead()), this, SLOT(slot_I104M_ready_to_read()));
   connect(tmLogMsg, SIGNAL(timeout()), this, SLOT(slot_timer_logmsg()));
+  connect(tmRefresh, SIGNAL(timeout()), this, SLOT(slot_timer_refresh()));
   connect(tmI104M_kamsg, SIGNAL(timeout()), this,
           SLOT(slot_timer_I104M_kamsg()));
-  connect(&i104, SIGNAL(signal_dataIndication(iec_obj *, unsigned)), this,
-          SLOT(slot_dataIndication(iec_obj *, unsigned)));
+  if (i104.isThreaded()) {
+    connect(&i104, &QIec104::signal_dataBatch, this,
+            &MainWindow::slot_dataBatch);
+    connect(&i104, &QIec104::signal_cacheBatch, this,
+            &MainWindow::slot_cacheBatch);
+    connect(&i104, &QIec104::signal_commandActResp, this,
+            &MainWindow::slot_commandActResp);
+  } else {
+    connect(&i104, SIGNAL(signal_dataIndication(iec_obj *, unsigned)), this,
+            SLOT(slot_dataIndication(iec_obj *, unsigned)));
+    connect(&i104, SIGNAL(signal_cacheIndication(iec_obj *, unsigned)), this,
+            SLOT(slot_cacheIndication(iec_obj *, unsigned)));
+    connect(&i104, SIGNAL(signal_commandActRespIndication(iec_obj *)), this,
+            SLOT(slot_commandActRespIndication(iec_obj *)));
+  }
   connect(&i104, SIGNAL(signal_interrogationActConfIndication()), this,
           SLOT(slot_interrogationActConfIndication()));
   connect(&i104, SIGNAL(signal_interrogationActTermIndication()), this,
           SLOT(slot_interrogationActTermIndication()));
   connect(&i104, SIGNAL(signal_tcp_connect()), this, SLOT(slot_tcpconnect()));
+  connect(&i104, &QIec104::signal_stats, this, &MainWindow::slot_stats);
   connect(&i104, SIGNAL(signal_tcp_disconnect()), this,
           SLOT(slot_tcpdisconnect()));
-  connect(&i104, SIGNAL(signal_commandActRespIndication(iec_obj *)), this,
-          SLOT(slot_commandActRespIndication(iec_obj *)));
 
   ui->pbGI->setEnabled(false);
   ui->pbSendCommandsButton->setEnabled(false);
-
-  ui->twPontos->clear();
-  ui->twPontos->setSortingEnabled(false);
-  ui->twPontos->setColumnCount(8);
-  ui->twPontos->sortByColumn(0, Qt::AscendingOrder);
-
-  if (IPEscravo != "")
+  ui->pbSOE->setEnabled(mSOEDir != "");
+
+  // points table: model sorted by address in the view
+  mPoints = new PointsModel(this);
+  mPointsSort = new QSortFilterProxyModel(this);
+  mPointsSort->setSourceModel(mPoints);
+  mPointsSort->setSortRole(PointsModel::SortRole);
+  ui->twPontos->setModel(mPointsSort);
+  ui->twPontos->setSelectionMode(QAbstractItemView::NoSelection);
+  ui->twPontos->setSortingEnabled(true);
+  ui->twPontos->sortByColumn(PointsModel::ColAddress, Qt::AscendingOrder);
+  // fixed row height, row sizes are not computed from the contents
+  ui->twPontos->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  ui->twPontos->verticalHeader()->setDefaultSectionSize(
+      ui->twPontos->fontMetrics().height() + 6);
+
+  // log view: lines kept in the model
+  mLogLines = new LogModel(this);
+  mLogLines->setMaxLines(settings.value("UI/LOG_LINES", 1000000).toUInt());
+  ui->lwLog->setModel(mLogLines);
+
+  // statistics panel, updated every [STATS] PERIOD seconds
+  mStatsText = new QPlainTextEdit(this);
+  mStatsText->setReadOnly(true);
+  mStatsText->setLineWrapMode(QPlainTextEdit::NoWrap);
+  mStatsDock = new QDockWidget(tr("Statistics"), this);
+  mStatsDock->setWidget(mStatsText);
+  addDockWidget(Qt::RightDockWidgetArea, mStatsDock);
+  mStatsDock->hide();
+  connect(mStatsDock, &QDockWidget::visibilityChanged, ui->cbStats,
+          &QCheckBox::setChecked);
+
+  // points table repaint rate, independent of the rate of the points
+  RefreshHz = settings.value("UI/REFRESH_HZ", 10).toInt();
+  if (RefreshHz < 1)
+    RefreshHz = 1;
+  if (RefreshHz > 60)
+    RefreshHz = 60;
+
+  // warm start: the cached points to the table and to OSHMI
+  showCachedPoints(true);
+
+  // replay of a capture instead of the link
+  QString replayFile = settings.value("CAPTURE/REPLAY", "").toString();
+  if (replayFile != "") {
+    if (!i104.startReplay(replayFile, settings.value("CAPTURE/SPEED", 1).toDouble()))
+      i104.logMsg("REPLAY: CAN'T OPEN CAPTURE FILE");
+  } else if (IPEscravo != "")
     on_pbConnect_clicked();
 
-  QStringList colunas;
-  colunas << "Address"
-          << "CA"
-          << "Value"
-          << "Type"
-          << "Cause"
-          << "Flags"
-          << "Count"
-          << "TimeTag";
-  ui->twPontos->setHorizontalHeaderLabels(colunas);
-
   tmLogMsg->start(500);
+  tmRefresh->start(1000 / RefreshHz);
 
   if (I104M_HaveDualHost()) {
-    tmI104M_kamsg->start(I104M_seconds_kamsg * 1000);
+    tmI104M_kamsg->start(I104M_ms_kamsg);
     isPrimary = false;
     i104.disable_connect();
     ui->lbMode->setText("<font color='red'>Secondary</font>");
@@ -178,21 +295,21 @@ MainWindow::MainWindow(QWidget *parent)
   font.setPointSize(9);
   font.setFixedPitch(true);
   ui->lwLog->setFont(font);
+  mStatsText->setFont(font);
 }
 
 MainWindow::~MainWindow() {
   delete ui;
   delete tmLogMsg;
+  delete tmRefresh;
   delete tmI104M_kamsg;
 }
 
-void MainWindow::on_pbGI_clicked() { i104.solicitGI(); }
+void MainWindow::on_pbGI_clicked() { i104.requestGI(); }
 
 void MainWindow::on_pbConnect_clicked() {
-  if (i104.tmKeepAlive->isActive()) {
-    i104.tmKeepAlive->stop();
-    i104.tcps->close();
-    i104.slot_tcpdisconnect();
+  if (i104.isLinkActive()) {
+    i104.stopLink();
   } else {
     i104.setSecondaryIP(
         const_cast<char *>(ui->leIPRemoto->text().toStdString().c_str()));
@@ -216,18 +333,10 @@ void MainWindow::on_pbConnect_clicked() {
     ui->pbConnect->setText("Give up...");
     ui->lbStatus->setText("<font color='green'>TRYING TO CONNECT!</font>");
 
-    mapPtItem_ColAddress.clear();
-    mapPtItem_ColCommonAddress.clear();
-    mapPtItem_ColValue.clear();
-    mapPtItem_ColType.clear();
-    mapPtItem_ColCause.clear();
-    mapPtItem_ColFlags.clear();
-    mapPtItem_ColCount.clear();
-    mapPtItem_ColTimeTag.clear();
-    ui->twPontos->clearContents();
-    ui->twPontos->setRowCount(0);
+    mPoints->clear();
+    showCachedPoints(false);
     // ui->lwLog->clear();
-    i104.tmKeepAlive->start(1000);
+    i104.startLink();
   }
 }
 
@@ -262,103 +371,91 @@ void MainWindow::slot_I104M_ready_to_read() {
     // I104M message
     t_msgcmd *pmsg = reinterpret_cast<t_msgcmd *>(br);
 
-    sprintf(buf, "%3d: I104M: ", bytesrec);
-    for (int i = 0; i < bytesrec; i++)
-      sprintf(buf + strlen(buf), "%02x ", br[i]);
+    if (pmsg->signature == MSGREP_SIG) {
+      // hot standby: records of the point cache of the primary (not dumped to the log)
+      QVector<pointcache_rec> recs;
+      if (!I104M_HotStandby || isPrimary)
+        continue;
+      if (!I104M_rep.receive(reinterpret_cast<t_msgrep *>(br), unsigned(bytesrec), recs)) {
+        I104M_Loga("R--> I104M: Invalid Replica Message!");
+        continue;
+      }
+      i104.replicateRecords(recs);
+      if (ui->cbPointMap->isChecked())
+        for (const pointcache_rec &r : recs)
+          mPoints->update(&r.obj, 1);
+      continue;
+    }
+
+    // hex dump of the first 100 bytes
+    int pos = sprintf(buf, "%3d: I104M: ", bytesrec);
+    for (int i = 0; i < bytesrec && i < 100; i++)
+      pos += sprintf(buf + pos, "%02x ", br[i]);
+    if (bytesrec > 100)
+      sprintf(buf + pos, "...");
     I104M_Loga(buf);
 
+    if (pmsg->signature == MSGCMDSQ_SIG) {
+      // command sequence, sent back-to-back to the RTU
+      QVector<iec_obj> objs;
+      int n = I104MForwarder::commandSeqToObjs(
+          reinterpret_cast<t_msgcmdsq *>(br), unsigned(bytesrec), objs);
+      if (n < 0) {
+        I104M_Loga("R--> I104M: Invalid Command Sequence Message!");
+        continue;
+      }
+      sprintf(buf, "R--> I104M: Command Sequence, %d commands (%d not IEC104)",
+              int(objs.size()), n - int(objs.size()));
+      I104M_Loga(buf);
+      if (!objs.isEmpty())
+        i104.requestCommands(objs);
+      continue;
+    }
+
     if (pmsg->signature != MSGCMD_SIG)
       I104M_Loga("R--> I104M: Invalid Message!");
 
     iec_obj obj;
-    obj.cause = iec104_class::ACTIVATION;
-    obj.address = pmsg->endereco;
-    obj.ca = static_cast<unsigned short>(pmsg->utr);
-    obj.qu = static_cast<unsigned char>(pmsg->qu);
-    obj.se = static_cast<unsigned char>(pmsg->sbo);
-    obj.type = static_cast<unsigned char>(pmsg->tipo);
 
     switch (pmsg->tipo) {
     case I104M_ASDU_SPECIAL_CMD: // special command
       if (pmsg->endereco ==
           I104M_SPECIAL_CMD_ADDR_REQ_GI) { // request general interrogation
         I104M_Loga("R--> I104M: REQ GI");
-        i104.solicitGI();
+        i104.requestGI();
       } else if (pmsg->endereco == I104M_SPECIAL_CMD_ADDR_KEEP_ALIVE &&
                  (address.toString() != I104M_host_dual.toString() ||
                   address.toString() !=
                       (QString("::ffff:") + I104M_host_dual.toString())) &&
                  i104.ForcePrimary == 0) { // keep alive
-        I104M_Loga("R--> I104M: KEEP ALIVE FROM REDUNDANT COMPUTER");
+        if (!I104M_HotStandby)
+          I104M_Loga("R--> I104M: KEEP ALIVE FROM REDUNDANT COMPUTER");
         if (isPrimary) {
           I104M_Loga("     I104M: BECOMMING SECONDARY!");
           ui->lbMode->setText("<font color='red'></font>");
+          I104M_rep.resetSync();
         }
         isPrimary = false;
         i104.disable_connect();
         I104M_CntDnToBePrimary =
             I104M_CntToBePrimary; // restart count to be primary
+        if (I104M_HotStandby && I104M_rep.needSync()) {
+          I104M_Loga("T<-- I104M: REPLICA SYNC REQUEST");
+          I104M_SendSpecial(I104M_SPECIAL_CMD_ADDR_REPLICA_SYNC);
+        }
+      } else if (pmsg->endereco == I104M_SPECIAL_CMD_ADDR_REPLICA_SYNC &&
+                 I104M_HotStandby && isPrimary) {
+        std::vector<pointcache_rec> recs;
+        i104.cachedRecords(recs);
+        I104M_Loga(QString("R--> I104M: REPLICA SYNC REQUEST, %1 POINTS").arg(recs.size()));
+        I104M_rep.sendDump(recs);
       }
       break;
-    case iec104_class::C_SC_TA_1: // single command with time tag
-    case iec104_class::C_SC_NA_1: // single command
-      sprintf(buf, "R--> I104M: Single Command %s", pmsg->onoff ? "on" : "off");
-      I104M_Loga(buf);
-      obj.sp = static_cast<unsigned char>(pmsg->onoff);
-      i104.sendCommand(&obj);
-      LastCommandAddress = obj.address;
-      break;
-    case iec104_class::C_DC_TA_1: // double command with time tag
-    case iec104_class::C_DC_NA_1: // double command
-      sprintf(buf, "R--> I104M: Double Command %s", pmsg->onoff ? "on" : "off");
-      I104M_Loga(buf);
-      obj.dp = pmsg->onoff ? 2 : 1;
-      i104.sendCommand(&obj);
-      LastCommandAddress = obj.address;
-      break;
-    case iec104_class::C_SE_TA_1: // set-point normalised command with time tag
-    case iec104_class::C_SE_NA_1: // set-point normalised command
-      sprintf(buf, "R--> I104M: set-point normalised command %f",
-              double(pmsg->setpoint));
-      I104M_Loga(buf);
-      obj.value = pmsg->setpoint;
-      i104.sendCommand(&obj);
-      LastCommandAddress = obj.address;
-      break;
-    case iec104_class::C_SE_TB_1: // set-point scaled command with time tag
-    case iec104_class::C_SE_NB_1: // set-point scaled command
-      sprintf(buf, "R--> I104M: set-point scaled command %f",
-              double(pmsg->setpoint));
-      I104M_Loga(buf);
-      obj.value = pmsg->setpoint;
-      i104.sendCommand(&obj);
-      LastCommandAddress = obj.address;
-      break;
-    case iec104_class::C_SE_TC_1: // set-point short floating point command with
-                                  // time tag
-    case iec104_class::C_SE_NC_1: // set-point short floating point command
-      sprintf(buf, "R--> I104M: set-point short floating command %f",
-              double(pmsg->setpoint));
-      I104M_Loga(buf);
-      obj.value = pmsg->setpoint;
-      i104.sendCommand(&obj);
-      LastCommandAddress = obj.address;
-      break;
-    case iec104_class::C_RC_TA_1: // regulating step command with time tag
-    case iec104_class::C_RC_NA_1: // regulating step command
-      sprintf(buf, "R--> I104M: regulating step command %s", pmsg->setpoint==0?"LOWER":"RAISE");
-      I104M_Loga(buf);
-      obj.rcs = pmsg->setpoint==0?1:2;
-      i104.sendCommand(&obj);
-      LastCommandAddress = obj.address;
-      break;
-    case iec104_class::C_BO_TA_1: // bitstring command with time tag
-    case iec104_class::C_BO_NA_1: // bitstring command
-      sprintf(buf, "R--> I104M: bitstring command %u", pmsg->setpoint_i32);
-      I104M_Loga(buf);
-      obj.value = pmsg->setpoint_i32;
-      i104.sendCommand(&obj);
-      LastCommandAddress = obj.address;
+    default:
+      if (I104MForwarder::commandToObj(pmsg, obj, buf)) {
+        I104M_Loga(buf);
+        i104.requestCommand(obj);
+      }
       break;
     }
   }
@@ -402,12 +499,12 @@ void MainWindow::on_pbSendCommandsButton_clicked() {
       }
 
   obj.ca = ui->leASDUAddr->text().toUShort();
-  i104.setSecondaryASDUAddress(obj.ca);
+  i104.requestSecondaryASDUAddress(obj.ca);
   QDateTime current = QDateTime::currentDateTime();
 
   switch (obj.type) {
   case iec104_class::C_IC_NA_1: // Interrogation
-    i104.solicitInterrogation(ui->leCmdValue->text().toInt());
+    i104.requestInterrogation(ui->leCmdValue->text().toInt());
     return;
   case iec104_class::C_SC_NA_1:
   case iec104_class::C_SC_TA_1:
@@ -504,303 +601,109 @@ void MainWindow::on_pbSendCommandsButton_clicked() {
       ui->cbCmdDuration->currentText().left(1).toUInt());
   obj.se = static_cast<unsigned char>(ui->cbSBO->isChecked());
 
-  i104.sendCommand(&obj);
-  LastCommandAddress = obj.address;
+  i104.requestCommand(obj);
 }
 
 void MainWindow::I104M_Loga(QString str, int id) {
   if (I104M_Logar && id == 0) {
-    i104.mLog.pushMsg(const_cast<char *>(str.toStdString().c_str()), 0);
+    i104.logMsg(str.toStdString().c_str());
   }
 }
 
 void MainWindow::slot_dataIndication(iec_obj *obj, unsigned numpoints) {
-  char buf[1500];
-  char buftt[1500];
-  int rw = -1;
-  bool inserted = false;
-  QTableWidgetItem *pitem;
-  static const char *dblmsg[] = {"tra ", "off ", "on ", "ind "};
-
-  I104M_processPoints(obj, numpoints);
-
-  if (ui->cbPointMap->isChecked()) {
-    for (unsigned i = 0; i < numpoints; i++, obj++) {
-      pitem = nullptr;
-      pitem = mapPtItem_ColAddress[std::make_pair(obj->ca, obj->address)];
-      if (pitem == nullptr) {
-        sprintf(buf, "%06u", obj->address);
-
-        // insere
-        rw = ui->twPontos->rowCount();
-        ui->twPontos->insertRow(rw);
-        QTableWidgetItem *newItem = new QTableWidgetItem(buf);
-        newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-        ui->twPontos->setItem(rw, 0, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColAddress[std::make_pair(obj->ca, obj->address)] = newItem;
-
-        newItem = new QTableWidgetItem();
-        newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-        ui->twPontos->setItem(rw, 1, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColCommonAddress[std::make_pair(obj->ca, obj->address)] =
-            newItem;
-
-        newItem = new QTableWidgetItem();
-        newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-        ui->twPontos->setItem(rw, 2, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColValue[std::make_pair(obj->ca, obj->address)] = newItem;
-
-        newItem = new QTableWidgetItem();
-        newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-        ui->twPontos->setItem(rw, 3, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColType[std::make_pair(obj->ca, obj->address)] = newItem;
-
-        newItem = new QTableWidgetItem();
-        newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-        ui->twPontos->setItem(rw, 4, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColCause[std::make_pair(obj->ca, obj->address)] = newItem;
-
-        newItem = new QTableWidgetItem();
-        newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-        ui->twPontos->setItem(rw, 5, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColFlags[std::make_pair(obj->ca, obj->address)] = newItem;
-
-        newItem = new QTableWidgetItem("0");
-        newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-        ui->twPontos->setItem(rw, 6, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColCount[std::make_pair(obj->ca, obj->address)] = newItem;
-
-        newItem = new QTableWidgetItem();
-        ui->twPontos->setItem(rw, 7, newItem);
-        newItem->setFlags(Qt::ItemIsSelectable);
-        mapPtItem_ColTimeTag[std::make_pair(obj->ca, obj->address)] = newItem;
-
-        inserted = true;
-      }
-
-      sprintf(buf, "%9.3f", double(obj->value));
-      mapPtItem_ColValue[std::make_pair(obj->ca, obj->address)]->setText(buf);
-      sprintf(buf, "%u", obj->ca);
-      mapPtItem_ColCommonAddress[std::make_pair(obj->ca, obj->address)]
-          ->setText(buf);
-      sprintf(buf, "%d:%s", obj->type, i104.asduTiStr(obj->type).c_str());
-      mapPtItem_ColType[std::make_pair(obj->ca, obj->address)]->setText(buf);
-      sprintf(buf, "%d:%s", obj->cause, i104.causeStr(obj->cause).c_str());
-      mapPtItem_ColCause[std::make_pair(obj->ca, obj->address)]->setText(buf);
-      sprintf(buf, "%d",
-              1 + mapPtItem_ColCount[std::make_pair(obj->ca, obj->address)]
-                      ->text()
-                      .toInt());
-      mapPtItem_ColCount[std::make_pair(obj->ca, obj->address)]->setText(buf);
-
-      QDateTime current = QDateTime::currentDateTime();
-      sprintf(
-          buftt, "Local: %s",
-          current.toString("yyyy/MM/dd hh:mm:ss.zzz").toStdString().c_str());
-
-      switch (obj->type) {
-      case iec104_class::M_EP_TD_1:
-        fmtCP56Time(buftt, &obj->timetag);
-        sprintf(buf, "%s%s%s%s%s%s %dms", dblmsg[obj->dp], obj->bl ? "bl " : "",
-                obj->nt ? "nt " : "", obj->sb ? "sb " : "",
-                obj->iv ? "iv " : "", obj->ei ? "ei " : "",
-                obj->elapsed_time.milliseconds);
-        break;
-      case iec104_class::M_EP_TE_1:
-        fmtCP56Time(buftt, &obj->timetag);
-        sprintf(buf, "%s%s%s%s%s%s%s%s%s%s%s %dms", obj->bl ? "bl " : "",
-                obj->nt ? "nt " : "", obj->sb ? "sb " : "",
-                obj->iv ? "iv " : "", obj->ei ? "ei " : "",
-                obj->spe.gs ? "gs " : "", obj->spe.sl1 ? "sl1 " : "",
-                obj->spe.sl2 ? "sl2 " : "", obj->spe.sl3 ? "sl3 " : "",
-                obj->spe.sie ? "sie " : "", obj->spe.srd ? "srd " : "",
-                obj->elapsed_time.milliseconds);
-        break;
-      case iec104_class::M_EP_TF_1:
-        fmtCP56Time(buftt, &obj->timetag);
-        sprintf(buf, "%s%s%s%s%s%s%s%s%s %dms", obj->bl ? "bl " : "",
-                obj->nt ? "nt " : "", obj->sb ? "sb " : "",
-                obj->iv ? "iv " : "", obj->ei ? "ei " : "",
-                obj->oci.gc ? "gc " : "", obj->oci.cl1 ? "cl1 " : "",
-                obj->oci.cl2 ? "cl2 " : "", obj->oci.cl3 ? "cl3 " : "",
-                obj->elapsed_time.milliseconds);
-        break;
-
-      case iec104_class::M_SP_TB_1: // 30
-        fmtCP56Time(buftt, &obj->timetag);
-        [[fallthrough]];
-      case iec104_class::M_SP_NA_1: // 1
-        sprintf(buf, "%s%s%s%s%s", obj->sp ? "on " : "off ",
-                obj->iv ? "iv " : "", obj->bl ? "bl " : "",
-                obj->sb ? "sb " : "", obj->nt ? "nt " : "");
-        break;
-      case iec104_class::M_DP_TB_1: // 31
-        fmtCP56Time(buftt, &obj->timetag);
-        [[fallthrough]];
-      case iec104_class::M_DP_NA_1: // 3
-        sprintf(buf, "%s%s%s%s%s", dblmsg[obj->dp], obj->iv ? "iv " : "",
-                obj->bl ? "bl " : "", obj->sb ? "sb " : "",
-                obj->nt ? "nt " : "");
-        break;
-      case iec104_class::M_ST_TB_1: // 32
-        fmtCP56Time(buftt, &obj->timetag);
-        [[fallthrough]];
-      case iec104_class::M_ST_NA_1: // 5
-        sprintf(buf, "%s%s%s%s%s%s", obj->ov ? "ov " : "", obj->iv ? "iv " : "",
-                obj->bl ? "bl " : "", obj->sb ? "sb " : "",
-                obj->nt ? "nt " : "", obj->t ? "t " : "");
-        break;
-
-      case iec104_class::M_IT_TB_1: // 37
-        fmtCP56Time(buftt, &obj->timetag);
-        [[fallthrough]];
-      case iec104_class::M_IT_NA_1: // 15
-        sprintf(buf, "%s%s%s%s%u", obj->iv ? "iv " : "", obj->cadj ? "ca " : "",
-                obj->cy ? "cy " : "", "sq=", obj->sq);
-        break;
-
-      case iec104_class::M_PS_NA_1: // 38
-        sprintf(buf,
-                "%s%s%s%s%s ST %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d CH %d%d%d%d "
-                "%d%d%d%d %d%d%d%d %d%d%d%d [1-16]",
-                obj->ov ? "ov " : "", obj->bl ? "bl " : "",
-                obj->nt ? "nt " : "", obj->sb ? "sb " : "",
-                obj->iv ? "iv " : "", obj->stcd.st1, obj->stcd.st2,
-                obj->stcd.st3, obj->stcd.st4, obj->stcd.st5, obj->stcd.st6,
-                obj->stcd.st7, obj->stcd.st8, obj->stcd.st9, obj->stcd.st10,
-                obj->stcd.st11, obj->stcd.st12, obj->stcd.st13, obj->stcd.st14,
-                obj->stcd.st15, obj->stcd.st16, obj->stcd.cd1, obj->stcd.cd2,
-                obj->stcd.cd3, obj->stcd.cd4, obj->stcd.cd5, obj->stcd.cd6,
-                obj->stcd.cd7, obj->stcd.cd8, obj->stcd.cd9, obj->stcd.cd10,
-                obj->stcd.cd11, obj->stcd.cd12, obj->stcd.cd13, obj->stcd.cd14,
-                obj->stcd.cd15, obj->stcd.cd16);
-        break;
-
-      case iec104_class::M_BO_TB_1: // 33
-        fmtCP56Time(buftt, &obj->timetag);
-        [[fallthrough]];
-      case iec104_class::M_BO_NA_1: // 7
-        sprintf(buf,
-                "%s%s%s%s%s ST %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d "
-                "%d%d%d% d%d%d%d %d%d%d%d [1-32]",
-                obj->ov ? "ov " : "", obj->bl ? "bl " : "",
-                obj->nt ? "nt " : "", obj->sb ? "sb " : "",
-                obj->iv ? "iv " : "", obj->bsi.st1, obj->bsi.st2, obj->bsi.st3,
-                obj->bsi.st4, obj->bsi.st5, obj->bsi.st6, obj->bsi.st7,
-                obj->bsi.st8, obj->bsi.st9, obj->bsi.st10, obj->bsi.st11,
-                obj->bsi.st12, obj->bsi.st13, obj->bsi.st14, obj->bsi.st15,
-                obj->bsi.st16, obj->bsi.st17, obj->bsi.st18, obj->bsi.st19,
-                obj->bsi.st20, obj->bsi.st21, obj->bsi.st22, obj->bsi.st23,
-                obj->bsi.st24, obj->bsi.st25, obj->bsi.st26, obj->bsi.st27,
-                obj->bsi.st28, obj->bsi.st29, obj->bsi.st31, obj->bsi.st32);
-        break;
-
-      case iec104_class::M_ME_TD_1: // 34
-      case iec104_class::M_ME_TE_1: // 35
-      case iec104_class::M_ME_TF_1: // 36
-        fmtCP56Time(buftt, &obj->timetag);
-        [[fallthrough]];
-      case iec104_class::M_ME_NA_1: // 9
-      case iec104_class::M_ME_NB_1: // 11
-      case iec104_class::M_ME_NC_1: // 13
-      case iec104_class::M_ME_ND_1: // 21
-        sprintf(buf, "%s%s%s%s%s", obj->ov ? "ov " : "", obj->iv ? "iv " : "",
-                obj->bl ? "bl " : "", obj->sb ? "sb " : "",
-                obj->nt ? "nt " : "");
-        break;
-      }
-
-      mapPtItem_ColFlags[std::make_pair(obj->ca, obj->address)]->setText(buf);
-      mapPtItem_ColTimeTag[std::make_pair(obj->ca, obj->address)]->setText(
-          buftt);
-    }
+  if (!I104M_fwd.sendPoints(obj, numpoints, unsigned(i104.getPrimaryAddress())))
+    i104.logMsg("R--> IEC104 UNSUPPORTED TYPE, NOT FORWARDED TO I104M/OSHMI");
 
-    if (inserted)
-      ui->twPontos->sortItems(0);
-  }
+  if (ui->cbPointMap->isChecked())
+    mPoints->update(obj, numpoints);
 }
 
 void MainWindow::slot_timer_logmsg() {
   static int count = 0;
-  static int rowant = 0;
-  static const int logBufSize = 30000;
-  static int cntLogMsgs = 0; // index for circular buffer of log messages
+  static std::string msg;
 
   if (Hide)
     if (this->isVisible())
       this->setVisible(false);
 
-  // adjust size of rows and columns
-  if (!(++count % 15))
-    if (rowant < ui->twPontos->rowCount()) {
-      rowant = ui->twPontos->rowCount();
-      ui->twPontos->resizeRowsToContents();
-      ui->twPontos->resizeColumnsToContents();
-    }
-
-  // if ( !i104.mLog.haveMsg() && i104.tmKeepAlive->isActive() )
-  //  i104.mLog.pushMsg( "." );
+  // I104M forwarding statistics, every minute
+  if (!(++count % 120) && I104M_fwd.datagrams() > 0)
+    I104M_Loga(I104M_fwd.statsText());
 
   if (i104.mLog.haveMsg()) {
-    // if (ui->lwLog->count() > logBufSize )
-    //{
-    //     ui->lwLog->clear();
-    //     ui->lwLog->addItem( "*** Message list auto cleaned!" );
-    // }
-
-    while (i104.mLog.haveMsg()) {
-      if (ui->lwLog->count() < logBufSize) {
-        // buffer not filled: create new lines
-        ui->lwLog->addItem(i104.mLog.pullMsg().c_str());
-      } else {
-        // buffer filled: rewrite lines
-        ui->lwLog->item(cntLogMsgs % logBufSize)
-            ->setText(i104.mLog.pullMsg().c_str());
-        // Marks end of circular buffer
-        ui->lwLog->item((cntLogMsgs + 1) % logBufSize)
-            ->setText("=================================================");
-        ui->lwLog->item((cntLogMsgs + 1) % logBufSize)
-            ->setForeground(Qt::green);
-        ui->lwLog->item((cntLogMsgs + 1) % logBufSize)
-            ->setBackground(Qt::yellow);
-      }
+    // drain all the messages, the view is told once
+    while (i104.mLog.pullMsg(msg))
+      mLogLines->append(msg);
+    mLogLines->commitLines();
 
-      if (ui->lwLog->item(cntLogMsgs % logBufSize)->text().indexOf("I104M") >=
-          0) {
-        ui->lwLog->item(cntLogMsgs % logBufSize)->setForeground(Qt::lightGray);
-        ui->lwLog->item(cntLogMsgs % logBufSize)
-            ->setBackground(Qt::transparent);
-      } else if (ui->lwLog->item(cntLogMsgs % logBufSize)
-                     ->text()
-                     .indexOf("COMMAND") >= 0) {
-        ui->lwLog->item(cntLogMsgs % logBufSize)->setForeground(Qt::black);
-        ui->lwLog->item(cntLogMsgs % logBufSize)->setBackground(Qt::lightGray);
-      } else if (ui->lwLog->item(cntLogMsgs % logBufSize)
-                     ->text()
-                     .indexOf("[") >= 0) {
-        ui->lwLog->item(cntLogMsgs % logBufSize)->setForeground(Qt::red);
-        ui->lwLog->item(cntLogMsgs % logBufSize)
-            ->setBackground(Qt::transparent);
-      } else {
-        ui->lwLog->item(cntLogMsgs % logBufSize)->setForeground(Qt::black);
-        ui->lwLog->item(cntLogMsgs % logBufSize)
-            ->setBackground(Qt::transparent);
-      }
-      cntLogMsgs++;
-    }
+    if (ui->cbAutoScroll->isChecked())
+      ui->lwLog->scrollToBottom();
+  }
+}
 
-    if (ui->cbAutoScroll->isChecked()) {
-      ui->lwLog->scrollToItem(ui->lwLog->item((cntLogMsgs - 1) % logBufSize),
-                              QAbstractItemView::PositionAtBottom);
-    }
+void MainWindow::slot_dataBatch(QVector<iec_obj> objs,
+                                QVector<unsigned> sizes) {
+  int off = 0;
+  for (unsigned n : sizes) {
+    slot_dataIndication(objs.data() + off, n);
+    off += int(n);
+  }
+}
+
+// hot standby: the changes of the cache (unfiltered) to the secondary
+void MainWindow::slot_cacheIndication(iec_obj *obj, unsigned numpoints) {
+  if (isPrimary && I104M_HaveDualHost())
+    I104M_rep.sendPoints(obj, numpoints);
+}
+
+void MainWindow::slot_cacheBatch(QVector<iec_obj> objs) {
+  slot_cacheIndication(objs.data(), unsigned(objs.size()));
+}
+
+// last values of the point cache to the table, and to I104M
+void MainWindow::showCachedPoints(bool forward) {
+  QVector<iec_obj> objs;
+  QVector<unsigned> sizes;
+  i104.cachedPoints(objs, sizes);
+  const iec_obj *obj = objs.constData();
+  for (unsigned n : sizes) {
+    if (forward)
+      I104M_fwd.sendPoints(obj, n, unsigned(i104.getPrimaryAddress()));
+    if (ui->cbPointMap->isChecked())
+      mPoints->update(obj, n);
+    obj += n;
   }
+  if (!objs.isEmpty())
+    i104.logMsg(QString("CACHE: %1 POINTS").arg(objs.size()).toLatin1().constData());
+}
+
+void MainWindow::slot_commandActResp(iec_obj obj) {
+  slot_commandActRespIndication(&obj);
+}
+
+// repaint the visible points that changed, new points are inserted in the view
+void MainWindow::slot_timer_refresh() {
+  static int count = 0;
+  static int rowant = 0;
+
+  mPoints->commitRows();
+  if (!ui->twPontos->isVisible())
+    return;
+
+  int top = ui->twPontos->rowAt(0);
+  int bottom = ui->twPontos->rowAt(ui->twPontos->viewport()->height() - 1);
+  if (bottom < 0)
+    bottom = mPointsSort->rowCount() - 1;
+  for (int r = top; r >= 0 && r <= bottom; r++)
+    mPoints->refreshRow(
+        mPointsSort->mapToSource(mPointsSort->index(r, 0)).row());
+
+  // adjust columns to the contents of the visible rows, each second when rows were added
+  if (!(++count % RefreshHz))
+    if (rowant < mPoints->rowCount()) {
+      rowant = mPoints->rowCount();
+      ui->twPontos->resizeColumnsToContents();
+    }
 }
 
 void MainWindow::slot_interrogationActConfIndication() {}
@@ -808,7 +711,7 @@ void MainWindow::slot_interrogationActConfIndication() {}
 void MainWindow::slot_interrogationActTermIndication() {}
 
 void MainWindow::slot_tcpconnect() {
-  ui->leIPRemoto->setText(i104.tcps->peerAddress().toString());
+  ui->leIPRemoto->setText(i104.peerAddress());
   ui->lbStatus->setText("<font color='green'> TCP CONNECTED!</font>");
   ui->pbGI->setEnabled(true);
   ui->pbSendCommandsButton->setEnabled(true);
@@ -822,6 +725,7 @@ void MainWindow::slot_tcpdisconnect() {
                                   // to allow for the secondary to assume
     isPrimary = false;
     i104.disable_connect();
+    I104M_rep.resetSync();
     I104M_Loga(" --- I104M: BECOMING SECONDARY BY DISCONNECTION");
     ui->lbMode->setText("<font color='red'>Secondary</font>");
   }
@@ -830,7 +734,7 @@ void MainWindow::slot_tcpdisconnect() {
   ui->pbGI->setEnabled(false);
   ui->pbSendCommandsButton->setEnabled(false);
 
-  if (i104.tmKeepAlive->isActive()) {
+  if (i104.isLinkActive()) {
     ui->pbConnect->setText("Give up");
     ui->lePort->setEnabled(false);
     ui->leIPRemoto->setEnabled(false);
@@ -847,252 +751,30 @@ void MainWindow::slot_tcpdisconnect() {
 
 void MainWindow::slot_commandActRespIndication(iec_obj *obj) {
 
-  char buf[1000];
-  char buftt[1000];
-  int rw = -1;
-  QTableWidgetItem *pitem;
-  static const char *pnmsg[] = {"pos ", "neg "};
-  static const char *selmsg[] = {"exe ", "sel "};
-  static const char *sglmsg[] = {"off ", "on "};
-  static const char *dblmsg[] = {"tra ", "off ", "on ", "ind "};
-  static const char *qumsg[] = {"uns ", "shp ", "lop ", "per ", "res "};
-  static const char *rcsmsg[] = {"na0 ", "dec ", "inc ", "na3 "};
-  static const char *kpamsg[] = {"unu ", "thr ", "fil ",
-                                 "lli ", "hli ", "res "};
-  // static const char* qpamsg[] = { "unu ", "gen ", "obj ", "trm ", "res " };
-
   if (obj->address == 0)
     return;
 
-  if (ui->cbPointMap->isChecked()) {
-    pitem = nullptr;
-    pitem = mapPtItem_ColAddress[std::make_pair(obj->ca, obj->address)];
-    if (pitem == nullptr) {
-      sprintf(buf, "%06u", obj->address);
-
-      // insere
-      rw = ui->twPontos->rowCount();
-      ui->twPontos->insertRow(rw);
-      QTableWidgetItem *newItem = new QTableWidgetItem(buf);
-      newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-      ui->twPontos->setItem(rw, 0, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColAddress[std::make_pair(obj->ca, obj->address)] = newItem;
-
-      newItem = new QTableWidgetItem();
-      newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-      ui->twPontos->setItem(rw, 1, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColCommonAddress[std::make_pair(obj->ca, obj->address)] =
-          newItem;
-
-      newItem = new QTableWidgetItem();
-      newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-      ui->twPontos->setItem(rw, 2, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColValue[std::make_pair(obj->ca, obj->address)] = newItem;
-
-      newItem = new QTableWidgetItem();
-      newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-      ui->twPontos->setItem(rw, 3, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColType[std::make_pair(obj->ca, obj->address)] = newItem;
-
-      newItem = new QTableWidgetItem();
-      newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-      ui->twPontos->setItem(rw, 4, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColCause[std::make_pair(obj->ca, obj->address)] = newItem;
-
-      newItem = new QTableWidgetItem();
-      newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-      ui->twPontos->setItem(rw, 5, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColFlags[std::make_pair(obj->ca, obj->address)] = newItem;
-
-      newItem = new QTableWidgetItem("0");
-      newItem->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
-      ui->twPontos->setItem(rw, 6, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColCount[std::make_pair(obj->ca, obj->address)] = newItem;
-
-      newItem = new QTableWidgetItem();
-      ui->twPontos->setItem(rw, 7, newItem);
-      newItem->setFlags(Qt::ItemIsSelectable);
-      mapPtItem_ColTimeTag[std::make_pair(obj->ca, obj->address)] = newItem;
-    }
+  if (ui->cbPointMap->isChecked())
+    mPoints->update(obj, 1);
 
-    sprintf(buf, "%9.3f", double(obj->value));
-    mapPtItem_ColValue[std::make_pair(obj->ca, obj->address)]->setText(buf);
-    sprintf(buf, "%u", obj->ca);
-    mapPtItem_ColCommonAddress[std::make_pair(obj->ca, obj->address)]->setText(
-        buf);
-    sprintf(buf, "%d", obj->type);
-    mapPtItem_ColType[std::make_pair(obj->ca, obj->address)]->setText(buf);
-    sprintf(buf, "%d", obj->cause);
-    mapPtItem_ColCause[std::make_pair(obj->ca, obj->address)]->setText(buf);
-    sprintf(buf, "%d",
-            1 + mapPtItem_ColCount[std::make_pair(obj->ca, obj->address)]
-                    ->text()
-                    .toInt());
-    mapPtItem_ColCount[std::make_pair(obj->ca, obj->address)]->setText(buf);
-
-    QDateTime current = QDateTime::currentDateTime();
-    sprintf(buftt, "Local: %s",
-            current.toString("yyyy/MM/dd hh:mm:ss.zzz").toStdString().c_str());
-    switch (obj->type) {
-    case iec104_class::C_SC_TA_1:
-      fmtCP56Time(buftt, &obj->timetag);
-      [[fallthrough]];
-    case iec104_class::C_SC_NA_1:
-      sprintf(buf, "%d", int(obj->scs));
-      mapPtItem_ColValue[std::make_pair(obj->ca, obj->address)]->setText(buf);
-      sprintf(buf, "%s%s%s%s", pnmsg[obj->pn], sglmsg[obj->scs],
-              selmsg[obj->se], qumsg[obj->qu]);
-      break;
-    case iec104_class::C_DC_TA_1:
-      fmtCP56Time(buftt, &obj->timetag);
-      [[fallthrough]];
-    case iec104_class::C_DC_NA_1:
-      sprintf(buf, "%d", int(obj->dcs));
-      mapPtItem_ColValue[std::make_pair(obj->ca, obj->address)]->setText(buf);
-      sprintf(buf, "%s%s%s%s", pnmsg[obj->pn], dblmsg[obj->dcs],
-              selmsg[obj->se], qumsg[obj->qu]);
-      break;
-    case iec104_class::C_RC_TA_1:
-      fmtCP56Time(buftt, &obj->timetag);
-      [[fallthrough]];
-    case iec104_class::C_RC_NA_1:
-      sprintf(buf, "%d", int(obj->rcs));
-      mapPtItem_ColValue[std::make_pair(obj->ca, obj->address)]->setText(buf);
-      sprintf(buf, "%s%s%s", pnmsg[obj->pn], rcsmsg[obj->rcs], selmsg[obj->se]);
-      break;
-    case iec104_class::C_SE_TA_1:
-      fmtCP56Time(buftt, &obj->timetag);
-      [[fallthrough]];
-    case iec104_class::C_SE_NA_1:
-      sprintf(buf, "%s%s", pnmsg[obj->pn], selmsg[obj->se]);
-      break;
-    case iec104_class::C_SE_TB_1:
-      fmtCP56Time(buftt, &obj->timetag);
-      [[fallthrough]];
-    case iec104_class::C_SE_NB_1:
-      sprintf(buf, "%s%s", pnmsg[obj->pn], selmsg[obj->se]);
-      break;
-    case iec104_class::C_SE_TC_1:
-      fmtCP56Time(buftt, &obj->timetag);
-      [[fallthrough]];
-    case iec104_class::C_SE_NC_1:
-      sprintf(buf, "%s%s", pnmsg[obj->pn], selmsg[obj->se]);
-      break;
-    case iec104_class::C_BO_TA_1:
-      fmtCP56Time(buftt, &obj->timetag);
-      [[fallthrough]];
-    case iec104_class::C_BO_NA_1:
-      sprintf(buf, "%s", pnmsg[obj->pn]);
-      break;
-    case iec104_class::P_ME_NA_1:
-      [[fallthrough]];
-    case iec104_class::P_ME_NB_1:
-      [[fallthrough]];
-    case iec104_class::P_ME_NC_1:
-      sprintf(buf, "%s%s%s%s", pnmsg[obj->pn], kpamsg[obj->kpa],
-              obj->lpc ? "lpc " : "", obj->pop ? "pop " : "");
-      break;
-    case iec104_class::P_AC_NA_1:
-      sprintf(buf, "%s%s", pnmsg[obj->pn], kpamsg[obj->qpa]);
-      break;
+  if (obj->cause != iec104_class::REQUEST &&
+      obj->cause != iec104_class::ACTIVATION &&
+      obj->cause != iec104_class::ACTCONFIRM)
+    return;
+  i104.logMsg("     COMMAND CONF INDICATION");
+  bool is_select = (obj->se == iec104_class::SELECT);
+
+  // a confirmed select was executed by the protocol (SBO_EXECUTE), respond to
+  // I104M only if it's not a select or if its a negative response
+  if (is_select == false || obj->pn == iec104_class::NEGATIVE ||
+      !i104.getSBOExecute()) {
+    if (obj->pn == iec104_class::NEGATIVE) {
+      I104M_Loga("T<-- I104M: COMMAND REJECTED BY IEC104 SLAVE");
+    } else {
+      I104M_Loga("T<-- I104M: COMMAND ACCEPTED BY IEC104 SLAVE");
     }
-
-    mapPtItem_ColFlags[std::make_pair(obj->ca, obj->address)]->setText(buf);
-    mapPtItem_ColTimeTag[std::make_pair(obj->ca, obj->address)]->setText(buftt);
+    I104M_fwd.sendCommandResp(obj, unsigned(i104.getPrimaryAddress()));
   }
-
-  bool is_select = false;
-
-  if (obj->cause == iec104_class::REQUEST ||
-      obj->cause == iec104_class::ACTIVATION ||
-      obj->cause == iec104_class::ACTCONFIRM)
-    if (LastCommandAddress == obj->address) {
-      i104.mLog.pushMsg("     COMMAND CONF INDICATION");
-      is_select = (obj->se == iec104_class::SELECT);
-
-      // if confirmed select, execute
-      if (is_select && obj->pn == iec104_class::POSITIVE) {
-        // if defined ASDU address on UI, use it
-        // else will set to zero and use slave address (send Command will
-        // substitute zero to slave address)
-        obj->ca = ui->leASDUAddr->text().toUShort();
-        obj->se = iec104_class::EXECUTE;
-        i104.sendCommand(obj);
-      }
-
-      // respond to I104M only if it's not a select or if its a negative
-      // response
-      if (is_select == false || obj->pn == iec104_class::NEGATIVE) {
-        t_msgsup I104M_msg;
-        I104M_msg.signature = MSGSUP_SIG;
-        I104M_msg.tipo = obj->type;
-        I104M_msg.endereco = obj->address;
-        I104M_msg.sec = obj->ca;
-        I104M_msg.prim = unsigned(i104.getPrimaryAddress());
-        // mask cause, and p/n result to bit 6 1=NEG 0=POS
-        I104M_msg.causa = unsigned(
-            obj->cause | (((obj->pn == iec104_class::NEGATIVE) ? 1 : 0) << 6));
-
-        switch (obj->type) {
-        case iec104_class::C_SC_NA_1:
-        case iec104_class::C_SC_TA_1:
-          I104M_msg.taminfo = 1;
-          I104M_msg.info[0] = obj->scs;
-          break;
-        case iec104_class::C_DC_NA_1:
-        case iec104_class::C_DC_TA_1:
-          I104M_msg.taminfo = 1;
-          I104M_msg.info[0] = obj->dcs;
-          break;
-        case iec104_class::C_RC_NA_1:
-        case iec104_class::C_RC_TA_1:
-          I104M_msg.taminfo = 1;
-          I104M_msg.info[0] = obj->rcs;
-          break;
-        case iec104_class::C_SE_NA_1:
-        case iec104_class::C_SE_TA_1:
-          I104M_msg.taminfo = 4;
-          *(reinterpret_cast<float *>(&I104M_msg.info)) = obj->value;
-          break;
-
-        case iec104_class::C_SE_NB_1:
-        case iec104_class::C_SE_TB_1:
-          I104M_msg.taminfo = 4;
-          *(reinterpret_cast<float *>(&I104M_msg.info)) = obj->value;
-          break;
-
-        case iec104_class::C_SE_NC_1:
-        case iec104_class::C_SE_TC_1:
-          I104M_msg.taminfo = 4;
-          *(reinterpret_cast<float *>(&I104M_msg.info)) = obj->value;
-          break;
-
-        case iec104_class::C_BO_NA_1:
-        case iec104_class::C_BO_TA_1:
-          I104M_msg.taminfo = 4;
-          *(reinterpret_cast<uint32_t *>(&I104M_msg.info)) =
-              uint32_t(obj->value);
-          break;
-        }
-        if (obj->pn == iec104_class::NEGATIVE) {
-          I104M_Loga("T<-- I104M: COMMAND REJECTED BY IEC104 SLAVE");
-        } else {
-          I104M_Loga("T<-- I104M: COMMAND ACCEPTED BY IEC104 SLAVE");
-        }
-        udps->writeDatagram(reinterpret_cast<char *>(&I104M_msg),
-                            sizeof(I104M_msg), I104M_host, I104M_porta);
-        if (I104M_HaveDualHost())
-          udps->writeDatagram(reinterpret_cast<char *>(&I104M_msg),
-                              sizeof(I104M_msg), I104M_host_dual, I104M_porta);
-      }
-    }
 }
 
 void MainWindow::closeEvent(QCloseEvent *event) {
@@ -1105,27 +787,32 @@ void MainWindow::slot_timer_I104M_kamsg() {
     if (I104M_CntDnToBePrimary <= 0) {
       isPrimary = true;
       i104.enable_connect();
-      i104.tmKeepAlive->start();
+      i104.startLink();
       I104M_CntDnToBePrimary = I104M_CntToBePrimary;
       I104M_Loga(" --- I104M: BECOMING PRIMARY BY TIMEOUT");
+      if (I104M_HotStandby)
+        I104M_Loga(QString("     I104M: HOT STANDBY, %1 POINTS REPLICATED").arg(I104M_rep.records()));
       ui->lbMode->setText("<font color='green'>Primary</font>");
     } else
       I104M_CntDnToBePrimary--;
   }
 
-  if (isPrimary) {
+  if (isPrimary)
     // send keepalive message to the dual host
-    t_msgcmd i104M_msg;
-    i104M_msg.signature = MSGCMD_SIG;
-    i104M_msg.tipo = I104M_ASDU_SPECIAL_CMD;
-    i104M_msg.endereco = I104M_SPECIAL_CMD_ADDR_KEEP_ALIVE;
-    i104M_msg.setpoint_i32 = 0;
-    i104M_msg.sbo = 0;
-    i104M_msg.qu = 0;
-    i104M_msg.utr = 0;
-    udps->writeDatagram(reinterpret_cast<char *>(&i104M_msg), sizeof(i104M_msg),
-                        I104M_host_dual, I104M_porta_escuta);
-  }
+    I104M_SendSpecial(I104M_SPECIAL_CMD_ADDR_KEEP_ALIVE);
+}
+
+void MainWindow::I104M_SendSpecial(uint32_t addr) {
+  t_msgcmd i104M_msg;
+  i104M_msg.signature = MSGCMD_SIG;
+  i104M_msg.tipo = I104M_ASDU_SPECIAL_CMD;
+  i104M_msg.endereco = addr;
+  i104M_msg.setpoint_i32 = 0;
+  i104M_msg.sbo = 0;
+  i104M_msg.qu = 0;
+  i104M_msg.utr = 0;
+  udps->writeDatagram(reinterpret_cast<char *>(&i104M_msg), sizeof(i104M_msg),
+                      I104M_host_dual, I104M_porta_escuta);
 }
 
 void MainWindow::on_cbLog_clicked() {
@@ -1133,26 +820,32 @@ void MainWindow::on_cbLog_clicked() {
     i104.mLog.activateLog();
     QDate dt = QDate::currentDate();
     QString str = dt.toString() + QString(" - ") + QString(QTESTER_VERSION);
-    i104.mLog.pushMsg(str.toStdString().c_str());
+    i104.logMsg(str.toStdString().c_str());
   } else
     i104.mLog.deactivateLog();
 }
 
 void MainWindow::on_pbCopyClipb_clicked() {
-  int itemsCount = ui->lwLog->count();
+  int itemsCount = mLogLines->rowCount();
   QStringList strings;
   for (int i = 0; i < itemsCount; ++i)
-    strings << ui->lwLog->item(i)->text();
+    strings << mLogLines->lineText(i);
 
   QApplication::clipboard()->setText(strings.join("\n"));
 }
 
+void MainWindow::on_leLogFilter_textChanged(const QString &text) {
+  mLogLines->setFilter(text);
+  if (ui->cbAutoScroll->isChecked())
+    ui->lwLog->scrollToBottom();
+}
+
 void MainWindow::on_pbCopyVals_clicked() {
   QString text = "Address\tCA\tValue\tASDU\tCause\tFlags\tCount\tTimeTag\n";
 
-  for (int i = 0; i < ui->twPontos->rowCount(); i++) {
-    for (int j = 0; j < 8; j++) {
-      text = text + ui->twPontos->item(i, j)->text() + "\t";
+  for (int i = 0; i < mPointsSort->rowCount(); i++) {
+    for (int j = 0; j < PointsModel::ColumnCount; j++) {
+      text = text + mPointsSort->index(i, j).data().toString() + "\t";
     }
     text = text + "\n";
   }
@@ -1160,322 +853,91 @@ void MainWindow::on_pbCopyVals_clicked() {
   QApplication::clipboard()->setText(text);
 }
 
-void MainWindow::I104M_processPoints(iec_obj *obj, unsigned numpoints) {
-  t_msgsupsq msg;
-
-  switch (obj->type) {
-  case iec104_class::M_DP_TB_1: { // double state with time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = obj->type;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(digital_w_time7_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(digital_w_time7_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      digital_w_time7_seq *i104mobj =
-          reinterpret_cast<digital_w_time7_seq *>(paddr + 1);
-      i104mobj->iq =
-          static_cast<unsigned char>(obj->dp | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-      i104mobj->ano = obj->timetag.year;
-      i104mobj->mes = obj->timetag.month;
-      i104mobj->dia = obj->timetag.mday;
-      i104mobj->hora = obj->timetag.hour;
-      i104mobj->min = obj->timetag.min;
-      i104mobj->ms = obj->timetag.msec;
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints *
-                      (sizeof(int32_t) + sizeof(digital_w_time7_seq)));
-  } break;
-  case iec104_class::M_SP_TB_1: { // single state with time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = obj->type;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(digital_w_time7_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(digital_w_time7_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      digital_w_time7_seq *i104mobj =
-          reinterpret_cast<digital_w_time7_seq *>(paddr + 1);
-      i104mobj->iq =
-          static_cast<unsigned char>(obj->sp | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-      i104mobj->ano = obj->timetag.year;
-      i104mobj->mes = obj->timetag.month;
-      i104mobj->dia = obj->timetag.mday;
-      i104mobj->hora = obj->timetag.hour;
-      i104mobj->min = obj->timetag.min;
-      i104mobj->ms = obj->timetag.msec;
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints *
-                      (sizeof(int32_t) + sizeof(digital_w_time7_seq)));
-  } break;
-  case iec104_class::M_DP_NA_1: { // double state without time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = obj->type;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(digital_notime_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(digital_notime_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      digital_notime_seq *i104mobj =
-          reinterpret_cast<digital_notime_seq *>(paddr + 1);
-      i104mobj->iq =
-          static_cast<unsigned char>(obj->dp | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints *
-                      (sizeof(int32_t) + sizeof(digital_notime_seq)));
-  } break;
-  case iec104_class::M_SP_NA_1: { // single state without time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = obj->type;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(digital_notime_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int) + sizeof(digital_notime_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      digital_notime_seq *i104mobj =
-          reinterpret_cast<digital_notime_seq *>(paddr + 1);
-      i104mobj->iq =
-          static_cast<unsigned char>(obj->sp | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints *
-                      (sizeof(int32_t) + sizeof(digital_notime_seq)));
-  } break;
-
-  case iec104_class::M_ST_TB_1:   // 32 = step with time tag (will ignore time)
-  case iec104_class::M_ST_NA_1: { // 5 = step without time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = iec104_class::M_ST_NA_1;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(step_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(step_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      step_seq *i104mobj = reinterpret_cast<step_seq *>(paddr + 1);
-      i104mobj->qds =
-          static_cast<unsigned char>(obj->ov | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-      i104mobj->vti = static_cast<unsigned char>(obj->value) |
-                      static_cast<unsigned char>(obj->t << 7);
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints * (sizeof(int32_t) + sizeof(step_seq)));
-  } break;
-
-  case iec104_class::M_ME_TD_1:   // 34 = normalized with time tag
-  case iec104_class::M_ME_NA_1: { // 9 = normalized without time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = iec104_class::M_ME_NA_1;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(analogico_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(analogico_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      analogico_seq *i104mobj = reinterpret_cast<analogico_seq *>(paddr + 1);
-      i104mobj->qds =
-          static_cast<unsigned char>(obj->ov | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-      i104mobj->sva = static_cast<short>(obj->value);
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints * (sizeof(int32_t) + sizeof(analogico_seq)));
-  } break;
-
-  case iec104_class::M_ME_TE_1:   // 35 = scaled with time tag
-  case iec104_class::M_ME_NB_1: { // 11 = scaled without time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = iec104_class::M_ME_NB_1;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(analogico_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(analogico_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      analogico_seq *i104mobj = reinterpret_cast<analogico_seq *>(paddr + 1);
-      i104mobj->qds =
-          static_cast<unsigned char>(obj->ov | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-      i104mobj->sva = static_cast<short>(obj->value);
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints * (sizeof(int32_t) + sizeof(analogico_seq)));
-  } break;
-
-  case iec104_class::M_ME_TF_1:   // 36 = float with time tag
-  case iec104_class::M_ME_NC_1: { // 13 = float without time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = iec104_class::M_ME_NC_1;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(flutuante_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(flutuante_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      flutuante_seq *i104mobj = reinterpret_cast<flutuante_seq *>(paddr + 1);
-      i104mobj->qds =
-          static_cast<unsigned char>(obj->ov | (obj->bl << 4) | (obj->sb << 5) |
-                                     (obj->nt << 6) | (obj->iv << 7));
-      i104mobj->fr = obj->value;
-    }
-
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints * (sizeof(int32_t) + sizeof(flutuante_seq)));
-  } break;
-
-  case iec104_class::M_IT_TB_1:   // 37 = integrated totals with time tag
-  case iec104_class::M_IT_NA_1: { // 15 = integrated totals without time tag
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = iec104_class::M_IT_NA_1;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(integrated_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(integrated_seq)));
-      *paddr = obj->address;
-
-      // value and qualifier
-      integrated_seq *i104mobj = reinterpret_cast<integrated_seq *>(paddr + 1);
-      // map carry to overflow
-      i104mobj->qds = static_cast<unsigned char>(
-          (obj->cy << 7) | (obj->cadj << 6) | (obj->iv << 7));
-      i104mobj->bcr = obj->bcr;
-    }
+// events of a time window (of a point, when given) as tab separated text
+void MainWindow::on_pbSOE_clicked() {
+  QDialog dlg(this);
+  dlg.setWindowTitle(tr("SOE History"));
+  QFormLayout *form = new QFormLayout(&dlg);
+  QDateTime now = QDateTime::currentDateTime();
+  QDateTimeEdit *from = new QDateTimeEdit(now.addSecs(-3600), &dlg);
+  QDateTimeEdit *to = new QDateTimeEdit(now, &dlg);
+  from->setDisplayFormat("yyyy-MM-dd hh:mm:ss.zzz");
+  to->setDisplayFormat("yyyy-MM-dd hh:mm:ss.zzz");
+  QLineEdit *ca = new QLineEdit(&dlg);
+  QLineEdit *address = new QLineEdit(&dlg);
+  ca->setPlaceholderText(tr("all"));
+  address->setPlaceholderText(tr("all"));
+  form->addRow(tr("From"), from);
+  form->addRow(tr("To"), to);
+  form->addRow(tr("CA"), ca);
+  form->addRow(tr("Address"), address);
+  QDialogButtonBox *buttons =
+      new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel, &dlg);
+  form->addRow(buttons);
+  connect(buttons, &QDialogButtonBox::accepted, &dlg, &QDialog::accept);
+  connect(buttons, &QDialogButtonBox::rejected, &dlg, &QDialog::reject);
+  if (dlg.exec() != QDialog::Accepted)
+    return;
 
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints * (sizeof(int32_t) + sizeof(integrated_seq)));
-  } break;
-  case iec104_class::M_BO_TB_1: // 33 = bitstring of 32 bits with time tag (will
-                                // send as counter)
-  case iec104_class::M_BO_NA_1: { // 7 = bitstring of 32 bits (will send as
-                                  // counter)
-    // note: bitstring could also possibly be interpreted as 32 single binary
-    // states in sequence I opt to use counter to avoid possible address
-    // conflict for bitstrings in sequence of addresses
-    msg.signature = MSGSUPSQ_SIG;
-    msg.tipo = iec104_class::M_IT_NA_1;
-    msg.prim = static_cast<uint32_t>(i104.getPrimaryAddress());
-    msg.sec = obj->ca;
-    msg.causa = obj->cause;
-    msg.taminfo = sizeof(integrated_seq);
-    msg.numpoints = static_cast<uint32_t>(numpoints);
-
-    for (unsigned count = 0; count < numpoints; count++, obj++) {
-      uint32_t *paddr = reinterpret_cast<uint32_t *>(
-          msg.info + count * (sizeof(int32_t) + sizeof(integrated_seq)));
-      *paddr = obj->address;
-
-      // value as counter and no qualifier
-      integrated_seq *i104mobj = reinterpret_cast<integrated_seq *>(paddr + 1);
-      i104mobj->qds = 0;
-      i104mobj->bcr = obj->bsi.bsi;
-    }
+  // one point needs both, ca defaults to the slave address
+  int qca = -1;
+  int64_t qaddress = -1;
+  if (address->text() != "") {
+    qaddress = address->text().toLongLong();
+    qca = ca->text() != "" ? ca->text().toInt() : i104.getSecondaryAddress();
+  }
 
-    SendOSHMI(reinterpret_cast<char *>(&msg),
-              sizeof(int32_t) * 7 +
-                  msg.numpoints * (sizeof(int32_t) + sizeof(integrated_seq)));
-  } break;
-  default:
-    i104.mLog.pushMsg(
-        "R--> IEC104 UNSUPPORTED TYPE, NOT FORWARDED TO I104M/OSHMI");
-    break;
+  QElapsedTimer et;
+  et.start();
+  i104.flushSOE();
+  std::vector<soe_event> events;
+  iec104_soe_reader(mSOEDir.toStdString())
+      .query(from->dateTime().toMSecsSinceEpoch(), to->dateTime().toMSecsSinceEpoch(), qca,
+             qaddress, events);
+  qint64 ms = et.elapsed();
+
+  QString text = "Time\tArrival\tCA\tAddress\tASDU\tValue\tFlags\n";
+  for (const soe_event &e : events) {
+    QString flags;
+    if (e.flags & SOE_IV)
+      flags += "iv ";
+    if (e.flags & SOE_NT)
+      flags += "nt ";
+    if (e.flags & SOE_SB)
+      flags += "sb ";
+    if (e.flags & SOE_BL)
+      flags += "bl ";
+    if (e.flags & SOE_OV)
+      flags += "ov ";
+    if (e.flags & SOE_T)
+      flags += "t ";
+    if (e.flags & SOE_CY)
+      flags += "cy ";
+    if (e.flags & SOE_EI)
+      flags += "ei ";
+    if (e.flags & SOE_TIME_IV)
+      flags += "time.iv ";
+    text += QDateTime::fromMSecsSinceEpoch(e.time_ms).toString("yyyy-MM-dd hh:mm:ss.zzz") +
+            "\t" +
+            QDateTime::fromMSecsSinceEpoch(e.arrival_us / 1000).toString("yyyy-MM-dd hh:mm:ss.zzz") +
+            "\t" + QString::number(e.ca) + "\t" + QString::number(e.address) + "\t" +
+            QString::number(e.type) + "\t" + QString::number(e.value) + "\t" +
+            flags.trimmed() + "\n";
   }
+  QApplication::clipboard()->setText(text);
+  i104.logMsg(QString("SOE: %1 EVENTS IN %2 MS, COPIED TO THE CLIPBOARD")
+                  .arg(events.size())
+                  .arg(ms)
+                  .toLatin1()
+                  .constData());
 }
 
-void MainWindow::SendOSHMI(char *msg, uint32_t packet_size) {
-  udps->writeDatagram(reinterpret_cast<const char *>(msg), packet_size,
-                      I104M_host, I104M_porta);
-  if (I104M_HaveDualHost())
-    udps->writeDatagram(reinterpret_cast<const char *>(msg), packet_size,
-                        I104M_host_dual, I104M_porta);
+void MainWindow::on_cbStats_clicked() {
+  mStatsDock->setVisible(ui->cbStats->isChecked());
 }
 
-void MainWindow::fmtCP56Time(char *buf, cp56time2a *timetag) {
-  if (timetag->month == 0 || timetag->mday == 0)
-    return;
-  sprintf(buf, "Field: %02d/%02d/%02d %02d:%02d:%02d.%03d %s %s", timetag->year,
-          timetag->month, timetag->mday, timetag->hour, timetag->min,
-          timetag->msec / 1000, timetag->msec % 1000,
-          timetag->iv ? "iv" : "ok",
-          timetag->su ? "su" : "");
+void MainWindow::slot_stats(iec104_stats stats) {
+  if (mStatsDock->isVisible())
+    mStatsText->setPlainText(QString::fromStdString(stats.text()));
+  mStatsExport.write("RTU1", stats);
 }
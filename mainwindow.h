@@ -37,10 +37,15 @@
 #include <QtWidgets/QPushButton>
 #include <QTimer>
 #include <QSettings>
-#include <QtWidgets/QTableWidgetItem>
-#include <map>
+#include <QSortFilterProxyModel>
+#include <QtWidgets/QDockWidget>
+#include <QtWidgets/QPlainTextEdit>
 #include "iec104_class.h"
 #include "qiec104.h"
+#include "i104m.h"
+#include "pointsmodel.h"
+#include "logmodel.h"
+#include "statsexport.h"
 
 #define QTESTER_VERSION "v2.6.2"
 #define QTESTER_COPYRIGHT "Copyright © 2010-2024 Ricardo Lastra Olsen"
@@ -67,187 +72,64 @@ class MainWindow : public QMainWindow {
   void on_pbConnect_clicked(); // connect button pressed
   void on_pbGI_clicked(); // GI button pressed
   void slot_timer_logmsg(); // timer for log messages
+  void slot_timer_refresh(); // timer for repainting the points table
   void slot_timer_I104M_kamsg(); // timer for sending keepalive I104M messages
   void slot_I104M_ready_to_read();  // I104M: slot to read data from OSHMI UDP
   void slot_dataIndication(iec_obj* obj, unsigned numpoints);
+  void slot_dataBatch(QVector<iec_obj> objs, QVector<unsigned> sizes); // threaded mode
+  void slot_cacheIndication(iec_obj* obj, unsigned numpoints); // hot standby replication
+  void slot_cacheBatch(QVector<iec_obj> objs); // threaded mode
   void slot_interrogationActConfIndication();
   void slot_interrogationActTermIndication();
   void slot_tcpconnect();         // tcp connect for iec104
   void slot_tcpdisconnect();      // tcp disconnect for iec104
   void slot_commandActRespIndication(iec_obj* obj);
+  void slot_commandActResp(iec_obj obj); // threaded mode
 
   void on_pbCopyClipb_clicked(); // copy log messages to clipboard
   void on_pbCopyVals_clicked(); // copy values table to clipboard
+  void on_leLogFilter_textChanged(const QString &text); // log view filter
+  void on_cbStats_clicked(); // show/hide the statistics panel
+  void on_pbSOE_clicked(); // query the SOE history
+  void slot_stats(iec104_stats stats); // link statistics, every stats period
 
  private:
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColAddress; // map of points to cells of table
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColCommonAddress;
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColValue;
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColType;
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColCause;
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColFlags;
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColCount;
-  std::map <std::pair<int, int>, QTableWidgetItem*> mapPtItem_ColTimeTag;
+  PointsModel* mPoints; // points table, last state of each point
+  QSortFilterProxyModel* mPointsSort;
+  LogModel* mLogLines; // log view lines
+  QDockWidget* mStatsDock; // statistics panel
+  QPlainTextEdit* mStatsText;
+  StatsExporter mStatsExport;
+  QString mSOEDir; // SOE history directory, empty: off
 
   Ui::MainWindow* ui;
   QTimer* tmLogMsg; // timer to show log messages
+  QTimer* tmRefresh; // timer to repaint the points table
+  int RefreshHz;     // repaints of the points table per second
   QIec104 i104;
 
-  unsigned LastCommandAddress;
   int SendCommands;             // 1 = allow sending commands, 0 = don't send commands
   int Hide;
 
   // I104M Related
   void I104M_Loga(QString str, int id = 0); // I104M: log messages
-  void I104M_processPoints(iec_obj* obj, unsigned numpoints);   // I104M: process points
+  void showCachedPoints(bool forward); // point cache to the table (and I104M)
   inline bool I104M_HaveDualHost() { return (I104M_host_dual != QHostAddress("0.0.0.0")); }
   QHostAddress I104M_host; // IP address from OSHMI main machine
   QHostAddress I104M_host_dual; // OSHMI dual host address (the other machine)
   static const int I104M_porta = 8099; // UDP port to send data to OSHMI
   static const int I104M_porta_escuta = 8098; // udp port to receive commands from OSHMI
   static const int I104M_CntToBePrimary = 3; // counts necessary to be primary when not receiving keepalive messages
-  static const int I104M_seconds_kamsg = 7; // period of keepalive messages
+  int I104M_ms_kamsg = 7000; // period of keepalive messages
+  bool I104M_HotStandby = false; // the secondary keeps a replica of the point cache
   int I104M_CntDnToBePrimary = 0; // countdown to be primary when not receiving keepalive messages
   int I104M_Logar = 0; // controls log of I104M messages
   bool isPrimary; // primary or secondary redundant mode
   QUdpSocket* udps = nullptr; // I104M: udp socket
+  I104MForwarder I104M_fwd; // I104M: data and command responses to OSHMI
+  I104MReplicator I104M_rep; // I104M: point cache replica, hot standby
+  void I104M_SendSpecial(uint32_t addr); // special command to the dual host
   QTimer* tmI104M_kamsg = nullptr; // timer to send keep alive messages to the dual host
-  void SendOSHMI(char* msg, unsigned int packet_size);
-  void fmtCP56Time(char*, cp56time2a*);
 };
 
-
-#pragma pack(push)
-#pragma pack(1) // byte aligned structures
-
-#define I104M_LISTENUDPPORT 8098
-#define I104M_WRITEUDPPORT 8099
-
-#define I104M_ASDU_SPECIAL_CMD 1001
-#define I104M_SPECIAL_CMD_ADDR_REQ_GI 0
-#define I104M_SPECIAL_CMD_ADDR_KEEP_ALIVE 1
-
-#define PKTDIG_MAXPOINTS       250
-#define PKTEVE_MAXPOINTS       100
-#define PKTANA_MAXPOINTS       150
-
-#define MSGKA_SIG 0x5a5a5a5a
-
-#define MSGSUP_SIG 0x53535353
-typedef struct {
-  uint32_t signature;  // 0x53535353
-  uint32_t endereco;
-  uint32_t tipo;
-  uint32_t prim;
-  uint32_t sec;
-  uint32_t causa;
-  uint32_t taminfo;
-  unsigned char info[255];
-} t_msgsup;
-
-#define MSGSUPSQ_SIG 0x64646464
-typedef struct {
-  uint32_t signature;  // 0x64646464
-  uint32_t numpoints;
-  uint32_t tipo;
-  uint32_t prim;
-  uint32_t sec;
-  uint32_t causa;
-  uint32_t taminfo; // value size for the type (not counting the 4 byte address)
-  unsigned char info[2000]; // { 4 bytes uint32_t address, point value (taminfo bytes) } ...  Repeat
-} t_msgsupsq;
-
-#define MSGCMD_SIG 0x4b4b4b4b
-typedef struct {
-  uint32_t signature; // 0x4b4b4b4b
-  uint32_t endereco;
-  uint32_t tipo;
-  union {
-    uint32_t onoff;
-    float setpoint;
-    int32_t setpoint_i32;
-    short int setpoint_i16;
-  };
-  uint32_t sbo;
-  uint32_t qu;
-  uint32_t utr;
-} t_msgcmd;
-
-typedef struct {
-  unsigned short nponto; // point address 1st & 2nd bytes
-  unsigned char nponto3; // point address 3rd byte
-  unsigned char iq;      // state & qualifier
-  unsigned short ms;     // milli seconds
-  unsigned char min;     // minute
-  unsigned char hora;    // hour
-  unsigned char dia;     // day
-  unsigned char mes;
-  unsigned char ano;
-} digital_w_time7;
-
-typedef struct {
-  unsigned char iq;     // state & qualifier
-  unsigned short ms;    // milli seconds
-  unsigned char min;    // minute
-  unsigned char hora;   // hour
-  unsigned char dia;    // day
-  unsigned char mes;
-  unsigned char ano;
-} digital_w_time7_seq;
-
-
-typedef struct {
-  unsigned char iq;      // state & qualifier
-} digital_notime_seq;
-
-typedef struct {
-  unsigned short nponto; // point address 1st & 2nd bytes
-  unsigned char nponto3; // point address 3rd byte
-  short sva;             // analog value 16bit integer
-  unsigned char qds;     // qualifier
-} analogico;
-
-typedef struct {
-  short sva;         // analog value 16bit integer
-  unsigned char qds; // qualifier
-} analogico_seq;
-
-typedef struct {
-  unsigned short nponto; // point address 1st & 2nd bytes
-  unsigned char nponto3; // point address 3rd byte
-  unsigned char vti;     // step pos
-  unsigned char qds;     // qualifier
-} step;
-
-typedef struct {
-  unsigned char vti;   // step pos
-  unsigned char qds;   // qualifier
-} step_seq;
-
-typedef struct {
-  unsigned short nponto; // point address 1st & 2nd bytes
-  unsigned char nponto3; // point address 3rd byte
-  float fr;              // analog value 4byte float
-  unsigned char qds;     // qualifier
-} flutuante;
-
-typedef struct {
-  float fr;         // analog value 4byte float
-  unsigned char qds;  // qualifier
-} flutuante_seq;
-
-typedef struct {
-  unsigned short nponto; // point address 1st & 2nd bytes
-  unsigned char nponto3; // point address 3rd byte
-  uint32_t bcr;      // valor binary counter reading
-  unsigned char qds;     // qualifier
-} integrated;
-
-typedef struct {
-  uint32_t bcr;   // value binary counter reading
-  unsigned char qds;  // qualifies
-} integrated_seq;
-
-#pragma pack(pop)
-
 #endif // MAINWINDOW_H
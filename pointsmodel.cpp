@@ -0,0 +1,416 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#include "pointsmodel.h"
+#include <QDateTime>
+#include <stdio.h>
+
+namespace {
+
+const char *dblmsg[] = {"tra ", "off ", "on ", "ind "};
+const char *pnmsg[] = {"pos ", "neg "};
+const char *selmsg[] = {"exe ", "sel "};
+const char *sglmsg[] = {"off ", "on "};
+const char *qumsg[] = {"uns ", "shp ", "lop ", "per ", "res "};
+const char *rcsmsg[] = {"na0 ", "dec ", "inc ", "na3 "};
+const char *kpamsg[] = {"unu ", "thr ", "fil ", "lli ", "hli ", "res "};
+
+inline const char *msgOf(const char *const *tab, unsigned n, unsigned i) {
+  return i < n ? tab[i] : "res ";
+}
+
+bool hasTimeTag(unsigned type) {
+  switch (type) {
+  case iec104_class::M_SP_TB_1:
+  case iec104_class::M_DP_TB_1:
+  case iec104_class::M_ST_TB_1:
+  case iec104_class::M_BO_TB_1:
+  case iec104_class::M_ME_TD_1:
+  case iec104_class::M_ME_TE_1:
+  case iec104_class::M_ME_TF_1:
+  case iec104_class::M_IT_TB_1:
+  case iec104_class::M_EP_TD_1:
+  case iec104_class::M_EP_TE_1:
+  case iec104_class::M_EP_TF_1:
+  case iec104_class::C_SC_TA_1:
+  case iec104_class::C_DC_TA_1:
+  case iec104_class::C_RC_TA_1:
+  case iec104_class::C_SE_TA_1:
+  case iec104_class::C_SE_TB_1:
+  case iec104_class::C_SE_TC_1:
+  case iec104_class::C_BO_TA_1:
+    return true;
+  }
+  return false;
+}
+
+bool isCommand(unsigned type) { return type >= iec104_class::C_SC_NA_1; }
+
+void fmtCP56Time(char *buf, const cp56time2a *timetag) {
+  if (timetag->month == 0 || timetag->mday == 0)
+    return;
+  sprintf(buf, "Field: %02d/%02d/%02d %02d:%02d:%02d.%03d %s %s", timetag->year,
+          timetag->month, timetag->mday, timetag->hour, timetag->min,
+          timetag->msec / 1000, timetag->msec % 1000,
+          timetag->iv ? "iv" : "ok",
+          timetag->su ? "su" : "");
+}
+
+void fmtFlags(char *buf, const iec_obj *obj) {
+  buf[0] = 0;
+  switch (obj->type) {
+  case iec104_class::M_EP_TD_1:
+    sprintf(buf, "%s%s%s%s%s%s %dms", dblmsg[obj->dp], obj->bl ? "bl " : "",
+            obj->nt ? "nt " : "", obj->sb ? "sb " : "",
+            obj->iv ? "iv " : "", obj->ei ? "ei " : "",
+            obj->elapsed_time.milliseconds);
+    break;
+  case iec104_class::M_EP_TE_1:
+    sprintf(buf, "%s%s%s%s%s%s%s%s%s%s%s %dms", obj->bl ? "bl " : "",
+            obj->nt ? "nt " : "", obj->sb ? "sb " : "",
+            obj->iv ? "iv " : "", obj->ei ? "ei " : "",
+            obj->spe.gs ? "gs " : "", obj->spe.sl1 ? "sl1 " : "",
+            obj->spe.sl2 ? "sl2 " : "", obj->spe.sl3 ? "sl3 " : "",
+            obj->spe.sie ? "sie " : "", obj->spe.srd ? "srd " : "",
+            obj->elapsed_time.milliseconds);
+    break;
+  case iec104_class::M_EP_TF_1:
+    sprintf(buf, "%s%s%s%s%s%s%s%s%s %dms", obj->bl ? "bl " : "",
+            obj->nt ? "nt " : "", obj->sb ? "sb " : "",
+            obj->iv ? "iv " : "", obj->ei ? "ei " : "",
+            obj->oci.gc ? "gc " : "", obj->oci.cl1 ? "cl1 " : "",
+            obj->oci.cl2 ? "cl2 " : "", obj->oci.cl3 ? "cl3 " : "",
+            obj->elapsed_time.milliseconds);
+    break;
+
+  case iec104_class::M_SP_TB_1: // 30
+  case iec104_class::M_SP_NA_1: // 1
+    sprintf(buf, "%s%s%s%s%s", obj->sp ? "on " : "off ",
+            obj->iv ? "iv " : "", obj->bl ? "bl " : "",
+            obj->sb ? "sb " : "", obj->nt ? "nt " : "");
+    break;
+  case iec104_class::M_DP_TB_1: // 31
+  case iec104_class::M_DP_NA_1: // 3
+    sprintf(buf, "%s%s%s%s%s", dblmsg[obj->dp], obj->iv ? "iv " : "",
+            obj->bl ? "bl " : "", obj->sb ? "sb " : "",
+            obj->nt ? "nt " : "");
+    break;
+  case iec104_class::M_ST_TB_1: // 32
+  case iec104_class::M_ST_NA_1: // 5
+    sprintf(buf, "%s%s%s%s%s%s", obj->ov ? "ov " : "", obj->iv ? "iv " : "",
+            obj->bl ? "bl " : "", obj->sb ? "sb " : "",
+            obj->nt ? "nt " : "", obj->t ? "t " : "");
+    break;
+
+  case iec104_class::M_IT_TB_1: // 37
+  case iec104_class::M_IT_NA_1: // 15
+    sprintf(buf, "%s%s%s%s%u", obj->iv ? "iv " : "", obj->cadj ? "ca " : "",
+            obj->cy ? "cy " : "", "sq=", obj->sq);
+    break;
+
+  case iec104_class::M_PS_NA_1: // 20
+    sprintf(buf,
+            "%s%s%s%s%s ST %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d CH %d%d%d%d "
+            "%d%d%d%d %d%d%d%d %d%d%d%d [1-16]",
+            obj->ov ? "ov " : "", obj->bl ? "bl " : "",
+            obj->nt ? "nt " : "", obj->sb ? "sb " : "",
+            obj->iv ? "iv " : "", obj->stcd.st1, obj->stcd.st2,
+            obj->stcd.st3, obj->stcd.st4, obj->stcd.st5, obj->stcd.st6,
+            obj->stcd.st7, obj->stcd.st8, obj->stcd.st9, obj->stcd.st10,
+            obj->stcd.st11, obj->stcd.st12, obj->stcd.st13, obj->stcd.st14,
+            obj->stcd.st15, obj->stcd.st16, obj->stcd.cd1, obj->stcd.cd2,
+            obj->stcd.cd3, obj->stcd.cd4, obj->stcd.cd5, obj->stcd.cd6,
+            obj->stcd.cd7, obj->stcd.cd8, obj->stcd.cd9, obj->stcd.cd10,
+            obj->stcd.cd11, obj->stcd.cd12, obj->stcd.cd13, obj->stcd.cd14,
+            obj->stcd.cd15, obj->stcd.cd16);
+    break;
+
+  case iec104_class::M_BO_TB_1: // 33
+  case iec104_class::M_BO_NA_1: // 7
+    sprintf(buf,
+            "%s%s%s%s%s ST %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d %d%d%d%d "
+            "%d%d%d% d%d%d%d %d%d%d%d [1-32]",
+            obj->ov ? "ov " : "", obj->bl ? "bl " : "",
+            obj->nt ? "nt " : "", obj->sb ? "sb " : "",
+            obj->iv ? "iv " : "", obj->bsi.st1, obj->bsi.st2, obj->bsi.st3,
+            obj->bsi.st4, obj->bsi.st5, obj->bsi.st6, obj->bsi.st7,
+            obj->bsi.st8, obj->bsi.st9, obj->bsi.st10, obj->bsi.st11,
+            obj->bsi.st12, obj->bsi.st13, obj->bsi.st14, obj->bsi.st15,
+            obj->bsi.st16, obj->bsi.st17, obj->bsi.st18, obj->bsi.st19,
+            obj->bsi.st20, obj->bsi.st21, obj->bsi.st22, obj->bsi.st23,
+            obj->bsi.st24, obj->bsi.st25, obj->bsi.st26, obj->bsi.st27,
+            obj->bsi.st28, obj->bsi.st29, obj->bsi.st31, obj->bsi.st32);
+    break;
+
+  case iec104_class::M_ME_TD_1: // 34
+  case iec104_class::M_ME_TE_1: // 35
+  case iec104_class::M_ME_TF_1: // 36
+  case iec104_class::M_ME_NA_1: // 9
+  case iec104_class::M_ME_NB_1: // 11
+  case iec104_class::M_ME_NC_1: // 13
+  case iec104_class::M_ME_ND_1: // 21
+    sprintf(buf, "%s%s%s%s%s", obj->ov ? "ov " : "", obj->iv ? "iv " : "",
+            obj->bl ? "bl " : "", obj->sb ? "sb " : "",
+            obj->nt ? "nt " : "");
+    break;
+
+  // command responses
+  case iec104_class::C_SC_TA_1:
+  case iec104_class::C_SC_NA_1:
+    sprintf(buf, "%s%s%s%s", pnmsg[obj->pn], sglmsg[obj->scs],
+            selmsg[obj->se], msgOf(qumsg, 5, obj->qu));
+    break;
+  case iec104_class::C_DC_TA_1:
+  case iec104_class::C_DC_NA_1:
+    sprintf(buf, "%s%s%s%s", pnmsg[obj->pn], dblmsg[obj->dcs],
+            selmsg[obj->se], msgOf(qumsg, 5, obj->qu));
+    break;
+  case iec104_class::C_RC_TA_1:
+  case iec104_class::C_RC_NA_1:
+    sprintf(buf, "%s%s%s", pnmsg[obj->pn], rcsmsg[obj->rcs], selmsg[obj->se]);
+    break;
+  case iec104_class::C_SE_TA_1:
+  case iec104_class::C_SE_NA_1:
+  case iec104_class::C_SE_TB_1:
+  case iec104_class::C_SE_NB_1:
+  case iec104_class::C_SE_TC_1:
+  case iec104_class::C_SE_NC_1:
+    sprintf(buf, "%s%s", pnmsg[obj->pn], selmsg[obj->se]);
+    break;
+  case iec104_class::C_BO_TA_1:
+  case iec104_class::C_BO_NA_1:
+    sprintf(buf, "%s", pnmsg[obj->pn]);
+    break;
+  case iec104_class::P_ME_NA_1:
+  case iec104_class::P_ME_NB_1:
+  case iec104_class::P_ME_NC_1:
+    sprintf(buf, "%s%s%s%s", pnmsg[obj->pn], msgOf(kpamsg, 6, obj->kpa),
+            obj->lpc ? "lpc " : "", obj->pop ? "pop " : "");
+    break;
+  case iec104_class::P_AC_NA_1:
+    sprintf(buf, "%s%s", pnmsg[obj->pn], msgOf(kpamsg, 6, obj->qpa));
+    break;
+  }
+}
+
+} // namespace
+
+PointsModel::PointsModel(QObject *parent) : QAbstractTableModel(parent) {
+  mShownRows = 0;
+  mSlotBits = 10;
+  mSlotKey.assign(size_t(1) << mSlotBits, 0);
+  mSlotRow.assign(size_t(1) << mSlotBits, -1);
+}
+
+int PointsModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : mShownRows;
+}
+
+int PointsModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant PointsModel::headerData(int section, Qt::Orientation orientation,
+                                 int role) const {
+  static const char *colunas[] = {"Address", "CA",    "Value", "Type",
+                                  "Cause",   "Flags", "Count", "TimeTag"};
+  if (role != Qt::DisplayRole)
+    return QVariant();
+  if (orientation == Qt::Horizontal)
+    return section >= 0 && section < ColumnCount ? QString(colunas[section])
+                                                 : QVariant();
+  return section + 1;
+}
+
+QVariant PointsModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= mShownRows)
+    return QVariant();
+  const PointRow &r = mRows[size_t(index.row())];
+
+  switch (role) {
+  case Qt::DisplayRole:
+    return text(r, index.column());
+  case Qt::TextAlignmentRole:
+    if (index.column() == ColTimeTag)
+      return QVariant(Qt::AlignLeft | Qt::AlignVCenter);
+    return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+  case SortRole:
+    switch (index.column()) {
+    case ColAddress:
+      return r.obj.address;
+    case ColCA:
+      return r.obj.ca;
+    case ColValue:
+      return r.obj.value;
+    case ColType:
+      return r.obj.type;
+    case ColCause:
+      return r.obj.cause;
+    case ColCount:
+      return r.count;
+    }
+    return text(r, index.column());
+  }
+  return QVariant();
+}
+
+QString PointsModel::text(const PointRow &r, int column) const {
+  char buf[1500];
+  const iec_obj *obj = &r.obj;
+
+  switch (column) {
+  case ColAddress:
+    sprintf(buf, "%06u", obj->address);
+    break;
+  case ColCA:
+    sprintf(buf, "%u", obj->ca);
+    break;
+  case ColValue:
+    if (obj->type == iec104_class::C_SC_NA_1 || obj->type == iec104_class::C_SC_TA_1)
+      sprintf(buf, "%d", int(obj->scs));
+    else if (obj->type == iec104_class::C_DC_NA_1 || obj->type == iec104_class::C_DC_TA_1)
+      sprintf(buf, "%d", int(obj->dcs));
+    else if (obj->type == iec104_class::C_RC_NA_1 || obj->type == iec104_class::C_RC_TA_1)
+      sprintf(buf, "%d", int(obj->rcs));
+    else
+      sprintf(buf, "%9.3f", double(obj->value));
+    break;
+  case ColType:
+    if (isCommand(obj->type))
+      sprintf(buf, "%d", obj->type);
+    else
+      sprintf(buf, "%d:%s", obj->type, iec104_class::asduTiStr(obj->type).c_str());
+    break;
+  case ColCause:
+    if (isCommand(obj->type))
+      sprintf(buf, "%d", obj->cause);
+    else
+      sprintf(buf, "%d:%s", obj->cause, iec104_class::causeStr(obj->cause).c_str());
+    break;
+  case ColFlags:
+    fmtFlags(buf, obj);
+    break;
+  case ColCount:
+    sprintf(buf, "%u", r.count);
+    break;
+  case ColTimeTag:
+    sprintf(buf, "Local: %s",
+            QDateTime::fromMSecsSinceEpoch(r.local_ms)
+                .toString("yyyy/MM/dd hh:mm:ss.zzz")
+                .toStdString()
+                .c_str());
+    if (hasTimeTag(obj->type))
+      fmtCP56Time(buf, &obj->timetag);
+    break;
+  default:
+    return QString();
+  }
+  return QString(buf);
+}
+
+int PointsModel::find(uint64_t k) const {
+  size_t mask = mSlotRow.size() - 1;
+  for (size_t i = size_t((k * 0x9E3779B97F4A7C15ULL) >> (64 - mSlotBits));;
+       i = (i + 1) & mask) {
+    if (mSlotRow[i] < 0)
+      return -1;
+    if (mSlotKey[i] == k)
+      return mSlotRow[i];
+  }
+}
+
+void PointsModel::insertKey(uint64_t k, int row) {
+  if (2 * (size_t(row) + 1) > mSlotRow.size()) {
+    // grow and rehash
+    std::vector<uint64_t> keys;
+    std::vector<int> rows;
+    keys.swap(mSlotKey);
+    rows.swap(mSlotRow);
+    mSlotBits++;
+    mSlotKey.assign(size_t(1) << mSlotBits, 0);
+    mSlotRow.assign(size_t(1) << mSlotBits, -1);
+    for (size_t i = 0; i < rows.size(); i++)
+      if (rows[i] >= 0)
+        insertKey(keys[i], rows[i]);
+  }
+  size_t mask = mSlotRow.size() - 1;
+  size_t i = size_t((k * 0x9E3779B97F4A7C15ULL) >> (64 - mSlotBits));
+  while (mSlotRow[i] >= 0)
+    i = (i + 1) & mask;
+  mSlotKey[i] = k;
+  mSlotRow[i] = row;
+}
+
+void PointsModel::update(const iec_obj *obj, unsigned numpoints) {
+  int64_t now = QDateTime::currentMSecsSinceEpoch();
+
+  for (unsigned i = 0; i < numpoints; i++, obj++) {
+    uint64_t k = key(obj);
+    int row = find(k);
+    if (row < 0) {
+      row = int(mRows.size());
+      insertKey(k, row);
+      PointRow r;
+      r.count = 0;
+      mRows.push_back(r);
+      mDirty.push_back(0);
+    }
+    PointRow &r = mRows[size_t(row)];
+    r.obj = *obj;
+    r.count++;
+    r.local_ms = now;
+    mDirty[size_t(row)] = 1;
+  }
+}
+
+void PointsModel::commitRows() {
+  if (int(mRows.size()) > mShownRows) {
+    beginInsertRows(QModelIndex(), mShownRows, int(mRows.size()) - 1);
+    mShownRows = int(mRows.size());
+    endInsertRows();
+  }
+}
+
+void PointsModel::refreshRow(int row) {
+  if (row >= 0 && row < mShownRows && mDirty[size_t(row)]) {
+    mDirty[size_t(row)] = 0;
+    emit dataChanged(index(row, ColValue), index(row, ColumnCount - 1));
+  }
+}
+
+void PointsModel::clear() {
+  beginResetModel();
+  mRows.clear();
+  mDirty.clear();
+  mShownRows = 0;
+  mSlotBits = 10;
+  mSlotKey.assign(size_t(1) << mSlotBits, 0);
+  mSlotRow.assign(size_t(1) << mSlotBits, -1);
+  endResetModel();
+}
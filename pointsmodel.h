@@ -0,0 +1,83 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+#ifndef POINTSMODEL_H
+#define POINTSMODEL_H
+
+// Model of the points table: last state of each point (CA, address) in one
+// contiguous array, rows in arrival order, found by a flat hash of (CA, address).
+// Rows are text formatted only when the view asks for them.
+// Updates only store the point and mark the row dirty, the view is told about
+// new and changed rows at the refresh rate (commitRows, refreshRow).
+
+#include <QAbstractTableModel>
+#include <stdint.h>
+#include <vector>
+#include "iec104_class.h"
+
+class PointsModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  enum Columns { ColAddress, ColCA, ColValue, ColType, ColCause, ColFlags, ColCount, ColTimeTag, ColumnCount };
+  static const int SortRole = Qt::UserRole; // numeric for the number columns
+
+  explicit PointsModel(QObject *parent = nullptr);
+  int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+  int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+  QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+  // points of one asdu (or a command response), no signals
+  void update(const iec_obj *obj, unsigned numpoints);
+  void commitRows();         // insert in the view the rows of the new points
+  void refreshRow(int row);  // dataChanged if the row is dirty
+  void clear();
+
+private:
+  struct PointRow {
+    iec_obj obj;      // last received
+    uint32_t count;   // times received
+    int64_t local_ms; // local time of the last update
+  };
+  QString text(const PointRow &r, int column) const;
+  int find(uint64_t key) const; // row or -1
+  void insertKey(uint64_t key, int row);
+  static uint64_t key(const iec_obj *obj) { return (uint64_t(obj->ca) << 32) | obj->address; }
+
+  std::vector<PointRow> mRows;
+  int mShownRows;              // rows inserted in the view
+  std::vector<uint8_t> mDirty; // row changed after the last refreshRow
+  // open addressing hash (linear probing) of the rows, kept at most half full
+  std::vector<uint64_t> mSlotKey;
+  std::vector<int> mSlotRow; // -1: empty
+  unsigned mSlotBits;
+};
+
+#endif // POINTSMODEL_H
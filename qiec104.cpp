@@ -28,69 +28,478 @@
  */
 
 #include "qiec104.h"
-#include <QtWidgets/QApplication>
+#include <QCoreApplication>
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+QIec104Timers::QIec104Timers(QObject *parent) : QObject(parent), wheel(monoMs()) {
+  tm = new QTimer(this);
+  tm->setSingleShot(true);
+  tm->setTimerType(Qt::PreciseTimer);
+  connect(tm, &QTimer::timeout, this, [this] { expire(); });
+  wheel.onEarlier = [this](int64_t deadline_ms) { wake(deadline_ms); };
+}
+
+void QIec104Timers::wake(int64_t deadline_ms) {
+  int64_t ms = deadline_ms - monoMs();
+  ms = ms < 0 ? 0 : (ms > (1 << 30) ? (1 << 30) : ms);
+  if (!tm->isActive() || ms < tm->remainingTime())
+    tm->start(int(ms));
+}
+
+void QIec104Timers::expire() {
+  wheel.advance(monoMs());
+  int64_t next = wheel.nextDeadline();
+  if (next >= 0)
+    wake(next);
+}
 
 QIec104::QIec104(QObject *parent) : QObject(parent) {
   mEnding = false;
   mAllowConnect = true;
+  mThreaded = false;
+  mOwnThread = nullptr;
+  mReplicate = false;
+  mConnected = false;
+  mRacing[0] = mRacing[1] = false;
+  mBackoffCnt = 0;
+  mBackoffMin = 1;
+  mBackoffMax = 30;
+  mRng.seed(uint32_t(nowUs()) ^ uint32_t(reinterpret_cast<uintptr_t>(this)));
+  mStatsPeriod = 0;
+  mReplaySpeed = 1;
+  mSOEFlush = 5;
+  mReplayT0 = 0;
+  mLinkActive = false;
   SendCommands = 0;
   ForcePrimary = 0;
   mLog.activateLog();
   mLog.doLogTime();
 
-  tcps = new QTcpSocket(nullptr);
-  tmKeepAlive = new QTimer();
+  qRegisterMetaType<iec_obj>();
+  qRegisterMetaType<iec104_stats>();
+  qRegisterMetaType<QVector<iec_obj>>();
+  qRegisterMetaType<QVector<unsigned>>();
 
-  connect(tmKeepAlive, SIGNAL(timeout()), this, SLOT(slot_keep_alive()));
-  connect(tcps, SIGNAL(readyRead()), this, SLOT(slot_tcpreadytoread()));
-  connect(tcps, SIGNAL(connected()), this, SLOT(slot_tcpconnect()));
-  connect(tcps, SIGNAL(disconnected()), this, SLOT(slot_tcpdisconnect()));
-  connect(tcps, SIGNAL(errorOccurred(QAbstractSocket::SocketError)), this,
-          SLOT(slot_tcperror(QAbstractSocket::SocketError)),
-          Qt::DirectConnection);
+  // children, so that they move with this object to the protocol thread
+  mSock[0] = new QTcpSocket(this);
+  mSock[1] = new QTcpSocket(this);
+  tcps = mSock[0];
+  tmReplay = new QTimer(this);
+  mOwnTimers = new QIec104Timers(this);
+  setTimerWheel(&mOwnTimers->wheel);
 
-  //tcps->moveToThread(&tcpThread);
-  //tcpThread.start(QThread::TimeCriticalPriority);
+  connect(tmReplay, SIGNAL(timeout()), this, SLOT(slot_replay()));
+  for (int i = 0; i < 2; i++) {
+    QTcpSocket *sock = mSock[i];
+    connect(sock, &QTcpSocket::connected, this, [this, i] {
+      if (!mRacing[i])
+        return;
+      // STARTDT on each candidate, the link is the first confirmed
+      static const char startdtact[6] = {0x68, 0x04, 0x07, 0x00, 0x00, 0x00};
+      mSock[i]->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+      mSock[i]->write(startdtact, sizeof(startdtact));
+    });
+    connect(sock, &QTcpSocket::readyRead, this, [this, i] {
+      if (mConnected && tcps == mSock[i])
+        slot_tcpreadytoread();
+      else if (mRacing[i])
+        raceFrames(i);
+    });
+    connect(sock, &QTcpSocket::disconnected, this, [this, i] {
+      if (mConnected && tcps == mSock[i]) {
+        mConnected = false;
+        slot_tcpdisconnect();
+        if (mLinkActive && !mEnding)
+          scheduleConnect();
+      } else if (mRacing[i]) {
+        raceFailed(i);
+      }
+    });
+    connect(sock, &QTcpSocket::errorOccurred, this,
+            [this, i](QAbstractSocket::SocketError err) {
+              slot_tcperror(err);
+              if (mRacing[i])
+                raceFailed(i);
+            },
+            Qt::DirectConnection);
+  }
 }
 
 QIec104::~QIec104() {
-  delete tmKeepAlive;
-  delete tcps;
+  if (mThreaded)
+    terminate();
+  delete mOwnThread;
+}
+
+// run f on the protocol thread, queued when called from another thread
+template <class F> void QIec104::runOnIOThread(F f) {
+  if (QThread::currentThread() == thread())
+    f();
+  else
+    QMetaObject::invokeMethod(this, f, Qt::QueuedConnection);
+}
+
+void QIec104::startIOThread(QThread *ioThread) {
+  if (mThreaded)
+    return;
+  mThreaded = true;
+  if (ioThread == nullptr) {
+    mOwnThread = new QThread();
+    mOwnThread->start(QThread::TimeCriticalPriority);
+    ioThread = mOwnThread;
+  }
+  moveToThread(ioThread);
+}
+
+void QIec104::startLink() {
+  mLinkActive = true;
+  runOnIOThread([this] {
+    armTimer(tmConnect, 0);
+    if (mStatsPeriod)
+      armTimer(tmStats, int64_t(mStatsPeriod) * 1000);
+    if (mSOE.isOpen())
+      armTimer(tmSOEFlush, int64_t(mSOEFlush) * 1000);
+  });
+}
+
+void QIec104::stopLink() {
+  mLinkActive = false;
+  runOnIOThread([this] {
+    cancelTimers();
+    // a connected link is closed by its disconnected signal (at once, or after
+    // the pending writes), else no signal comes
+    bool connected = mConnected;
+    closeSockets();
+    if (!connected)
+      slot_tcpdisconnect();
+  });
+}
+
+void QIec104::requestGI() {
+  runOnIOThread([this] { solicitGI(); });
+}
+
+void QIec104::requestInterrogation(int group) {
+  runOnIOThread([this, group] { solicitInterrogation(char(group)); });
+}
+
+void QIec104::requestCommand(const iec_obj &obj) {
+  runOnIOThread([this, obj] {
+    iec_obj cmd = obj;
+    sendCommand(&cmd);
+  });
+}
+
+void QIec104::requestCommands(const QVector<iec_obj> &objs) {
+  runOnIOThread([this, objs] {
+    QVector<iec_obj> cmds = objs;
+    sendCommands(cmds.data(), unsigned(cmds.size()));
+  });
+}
+
+void QIec104::requestClearStats() {
+  runOnIOThread([this] { clearStats(); });
 }
 
-void QIec104::waitBytes(int bytes, int msTout) {
-  while (tcps->bytesAvailable() < bytes && msTout > 0) {
-    tcps->waitForReadyRead(8);
-    msTout -= 8;
+bool QIec104::startCapture(const QString &path, unsigned mbytes) {
+  stopCapture();
+  if (!mCapture.open(path.toStdString(), uint64_t(mbytes) * 1024 * 1024))
+    return false;
+  runOnIOThread([this] { setCapture(&mCapture); });
+  return true;
+}
+
+void QIec104::stopCapture() {
+  if (QThread::currentThread() == thread() || !thread()->isRunning()) {
+    setCapture(nullptr);
+    mCapture.close();
+  } else {
+    QMetaObject::invokeMethod(this, [this] {
+        setCapture(nullptr);
+        mCapture.close();
+      }, Qt::BlockingQueuedConnection);
+  }
+}
+
+bool QIec104::startReplay(const QString &path, double speed) {
+  if (!mReplay.open(path.toStdString()))
+    return false;
+  runOnIOThread([this, speed] {
+    iec104_capture_reader::frame f;
+    mReplaySpeed = speed;
+    mReplayT0 = mReplay.peek(f) ? f.t_ns : 0;
+    mReplayClock.start();
+    tmReplay->start(speed > 0 ? 10 : 0);
+  });
+  return true;
+}
+
+bool QIec104::openPointCache(const QString &path, unsigned capacity, unsigned staleSeconds) {
+  if (!mPointCache.open(path.toStdString(), capacity))
+    return false;
+  setPointCache(&mPointCache, staleSeconds);
+  return true;
+}
+
+void QIec104::cachedPoints(QVector<iec_obj> &objs, QVector<unsigned> &sizes) {
+  std::vector<iec_obj> pts;
+  // the cache is updated on the protocol thread
+  if (QThread::currentThread() == thread() || !thread()->isRunning())
+    mPointCache.points(pts);
+  else
+    QMetaObject::invokeMethod(this, [this, &pts] { mPointCache.points(pts); },
+                              Qt::BlockingQueuedConnection);
+  std::sort(pts.begin(), pts.end(), [](const iec_obj &a, const iec_obj &b) {
+    if (a.ca != b.ca)
+      return a.ca < b.ca;
+    if (a.type != b.type)
+      return a.type < b.type;
+    return a.address < b.address;
+  });
+  objs.clear();
+  sizes.clear();
+  objs.reserve(int(pts.size()));
+  for (size_t i = 0; i < pts.size(); i++) {
+    if (i == 0 || pts[i].ca != pts[i - 1].ca || pts[i].type != pts[i - 1].type)
+      sizes.append(0);
+    sizes.last()++;
+    objs.append(pts[i]);
   }
 }
 
+void QIec104::cachedRecords(std::vector<pointcache_rec> &recs) {
+  if (QThread::currentThread() == thread() || !thread()->isRunning())
+    mPointCache.records(recs);
+  else
+    QMetaObject::invokeMethod(this, [this, &recs] { mPointCache.records(recs); },
+                              Qt::BlockingQueuedConnection);
+}
+
+void QIec104::replicateRecords(const QVector<pointcache_rec> &recs) {
+  runOnIOThread([this, recs] {
+    for (const pointcache_rec &r : recs)
+      mPointCache.put(r);
+  });
+}
+
+void QIec104::setChangeFilter(double absolute, double percent, bool cyclicChanged) {
+  mDeadband.configure(absolute, percent, cyclicChanged);
+  setDeadband(mDeadband.active() ? &mDeadband : nullptr);
+}
+
+void QIec104::setCommandTracking(double timeoutSeconds, bool sboExecute) {
+  mCmdTrack.setTimeout(int64_t(timeoutSeconds * 1e6));
+  setCommandTracker(&mCmdTrack);
+  setSBOExecute(sboExecute);
+}
+
+bool QIec104::openSOE(const QString &dir, unsigned flushSeconds) {
+  if (!mSOE.open(dir.toStdString()))
+    return false;
+  mSOEFlush = flushSeconds > 0 ? flushSeconds : 1;
+  setSOE(&mSOE);
+  return true;
+}
+
+void QIec104::flushSOE() {
+  if (QThread::currentThread() == thread() || !thread()->isRunning())
+    mSOE.flush();
+  else
+    QMetaObject::invokeMethod(this, [this] { mSOE.flush(); }, Qt::BlockingQueuedConnection);
+}
+
+// frames of the capture due at this time, a slice of them when as fast as possible
+void QIec104::slot_replay() {
+  static const unsigned max_frames = 2000; // per event loop turn
+  iec104_capture_reader::frame f;
+  iec_apdu apdu;
+  unsigned n = 0;
+  double due = double(mReplayClock.nsecsElapsed()) * mReplaySpeed;
+
+  while (n < max_frames && mReplay.peek(f)) {
+    if (mReplaySpeed > 0 && double(f.t_ns - mReplayT0) > due)
+      break;
+    mReplay.next(f);
+    if (f.is_send || f.size > sizeof(apdu))
+      continue;
+    memcpy(&apdu, f.data, f.size);
+    replayAPDU(&apdu, int(f.size));
+    n++;
+  }
+  flushBatch();
+
+  if (mReplay.atEnd()) {
+    tmReplay->stop();
+    mSOE.flush();
+    mLog.pushMsg("REPLAY END");
+    emit signal_replayEnd();
+  }
+}
+
+void QIec104::requestSecondaryASDUAddress(int addr) {
+  runOnIOThread([this, addr] { setSecondaryASDUAddress(addr); });
+}
+
+// the log has one producer, messages from other threads are queued to the protocol thread
+void QIec104::logMsg(const char *msg) {
+  if (QThread::currentThread() == thread()) {
+    mLog.pushMsg(msg);
+  } else {
+    std::string s(msg);
+    QMetaObject::invokeMethod(this, [this, s] { mLog.pushMsg(s.c_str()); },
+                              Qt::QueuedConnection);
+  }
+}
+
+QString QIec104::peerAddress() {
+  QMutexLocker lock(&mPeerLock);
+  return mPeer;
+}
+
 void QIec104::dataIndication(iec_obj *obj, unsigned numpoints) {
-  emit signal_dataIndication(obj, numpoints);
+  if (mThreaded) {
+    // copy out of the decoder arena, sent to the ui once per tcp read
+    int n = mBatch.size();
+    mBatch.resize(n + int(numpoints));
+    memcpy(mBatch.data() + n, obj, numpoints * sizeof(iec_obj));
+    mBatchSizes.append(numpoints);
+  } else {
+    emit signal_dataIndication(obj, numpoints);
+  }
+}
+
+void QIec104::cacheIndication(iec_obj *obj, unsigned numpoints) {
+  if (!mReplicate)
+    return;
+  if (mThreaded) {
+    int n = mCacheBatch.size();
+    mCacheBatch.resize(n + int(numpoints));
+    memcpy(mCacheBatch.data() + n, obj, numpoints * sizeof(iec_obj));
+  } else {
+    emit signal_cacheIndication(obj, numpoints);
+  }
+}
+
+void QIec104::flushBatch() {
+  if (!mBatchSizes.isEmpty()) {
+    emit signal_dataBatch(mBatch, mBatchSizes);
+    mBatch.clear();
+    mBatchSizes.clear();
+  }
+  if (!mCacheBatch.isEmpty()) {
+    emit signal_cacheBatch(mCacheBatch);
+    mCacheBatch.clear();
+  }
 }
 
+// a race: main and backup RTU (if configured) connected at once
 void QIec104::connectTCP() {
-  static int cnt = 0;
   char buf[100];
 
-  tcps->close();
-  if (!mEnding && mAllowConnect) {
-    // alternate main and backup UTR IP address, if configured
-    if ((++cnt) % 2 || strcmp(getSecondaryIP_backup(), "") == 0) {
-      tcps->connectToHost(getSecondaryIP(), quint16(getPortTCP()),
-                          QIODevice::ReadWrite);
-      sprintf(buf, "Try to connect IP: %s", getSecondaryIP());
-      mLog.pushMsg(const_cast<char *>(buf));
-    } else {
-      tcps->connectToHost(getSecondaryIP_backup(), quint16(getPortTCP()),
-                          QIODevice::ReadWrite);
-      sprintf(buf, "Try to connect IP: %s", getSecondaryIP_backup());
-      mLog.pushMsg(const_cast<char *>(buf));
+  abortRace();
+  if (mEnding || !mAllowConnect || mConnected)
+    return;
+  for (int i = 0; i < 2; i++) {
+    const char *ip = i == 0 ? getSecondaryIP() : getSecondaryIP_backup();
+    if (i == 1 && (strcmp(ip, "") == 0 || strcmp(ip, getSecondaryIP()) == 0))
+      break;
+    mRacing[i] = true;
+    mSock[i]->connectToHost(ip, quint16(getPortTCP()), QIODevice::ReadWrite);
+    sprintf(buf, "Try to connect IP: %s", ip);
+    mLog.pushMsg(buf);
+  }
+  // connect and STARTDT within t1
+  armTimer(tmConnect, getTimeoutT1());
+}
+
+void QIec104::disconnectTCP() {
+  if (mConnected)
+    tcps->close();
+}
+
+// U-frames of a candidate until STARTDTCON, anything else fails it
+void QIec104::raceFrames(int i) {
+  unsigned char f[6];
+  while (mRacing[i] && mSock[i]->bytesAvailable() >= 6) {
+    mSock[i]->peek(reinterpret_cast<char *>(f), 6);
+    if (f[0] != START || f[1] != 4 || (f[2] & 3) != 3) {
+      raceFailed(i);
+      return;
+    }
+    mSock[i]->read(reinterpret_cast<char *>(f), 6);
+    if (f[2] == STARTDTCON) {
+      raceWon(i);
+      return;
+    }
+    if (f[2] == TESTFRACT) {
+      f[2] = TESTFRCON;
+      mSock[i]->write(reinterpret_cast<char *>(f), 6);
     }
   }
 }
 
-void QIec104::disconnectTCP() { tcps->close(); }
+void QIec104::raceFailed(int i) {
+  mRacing[i] = false;
+  mSock[i]->abort();
+  if (!mRacing[0] && !mRacing[1] && !mConnected && mLinkActive && !mEnding) {
+    timerWheel()->cancel(tmConnect);
+    scheduleConnect();
+  }
+}
+
+// the link, the other candidate is dropped
+void QIec104::raceWon(int i) {
+  char buf[100];
+  mRacing[i] = false;
+  abortRace();
+  timerWheel()->cancel(tmConnect);
+  tcps = mSock[i];
+  mConnected = true;
+  mBackoffCnt = 0;
+  sprintf(buf, "STARTDT CONFIRMED BY %s RTU", i == 0 ? "MAIN" : "BACKUP");
+  mLog.pushMsg(buf);
+  slot_tcpconnect();
+  // frames right after the STARTDTCON
+  if (tcps->bytesAvailable() > 0)
+    slot_tcpreadytoread();
+}
+
+void QIec104::abortRace() {
+  for (int i = 0; i < 2; i++)
+    if (mRacing[i]) {
+      mRacing[i] = false;
+      mSock[i]->abort();
+    }
+}
+
+void QIec104::closeSockets() {
+  abortRace();
+  if (mConnected)
+    tcps->close();
+}
+
+// exponential backoff with jitter: d = min * 2^failures (up to max), the
+// wait is random in [d/2, d] so that many sessions do not retry at once
+void QIec104::scheduleConnect() {
+  double d = mBackoffMin;
+  for (unsigned n = 0; n < mBackoffCnt && d < mBackoffMax; n++)
+    d *= 2;
+  if (d > mBackoffMax)
+    d = mBackoffMax;
+  mBackoffCnt++;
+  d *= 0.5 + 0.5 * std::uniform_real_distribution<double>(0, 1)(mRng);
+  char buf[100];
+  sprintf(buf, "RECONNECT IN %.1f s", d);
+  mLog.pushMsg(buf);
+  armTimer(tmConnect, int64_t(d * 1000));
+}
+
+void QIec104::setReconnect(double minSeconds, double maxSeconds) {
+  mBackoffMin = minSeconds < 0.01 ? 0.01 : minSeconds;
+  mBackoffMax = maxSeconds < mBackoffMin ? mBackoffMin : maxSeconds;
+}
 
 void QIec104::slot_tcperror(QAbstractSocket::SocketError socketError) {
   if (socketError != QAbstractSocket::SocketTimeoutError) {
@@ -111,17 +520,23 @@ int QIec104::readTCP(char *buf, int szmax) {
 
 // send tcp data, user provided
 void QIec104::sendTCP(char *data, int sz) {
-  if (tcps->state() == QAbstractSocket::ConnectedState)
-    if (!mEnding) {
-      tcps->write(data, sz);
-      if (mLog.isLogging())
-        LogFrame(data, sz, true);
-    }
+  if (mConnected && !mEnding)
+    tcps->write(data, sz);
+}
+
+// flush when the protocol thread returns to its event loop, frames queued in
+// the same turn (S-frame + commands + TESTFR) go in one write
+void QIec104::txReadyTCP() {
+  QMetaObject::invokeMethod(this, [this] { flushTCP(); }, Qt::QueuedConnection);
 }
 
 void QIec104::slot_tcpconnect() {
   tcps->setSocketOption(QAbstractSocket::LowDelayOption, 1);
-  onConnectTCP();
+  {
+    QMutexLocker lock(&mPeerLock);
+    mPeer = tcps->peerAddress().toString();
+  }
+  onConnectTCP(true);
   emit signal_tcp_connect();
 }
 
@@ -130,58 +545,110 @@ void QIec104::slot_tcpdisconnect() {
   emit signal_tcp_disconnect();
 }
 
-void QIec104::slot_keep_alive() {
-  static unsigned int cnts = 1;
+// race timeout, or end of the backoff
+void QIec104::connectTimeout() {
+  if (mEnding || mConnected)
+    return;
+  if (mRacing[0] || mRacing[1]) {
+    mLog.pushMsg("!!!!!CONNECT TIMEOUT!");
+    abortRace();
+    scheduleConnect();
+    return;
+  }
+  if (!mAllowConnect) {
+    armTimer(tmConnect, int64_t(mBackoffMin * 1000));
+    return;
+  }
+  mLog.pushMsg("!!!!!TRY TO CONNECT!");
+  connectTCP();
+}
 
-  if (!mEnding) {
-    cnts++;
+void QIec104::statsTimeout() {
+  emit signal_stats(getStats());
+  armTimer(tmStats, int64_t(mStatsPeriod) * 1000);
+}
 
-    if (!(cnts % 5))
-      if (tcps->state() != QAbstractSocket::ConnectedState && mAllowConnect) {
-        mLog.pushMsg("!!!!!TRY TO CONNECT!");
-        connectTCP();
-      }
+void QIec104::soeFlushTimeout() {
+  mSOE.flush();
+  armTimer(tmSOEFlush, int64_t(mSOEFlush) * 1000);
+}
 
-    onTimerSecond();
-  }
+void QIec104::cancelTimers() {
+  timerWheel()->cancel(tmConnect);
+  timerWheel()->cancel(tmStats);
+  timerWheel()->cancel(tmSOEFlush);
+  stopTimers();
 }
 
 void QIec104::interrogationActConfIndication() {
+  flushBatch();
   emit signal_interrogationActConfIndication();
 }
 
 void QIec104::interrogationActTermIndication() {
+  flushBatch();
   emit signal_interrogationActTermIndication();
 }
 
 void QIec104::commandActRespIndication(iec_obj *obj) {
-  emit signal_commandActRespIndication(obj);
+  if (mThreaded) {
+    flushBatch();
+    emit signal_commandActResp(*obj);
+  } else {
+    emit signal_commandActRespIndication(obj);
+  }
 }
 
 void QIec104::terminate() {
   mEnding = true;
-  tcps->close();
-  //tcpThread.quit();
-  //tcpThread.wait(1000);
-  //if (tcpThread.isRunning())
-  //  tcpThread.terminate();
-  //if (tcpThread.isRunning())
-  //  tcpThread.wait(2000);
+  mLinkActive = false;
+  QThread *mainThread = QCoreApplication::instance()->thread();
+  if (thread() != mainThread && thread()->isRunning()) {
+    // stop on the protocol thread and bring the objects back before it ends
+    QMetaObject::invokeMethod(this, [this, mainThread] {
+        cancelTimers();
+        tmReplay->stop();
+        setCapture(nullptr);
+        mCapture.close();
+        mSOE.flush();
+        closeSockets();
+        moveToThread(mainThread);
+      }, Qt::BlockingQueuedConnection);
+  } else {
+    cancelTimers();
+    tmReplay->stop();
+    setCapture(nullptr);
+    mCapture.close();
+    mSOE.flush();
+    closeSockets();
+  }
+  if (mOwnThread != nullptr && mOwnThread->isRunning()) {
+    mOwnThread->quit();
+    mOwnThread->wait();
+  }
 }
 
 void QIec104::slot_tcpreadytoread() {
-  if (tcps->bytesAvailable() < 6)
-    tcps->waitForReadyRead(8);
-
   packetReadyTCP();
+  flushBatch();
 }
 
 void QIec104::disable_connect() {
-  mAllowConnect = false;
-  if (tcps->state() == QAbstractSocket::ConnectedState)
+  runOnIOThread([this] {
+    mAllowConnect = false;
+    abortRace();
     disconnectTCP();
+  });
 }
 
-void QIec104::enable_connect() { mAllowConnect = true; }
+void QIec104::enable_connect() {
+  runOnIOThread([this] {
+    mAllowConnect = true;
+    // connect now if waiting
+    if (mLinkActive && !mConnected && !mRacing[0] && !mRacing[1] &&
+        tmConnect.armed())
+      armTimer(tmConnect, 0);
+  });
+}
 
 int QIec104::bytesAvailableTCP() { return int(tcps->bytesAvailable()); }
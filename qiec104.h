@@ -30,11 +30,37 @@
 #ifndef QIEC104_H
 #define QIEC104_H
 
+#include <QElapsedTimer>
 #include <QObject>
+#include <QMutex>
 #include <QThread>
 #include <QTimer>
+#include <QVector>
 #include <QtNetwork/QTcpSocket>
+#include <atomic>
+#include <random>
 #include <iec104_class.h>
+#include <iec104_cmdtrack.h>
+#include <iec104_deadband.h>
+#include <iec104_pointcache.h>
+#include <iec104_soe.h>
+
+Q_DECLARE_METATYPE(iec_obj)
+Q_DECLARE_METATYPE(iec104_stats)
+
+// timer wheel of the sessions of one thread, woken by one precise timer at its
+// next deadline. It must live on the thread of its sessions (moveToThread).
+class QIec104Timers : public QObject {
+public:
+  explicit QIec104Timers(QObject *parent = nullptr);
+  iec104_timerwheel wheel;
+  void stop() { tm->stop(); } // on its thread, the sessions stopped
+
+private:
+  QTimer *tm;
+  void wake(int64_t deadline_ms); // start tm if the deadline is sooner
+  void expire();
+};
 
 class QIec104 : public QObject, public iec104_class {
   Q_OBJECT
@@ -45,46 +71,164 @@ public:
   int SendCommands;    // 1 = allow sending commands, 0 = don't send commands
   int ForcePrimary;    // 1 = force primary (cant't stay secondary) , 0 = can be
                        // secondary
-  QTimer *tmKeepAlive; // 1 second timer
-  QTcpSocket *tcps;    // socket for iec104 (tcp)
+  QTcpSocket *tcps;    // socket of the link (iec104 tcp), main or backup
   void terminate();
   void disable_connect();
   void enable_connect();
 
+  // threaded mode: protocol engine, socket and timer run on their own thread,
+  // call before starting the link. The signals below are then queued, and the
+  // requests are run on the protocol thread.
+  // ioThread: run on this (shared, started) thread instead of an own thread.
+  void startIOThread(QThread *ioThread = nullptr);
+  bool isThreaded() { return mThreaded; }
+  // run the timers on the wheel of the sessions of the thread (concentrator),
+  // instead of an own one. Call before starting the link.
+  void setTimers(QIec104Timers *timers) { setTimerWheel(&timers->wheel); }
+
+  // requests, safe to call from any thread
+  // connects, racing the main and the backup RTU: both are connected at
+  // once, the first to confirm STARTDT is the link and the other is dropped.
+  // After a failure the next race waits a backoff, doubled each failure from
+  // minSeconds up to maxSeconds (less up to a half, random), see setReconnect
+  void startLink();
+  void stopLink(); // stop the timers and disconnect
+  void setReconnect(double minSeconds, double maxSeconds); // default 1, 30
+  bool isLinkActive() { return mLinkActive; }
+  void requestGI();
+  void requestInterrogation(int group);
+  void requestCommand(const iec_obj &obj);
+  void requestCommands(const QVector<iec_obj> &objs); // sent in one write
+  void requestSecondaryASDUAddress(int addr);
+  void logMsg(const char *msg);
+  // signal_stats every seconds (0: never, the default), call before starting the link
+  void setStatsPeriod(unsigned seconds) { mStatsPeriod = seconds; }
+  void requestClearStats();
+  QString peerAddress();
+  // binary capture of the frames of the link, mbytes preallocated
+  bool startCapture(const QString &path, unsigned mbytes);
+  void stopCapture();
+  // feed the received frames of a capture to the protocol engine instead of a
+  // link (do not start the link), speed: 1 original timing, N N times faster,
+  // 0 as fast as possible
+  bool startReplay(const QString &path, double speed);
+  // last values of the points kept in a file, call before starting the link.
+  // staleSeconds: see setPointCache
+  bool openPointCache(const QString &path, unsigned capacity, unsigned staleSeconds);
+  // the last values, any thread, as signal_dataBatch: runs of points of one type
+  void cachedPoints(QVector<iec_obj> &objs, QVector<unsigned> &sizes);
+  // hot standby: the records of the cache (primary), records of the primary
+  // to the cache (secondary), any thread
+  void cachedRecords(std::vector<pointcache_rec> &recs);
+  void replicateRecords(const QVector<pointcache_rec> &recs);
+  // history of the time tagged points in this directory, the pending events
+  // are written every flushSeconds. Call before starting the link.
+  bool openSOE(const QString &dir, unsigned flushSeconds);
+  void flushSOE(); // the events received are in the files when it returns
+  // change filter of the measured values signaled (the table, I104M), see
+  // iec104_deadband, all 0: off. Call before starting the link.
+  void setChangeFilter(double absolute, double percent, bool cyclicChanged);
+  // commands in flight: a command without ACTCON in timeoutSeconds (0: never) expires,
+  // sboExecute: the confirmed selects are executed here (not by the user).
+  // Call before starting the link.
+  void setCommandTracking(double timeoutSeconds, bool sboExecute);
+  // hot standby primary: signal_cacheIndication (signal_cacheBatch) with the
+  // points recorded by the point cache, not thinned by the change filter, so
+  // that the replica ages as the cache. Call before starting the link.
+  void setCacheReplication(bool on) { mReplicate = on; }
+
 signals:
+  // obj is the decoder arena, valid only during the (direct connected) slot call
+  // (not threaded mode)
   void signal_dataIndication(iec_obj *obj, unsigned numpoints);
+  // threaded mode: points of all the asdus of one tcp read, sizes has the
+  // number of points of each asdu (each asdu has objects of one type)
+  void signal_dataBatch(QVector<iec_obj> objs, QVector<unsigned> sizes);
+  // see setCacheReplication, as signal_dataIndication / signal_dataBatch
+  void signal_cacheIndication(iec_obj *obj, unsigned numpoints);
+  void signal_cacheBatch(QVector<iec_obj> objs);
   void signal_interrogationActConfIndication();
   void signal_interrogationActTermIndication();
   void signal_tcp_connect();
   void signal_tcp_disconnect();
   void signal_commandActRespIndication(iec_obj *obj);
+  // threaded mode: copy of the command response
+  void signal_commandActResp(iec_obj obj);
+  // copy of the link statistics, from the protocol thread every stats period
+  void signal_stats(iec104_stats stats);
+  void signal_replayEnd();
 
 public slots:
   void slot_tcpdisconnect(); // tcp disconnect for iec104
 
 private slots:
-  void slot_tcpconnect();     // tcp connect for iec104
+  void slot_tcpconnect();     // link up (STARTDT confirmed) for iec104
   void slot_tcpreadytoread(); // ready to read data on iec104 tcp socket
   void
   slot_tcperror(QAbstractSocket::SocketError socketError); // show errors of tcp
-  void slot_keep_alive();
+  void slot_replay();
 
 private:
-  // QThread tcpThread;
+  QThread *mOwnThread; // threaded mode without a shared thread
+  bool mThreaded;
+  std::atomic<bool> mLinkActive;
+  QVector<iec_obj> mBatch; // threaded mode: points waiting to be sent to the ui
+  QVector<unsigned> mBatchSizes;
+  bool mReplicate;
+  QVector<iec_obj> mCacheBatch; // threaded mode: points to replicate
+  void flushBatch();
+  QMutex mPeerLock;
+  QString mPeer;
+  template <class F> void runOnIOThread(F f);
 
   // redefine for iec104_class
-  void waitBytes(int bytes, int msTout);
   int bytesAvailableTCP();
   void connectTCP();
   void disconnectTCP();
   int readTCP(char *buf, int szmax);
   void sendTCP(char *data, int sz);
+  void txReadyTCP();
   void interrogationActConfIndication();
   void interrogationActTermIndication();
   void commandActRespIndication(iec_obj *obj);
   void dataIndication(iec_obj *obj, unsigned numpoints);
-  bool mEnding;
+  void cacheIndication(iec_obj *obj, unsigned numpoints);
+  std::atomic<bool> mEnding;
   bool mAllowConnect;
+  unsigned mStatsPeriod;
+  QIec104Timers *mOwnTimers;
+  // connect racing, socket 0: main RTU, 1: backup RTU
+  QTcpSocket *mSock[2];
+  bool mRacing[2];      // connecting or waiting STARTDTCON
+  bool mConnected;      // tcps is the link
+  unsigned mBackoffCnt; // failed races since the last link
+  double mBackoffMin, mBackoffMax; // seconds
+  std::minstd_rand mRng;           // backoff jitter
+  void raceFrames(int i); // frames received before STARTDTCON
+  void raceFailed(int i);
+  void raceWon(int i);
+  void abortRace();
+  void scheduleConnect(); // next race after the backoff
+  void closeSockets();
+  iec104_timer tmConnect{[this] { connectTimeout(); }};   // backoff, race timeout
+  iec104_timer tmStats{[this] { statsTimeout(); }};       // signal_stats
+  iec104_timer tmSOEFlush{[this] { soeFlushTimeout(); }}; // write the pending SOE
+  void armTimer(iec104_timer &t, int64_t ms) { timerWheel()->arm(t, monoMs() + ms); }
+  void connectTimeout();
+  void statsTimeout();
+  void soeFlushTimeout();
+  void cancelTimers(); // of the link and of the protocol
+  iec104_capture_writer mCapture;
+  iec104_capture_reader mReplay;
+  iec104_pointcache mPointCache;
+  iec104_soe_writer mSOE;
+  iec104_deadband mDeadband;
+  iec104_cmdtracker mCmdTrack;
+  unsigned mSOEFlush;
+  QTimer *tmReplay;
+  QElapsedTimer mReplayClock;
+  double mReplaySpeed;
+  uint64_t mReplayT0; // time of the first frame of the capture
 };
 
 #endif // QIEC104_H
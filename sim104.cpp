@@ -0,0 +1,62 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+
+// QTester104sim: IEC 60870-5-104 slave simulator / load generator, the
+// reference benchmark for the master. Configured by the [SIMULATOR] section.
+// usage: QTester104sim [ini file]
+
+#include <QCoreApplication>
+#include <QFile>
+#include <stdio.h>
+#include "simulator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QString ininame = QCoreApplication::applicationDirPath() + "/qtester104.ini";
+    if (argc > 1)
+        ininame = QString(argv[1]);
+    else if (!QFile(ininame).exists())
+        ininame = "../conf/qtester104.ini";
+
+    SimConfig cfg;
+    if (!cfg.load(ininame)) {
+        fprintf(stderr, "No points or types to generate in [SIMULATOR]!\n");
+        return 1;
+    }
+    Simulator sim(cfg);
+    if (!sim.listen()) {
+        fprintf(stderr, "Can't listen on TCP port %u!\n", cfg.port);
+        return 1;
+    }
+    return a.exec();
+}
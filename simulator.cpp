@@ -0,0 +1,440 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "simulator.h"
+#include "iec104_gen.h"
+#include <QSettings>
+#include <QStringList>
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// control fields and causes used by the slave
+const uint16_t STARTDTACT = 0x07;
+const uint16_t STARTDTCON = 0x0B;
+const uint16_t STOPDTACT = 0x13;
+const uint16_t STOPDTCON = 0x23;
+const uint16_t TESTFRACT = 0x43;
+const uint16_t TESTFRCON = 0x83;
+const uint16_t SUPERVISORY = 0x01;
+const uint8_t START = 0x68;
+
+const unsigned SPONTANEOUS = 3;
+const unsigned ACTIVATION = 6;
+const unsigned ACTCONFIRM = 7;
+const unsigned ACTTERM = 10;
+const unsigned INROGEN = 20;      // interrogated by station interrogation
+const unsigned UNKNOWN_TYPE = 44; // unknown type identification
+
+const unsigned C_SC_NA_1 = 45;
+const unsigned C_BO_TA_1 = 64;
+const unsigned C_IC_NA_1 = 100;
+
+const unsigned ADDR_STRIDE = 100000; // point addresses: TI * ADDR_STRIDE + 1..
+
+QVector<unsigned> typeList(const QString &s) {
+  QVector<unsigned> types;
+  iec_apdu apdu;
+  for (const QString &t : s.split(',', Qt::SkipEmptyParts)) {
+    unsigned ti = t.trimmed().toUInt();
+    if (iec104_genASDU(apdu, ti, false, 1, 1, 0) > 0)
+      types.append(ti);
+    else
+      fprintf(stderr, "Type %u is not generated, ignored.\n", ti);
+  }
+  return types;
+}
+
+} // namespace
+
+bool SimConfig::load(const QString &ininame) {
+  QSettings settings(ininame, QSettings::IniFormat);
+  port = settings.value("SIMULATOR/TCP_PORT", port).toUInt();
+  ca = settings.value("SIMULATOR/ASDU_ADDRESS", ca).toUInt();
+  points = settings.value("SIMULATOR/POINTS", points).toUInt();
+  if (points > ADDR_STRIDE - 1)
+    points = ADDR_STRIDE - 1;
+  giTypes = typeList(settings.value("SIMULATOR/GI_TYPES", "1,3,13").toString());
+  eventTypes = typeList(settings.value("SIMULATOR/EVENT_TYPES", "30,36").toString());
+  eventRate = settings.value("SIMULATOR/EVENT_RATE", eventRate).toDouble();
+  pointsPerASDU = settings.value("SIMULATOR/POINTS_PER_ASDU", pointsPerASDU).toUInt();
+  sqMode = settings.value("SIMULATOR/SQ", sqMode).toUInt();
+  k = settings.value("SIMULATOR/K", k).toUInt();
+  w = settings.value("SIMULATOR/W", w).toUInt();
+  t1 = settings.value("SIMULATOR/T1", t1).toUInt();
+  t2 = settings.value("SIMULATOR/T2", t2).toUInt();
+  report = settings.value("SIMULATOR/REPORT", report).toUInt();
+  if (k < 1 || k > 32767)
+    k = 12;
+  if (w < 1 || w > k)
+    w = k;
+  return points > 0 && (!giTypes.isEmpty() || !eventTypes.isEmpty());
+}
+
+SimSession::SimSession(QTcpSocket *sock, const SimConfig &cfg, QObject *parent)
+    : QObject(parent), mCfg(cfg), mSock(sock), mSentAt(32768) {
+  mSock->setParent(this);
+  mSock->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+  mPeer = mSock->peerAddress().toString();
+  mStarted = false;
+  mVS = mVR = mAckVS = 0;
+  mRxUnack = 0;
+  mClock.start();
+  mLastRx = 0;
+  mOldestUnack = -1;
+  mGI = false;
+  mGIType = 0;
+  mGIAddr = 0;
+  mCredit = 0;
+  mLastGen = 0;
+  mEvType = mEvAddr = mEvValue = 0;
+  mSqToggle = 0;
+
+  mTick = new QTimer(this);
+  connect(mTick, SIGNAL(timeout()), this, SLOT(slot_tick()));
+  connect(mSock, SIGNAL(readyRead()), this, SLOT(slot_read()));
+  connect(mSock, SIGNAL(disconnected()), this, SLOT(slot_disconnected()));
+  mTick->start(10);
+}
+
+SimSession::Stats SimSession::takeStats() {
+  Stats s = mStats;
+  mStats = Stats();
+  return s;
+}
+
+void SimSession::slot_read() {
+  iec_apdu apdu;
+  int sz;
+
+  while (mSock->bytesAvailable() > 0 && mFramer.freeSpace() > 0) {
+    unsigned contig;
+    char *wp = mFramer.writePtr(contig);
+    qint64 n = mSock->read(wp, contig);
+    if (n <= 0)
+      break;
+    mFramer.commit(unsigned(n));
+
+    while ((sz = mFramer.nextAPDU(&apdu)) != 0) {
+      if (sz < 0)
+        continue;
+      parse(apdu, sz);
+      if (mSock->state() != QAbstractSocket::ConnectedState)
+        return;
+    }
+  }
+  pump();
+  flush();
+}
+
+void SimSession::slot_tick() {
+  qint64 now = mClock.elapsed();
+
+  // events owed since the last tick, at most one second of backlog
+  if (mStarted && mCfg.eventRate > 0 && !mCfg.eventTypes.isEmpty()) {
+    mCredit += mCfg.eventRate * double(now - mLastGen) / 1000;
+    if (mCredit > mCfg.eventRate)
+      mCredit = mCfg.eventRate;
+  }
+  mLastGen = now;
+
+  if (mRxUnack > 0 && now - mLastRx >= qint64(mCfg.t2) * 1000)
+    sendS();
+
+  if (mOldestUnack >= 0 && now - mOldestUnack >= qint64(mCfg.t1) * 1000) {
+    fprintf(stderr, "%s: T1 TIMEOUT, I-FRAMES NOT ACKNOWLEDGED BY THE MASTER\n",
+            mPeer.toLocal8Bit().constData());
+    mSock->abort();
+    return;
+  }
+
+  pump();
+  flush();
+}
+
+void SimSession::slot_disconnected() {
+  mTick->stop();
+  emit finished(this);
+}
+
+void SimSession::parse(iec_apdu &apdu, int sz) {
+  if (sz == 6) {
+    if ((apdu.NS & 0x03) == SUPERVISORY) {
+      ack(apdu.NR);
+      return;
+    }
+    switch (apdu.NS) {
+    case STARTDTACT:
+      mStarted = true;
+      mLastGen = mClock.elapsed();
+      sendU(STARTDTCON);
+      break;
+    case STOPDTACT:
+      mStarted = false;
+      sendS();
+      sendU(STOPDTCON);
+      break;
+    case TESTFRACT:
+      sendU(TESTFRCON);
+      break;
+    default:
+      break;
+    }
+    return;
+  }
+
+  if (apdu.NS & 0x01)
+    return; // not an I-frame
+  if (apdu.NS != mVR) {
+    fprintf(stderr, "%s: SEQUENCE ERROR\n", mPeer.toLocal8Bit().constData());
+    mSock->abort();
+    return;
+  }
+  mVR += 2;
+  if (mRxUnack++ == 0)
+    mLastRx = mClock.elapsed();
+  ack(apdu.NR);
+
+  if (apdu.asduh.cause == ACTIVATION) {
+    if (apdu.asduh.type == C_IC_NA_1) {
+      queueResponse(apdu, ACTCONFIRM);
+      mGIReq = apdu;
+      mGI = true;
+      mGIType = 0;
+      mGIAddr = 0;
+    } else if (apdu.asduh.type >= C_SC_NA_1 && apdu.asduh.type <= C_BO_TA_1) {
+      queueResponse(apdu, ACTCONFIRM);
+      queueResponse(apdu, ACTTERM);
+    } else if (apdu.asduh.type > C_BO_TA_1) {
+      queueResponse(apdu, ACTCONFIRM);
+    } else {
+      queueResponse(apdu, UNKNOWN_TYPE);
+    }
+  }
+
+  if (mRxUnack >= mCfg.w)
+    sendS();
+}
+
+void SimSession::ack(uint16_t nr) {
+  nr &= 0xFFFE;
+  if (uint16_t(nr - mAckVS) > uint16_t(mVS - mAckVS)) {
+    fprintf(stderr, "%s: NR SEQUENCE ERROR\n", mPeer.toLocal8Bit().constData());
+    mSock->abort();
+    return;
+  }
+  if (nr == mAckVS)
+    return;
+  qint64 now = mClock.nsecsElapsed();
+  for (uint16_t ns = mAckVS; ns != nr; ns += 2) {
+    double ms = double(now - mSentAt[ns >> 1]) / 1e6;
+    mStats.ackSumMs += ms;
+    if (ms > mStats.ackMaxMs)
+      mStats.ackMaxMs = ms;
+    mStats.acks++;
+  }
+  mAckVS = nr;
+  mOldestUnack = nr == mVS ? -1 : mClock.elapsed();
+}
+
+void SimSession::sendU(uint16_t ctrl) {
+  iec_apdu apdu;
+  apdu.start = START;
+  apdu.length = 4;
+  apdu.NS = ctrl;
+  apdu.NR = 0;
+  mOut.append(reinterpret_cast<const char *>(&apdu), 6);
+}
+
+void SimSession::sendS() {
+  iec_apdu apdu;
+  apdu.start = START;
+  apdu.length = 4;
+  apdu.NS = SUPERVISORY;
+  apdu.NR = mVR;
+  mOut.append(reinterpret_cast<const char *>(&apdu), 6);
+  mRxUnack = 0;
+}
+
+void SimSession::sendI(iec_apdu &apdu) {
+  apdu.start = START;
+  apdu.NS = mVS;
+  apdu.NR = mVR; // acknowledges the received I-frames
+  mOut.append(reinterpret_cast<const char *>(&apdu), apdu.length + 2);
+  mSentAt[mVS >> 1] = mClock.nsecsElapsed();
+  if (mOldestUnack < 0)
+    mOldestUnack = mClock.elapsed();
+  mVS += 2;
+  mRxUnack = 0;
+  mStats.apdus++;
+  if (apdu.asduh.type < C_SC_NA_1)
+    mStats.points += apdu.asduh.num;
+}
+
+void SimSession::queueResponse(const iec_apdu &req, unsigned cause) {
+  iec_apdu resp = req;
+  resp.asduh.cause = cause & 0x3F;
+  resp.asduh.pn = cause == UNKNOWN_TYPE;
+  mPending.append(QByteArray(reinterpret_cast<const char *>(&resp), resp.length + 2));
+}
+
+bool SimSession::windowOpen() {
+  return unsigned(uint16_t(mVS - mAckVS) >> 1) < mCfg.k;
+}
+
+bool SimSession::nextSQ() {
+  if (mCfg.sqMode < 2)
+    return mCfg.sqMode == 1;
+  return (mSqToggle++ & 1) != 0;
+}
+
+void SimSession::pump() {
+  iec_apdu apdu;
+  unsigned perASDU = mCfg.pointsPerASDU ? mCfg.pointsPerASDU : 127;
+
+  if (!mStarted || mSock->state() != QAbstractSocket::ConnectedState)
+    return;
+  iec104_genTime();
+
+  for (;;) {
+    bool events = !mCfg.eventTypes.isEmpty() && (mCfg.eventRate <= 0 || mCredit >= 1);
+    if (mPending.isEmpty() && !mGI && !events)
+      break;
+    if (!windowOpen()) {
+      mStats.stalls++;
+      break;
+    }
+
+    if (!mPending.isEmpty()) {
+      const QByteArray f = mPending.takeFirst();
+      memcpy(&apdu, f.constData(), size_t(f.size()));
+      sendI(apdu);
+      continue;
+    }
+
+    apdu.asduh.oa = 0;
+    apdu.asduh.ca = uint16_t(mCfg.ca);
+    apdu.asduh.pn = 0;
+    apdu.asduh.t = 0;
+
+    if (mGI) {
+      if (mGIType >= mCfg.giTypes.size()) {
+        mGI = false;
+        queueResponse(mGIReq, ACTTERM);
+        continue;
+      }
+      unsigned ti = mCfg.giTypes[mGIType];
+      unsigned left = mCfg.points - mGIAddr;
+      unsigned n = iec104_genASDU(apdu, ti, nextSQ(), ti * ADDR_STRIDE + 1 + mGIAddr,
+                              left < perASDU ? left : perASDU, mGIAddr);
+      apdu.asduh.cause = INROGEN;
+      sendI(apdu);
+      mGIAddr += n;
+      if (mGIAddr >= mCfg.points) {
+        mGIType++;
+        mGIAddr = 0;
+      }
+      continue;
+    }
+
+    // spontaneous events, the types in turn, addresses and values rotate
+    unsigned ti = mCfg.eventTypes[int(mEvType++ % unsigned(mCfg.eventTypes.size()))];
+    unsigned n = perASDU;
+    if (mCfg.eventRate > 0 && double(n) > mCredit)
+      n = unsigned(mCredit);
+    if (n > mCfg.points - mEvAddr)
+      n = mCfg.points - mEvAddr;
+    n = iec104_genASDU(apdu, ti, nextSQ(), ti * ADDR_STRIDE + 1 + mEvAddr, n, mEvValue);
+    apdu.asduh.cause = SPONTANEOUS;
+    sendI(apdu);
+    mEvValue += n;
+    mEvAddr = (mEvAddr + n) % mCfg.points;
+    if (mCfg.eventRate > 0)
+      mCredit -= n;
+  }
+}
+
+void SimSession::flush() {
+  if (!mOut.isEmpty()) {
+    mSock->write(mOut);
+    mOut.clear();
+  }
+}
+
+Simulator::Simulator(const SimConfig &cfg, QObject *parent)
+    : QObject(parent), mCfg(cfg) {
+  mServer = new QTcpServer(this);
+  connect(mServer, SIGNAL(newConnection()), this, SLOT(slot_newConnection()));
+  mReport = new QTimer(this);
+  connect(mReport, SIGNAL(timeout()), this, SLOT(slot_report()));
+}
+
+bool Simulator::listen() {
+  if (!mServer->listen(QHostAddress::Any, quint16(mCfg.port)))
+    return false;
+  printf("SIMULATOR: PORT %u, CA %u, %u POINTS PER TYPE, EVENTS %s/s, K=%u W=%u\n",
+         mCfg.port, mCfg.ca, mCfg.points,
+         mCfg.eventRate > 0 ? QByteArray::number(mCfg.eventRate).constData() : "max",
+         mCfg.k, mCfg.w);
+  fflush(stdout);
+  if (mCfg.report > 0)
+    mReport->start(int(mCfg.report) * 1000);
+  mReportTime.start();
+  return true;
+}
+
+void Simulator::slot_newConnection() {
+  while (QTcpSocket *sock = mServer->nextPendingConnection()) {
+    SimSession *s = new SimSession(sock, mCfg, this);
+    printf("%s: CONNECTED\n", s->peer().toLocal8Bit().constData());
+    connect(s, &SimSession::finished, this, [this](SimSession *fs) {
+      printf("%s: DISCONNECTED\n", fs->peer().toLocal8Bit().constData());
+      mSessions.removeOne(fs);
+      fs->deleteLater();
+    });
+    mSessions.append(s);
+  }
+}
+
+void Simulator::slot_report() {
+  double secs = double(mReportTime.restart()) / 1000;
+  if (secs <= 0)
+    return;
+  for (SimSession *s : mSessions) {
+    SimSession::Stats st = s->takeStats();
+    printf("%s: %.0f APDU/s %.0f POINTS/s, ACK LATENCY AVG %.2f MAX %.2f ms, "
+           "%llu WINDOW STALLS\n",
+           s->peer().toLocal8Bit().constData(), double(st.apdus) / secs,
+           double(st.points) / secs, st.acks ? st.ackSumMs / double(st.acks) : 0.0,
+           st.ackMaxMs, static_cast<unsigned long long>(st.stalls));
+  }
+  fflush(stdout);
+}
@@ -0,0 +1,152 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+
+// IEC 60870-5-104 slave simulator and load generator, for benchmarking the
+// master (parser, log, user interface) without real RTUs.
+// Answers the GI with POINTS points of each of GI_TYPES, generates spontaneous
+// events of EVENT_TYPES at EVENT_RATE points/s inside the k/w window, answers
+// commands, and reports the APDUs/s, points/s and the ack latency (from an
+// I-frame sent to the NR of the master that acknowledges it).
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QVector>
+#include <vector>
+#include <stdint.h>
+#include "iec104_framer.h"
+
+struct SimConfig {
+  unsigned port = 2404;
+  unsigned ca = 1;              // common address of the asdus
+  unsigned points = 1000;       // points of each type, addresses TI*100000+1..
+  QVector<unsigned> giTypes;    // types answered in the GI
+  QVector<unsigned> eventTypes; // types of the spontaneous events
+  double eventRate = 0;         // event points/s, 0: as fast as the window allows
+  unsigned pointsPerASDU = 0;   // 0: as many as fit in an apdu
+  unsigned sqMode = 0;          // 0: SQ=0, 1: SQ=1, 2: alternate
+  unsigned k = 12;              // max I-frames sent not acknowledged
+  unsigned w = 8;               // acknowledge after w received I-frames
+  unsigned t1 = 15;             // seconds to wait for an acknowledge
+  unsigned t2 = 10;             // seconds to acknowledge received I-frames
+  unsigned report = 5;          // seconds between reports (0: no reports)
+  bool load(const QString &ininame); // [SIMULATOR] section
+};
+
+// one master connection
+class SimSession : public QObject {
+  Q_OBJECT
+
+public:
+  SimSession(QTcpSocket *sock, const SimConfig &cfg, QObject *parent = nullptr);
+  struct Stats {
+    uint64_t apdus = 0;   // I-frames sent
+    uint64_t points = 0;  // information objects sent
+    uint64_t acks = 0;    // I-frames acknowledged
+    double ackSumMs = 0;  // ack latency of the acknowledged frames
+    double ackMaxMs = 0;
+    uint64_t stalls = 0;  // times the k window stopped the generator
+  };
+  Stats takeStats(); // since the last call
+  QString peer() const { return mPeer; }
+
+signals:
+  void finished(SimSession *s);
+
+private slots:
+  void slot_read();
+  void slot_tick();
+  void slot_disconnected();
+
+private:
+  const SimConfig &mCfg;
+  QTcpSocket *mSock;
+  QTimer *mTick;
+  QString mPeer;
+  iec104_framer mFramer;
+  QByteArray mOut; // frames of this event loop turn, one write
+  bool mStarted;   // STARTDT received
+  uint16_t mVS, mVR, mAckVS;
+  unsigned mRxUnack;
+  QElapsedTimer mClock;
+  qint64 mLastRx;         // ms, last I-frame received not acknowledged
+  qint64 mOldestUnack;    // ms, oldest frame sent not acknowledged (-1: none)
+  std::vector<qint64> mSentAt; // ns, send time of each NS (indexed by NS>>1)
+  QVector<QByteArray> mPending; // responses (ASDUs) waiting for the window
+  // general interrogation in progress
+  bool mGI;
+  iec_apdu mGIReq;  // the C_IC_NA_1 activation, for the ACTTERM
+  int mGIType;      // index in giTypes
+  unsigned mGIAddr; // next point
+  // spontaneous events
+  double mCredit; // event points owed
+  qint64 mLastGen;
+  unsigned mEvType, mEvAddr, mEvValue;
+  unsigned mSqToggle;
+  Stats mStats;
+
+  void parse(iec_apdu &apdu, int sz);
+  void ack(uint16_t nr);
+  void sendU(uint16_t ctrl);
+  void sendS();
+  void sendI(iec_apdu &apdu);
+  void queueResponse(const iec_apdu &req, unsigned cause);
+  bool windowOpen();
+  void pump(); // send what the window allows
+  void flush();
+  bool nextSQ();
+};
+
+class Simulator : public QObject {
+  Q_OBJECT
+
+public:
+  explicit Simulator(const SimConfig &cfg, QObject *parent = nullptr);
+  bool listen();
+
+private slots:
+  void slot_newConnection();
+  void slot_report();
+
+private:
+  SimConfig mCfg;
+  QTcpServer *mServer;
+  QTimer *mReport;
+  QElapsedTimer mReportTime;
+  QVector<SimSession *> mSessions;
+};
+
+#endif // SIMULATOR_H
@@ -0,0 +1,73 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#include "statsexport.h"
+#include <QDateTime>
+#include <QSettings>
+#include <stdio.h>
+
+StatsExporter::StatsExporter() {
+  mUdps = nullptr;
+  mPort = 0;
+}
+
+StatsExporter::~StatsExporter() { delete mUdps; }
+
+unsigned StatsExporter::configure(QSettings &settings) {
+  unsigned period = settings.value("STATS/PERIOD", 5).toUInt();
+
+  QString fname = settings.value("STATS/FILE", "").toString();
+  if (fname != "") {
+    mFile.setFileName(fname);
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+      fprintf(stderr, "Can't open statistics file %s!\n", fname.toLocal8Bit().constData());
+  }
+
+  QString host = settings.value("STATS/UDP_HOST", "").toString();
+  mPort = quint16(settings.value("STATS/UDP_PORT", 8097).toUInt());
+  if (host != "" && mHost.setAddress(host))
+    mUdps = new QUdpSocket();
+
+  return period;
+}
+
+void StatsExporter::write(const QString &name, const iec104_stats &stats) {
+  if (!enabled())
+    return;
+  QByteArray line = QDateTime::currentDateTime().toString(Qt::ISODateWithMs).toLatin1() +
+                    ' ' + name.toLatin1() + ' ' + QByteArray(stats.line().c_str());
+  if (mUdps != nullptr)
+    mUdps->writeDatagram(line, mHost, mPort);
+  if (mFile.isOpen()) {
+    line += '\n';
+    mFile.write(line);
+    mFile.flush();
+  }
+}
@@ -0,0 +1,62 @@
+/*
+ * This software implements an IEC 60870-5-104 protocol tester.
+ * Copyright © 2010-2024 Ricardo L. Olsen
+ *
+ * Disclaimer
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR
+ * THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the
+ * Free Software Foundation, Inc.,
+ * 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+ */
+
+
+#ifndef STATSEXPORT_H
+#define STATSEXPORT_H
+
+// Export of the link statistics: one line per link and period, appended to a
+// file and/or sent as an UDP datagram. Use it from the thread that created it.
+
+#include <QFile>
+#include <QString>
+#include <QtNetwork/QHostAddress>
+#include <QtNetwork/QUdpSocket>
+#include "iec104_stats.h"
+
+class QSettings;
+
+class StatsExporter {
+public:
+  StatsExporter();
+  ~StatsExporter();
+  // [STATS] PERIOD, FILE, UDP_HOST, UDP_PORT, returns the period (seconds, 0: off)
+  unsigned configure(QSettings &settings);
+  bool enabled() const { return mFile.isOpen() || mUdps != nullptr; }
+  // "<date time> <name> <key=value ...>"
+  void write(const QString &name, const iec104_stats &stats);
+
+private:
+  QFile mFile;
+  QUdpSocket *mUdps;
+  QHostAddress mHost;
+  quint16 mPort;
+};
+
+#endif // STATSEXPORT_H